@@ -1,6 +1,11 @@
 import os
 from pathlib import Path
+from concurrent.futures import ProcessPoolExecutor
+import argparse
+import hashlib
 import json
+import math
+import tempfile
 
 # convert string to 4 chars
 def fourcc(s: str) -> int:
@@ -46,12 +51,643 @@ def build_sound_header(bit_depth: int, sample_rate: int, original_size: int, com
 
     return bytes(header)
 
+# .snd v2 container: header, table of contents, then payloads in table order
+SND_MAGIC = fourcc("PSND")
+SND_VERSION = 2
+SND_HEADER_SIZE = 20
+SND_ENTRY_SIZE = 20
+SND_LOOP_ENTRY_SIZE = 24
+SND_HASH_ENTRY_SIZE = 28
+
+# must match Pcm::HashName() (32-bit FNV-1a of the upper case name)
+def name_hash(name: str) -> int:
+    h = 2166136261
+    for c in name.upper().encode("ascii"):
+        h = ((h ^ c) * 16777619) & 0xFFFFFFFF
+    return h
+
+# must match SndEntry::contentHash (32-bit FNV-1a of the PCM data as it is stored in sound RAM), 0 means no hash
+def sample_hash(data: bytes) -> int:
+    h = 2166136261
+    for c in data:
+        h = ((h ^ c) * 16777619) & 0xFFFFFFFF
+    return h if h != 0 else 1
+
+# samples are placed at 4 byte aligned addresses in sound RAM
+def align4(size: int) -> int:
+    return (size + 3) & ~3
+
+# loop points in samples from SOUND.json ("LoopStart", "LoopEnd"), (0, 0) plays the whole sample
+def loop_points(snd_name: str, pcm_name: str, info, bit_depth: int, original_size: int):
+    samples = original_size if bit_depth == 1 else original_size >> 1
+    loop_start = int(info.get("LoopStart", 0))
+    loop_end = int(info.get("LoopEnd", 0))
+
+    if not 0 <= loop_end <= min(samples, 0xFFFF) or not 0 <= loop_start < (loop_end if loop_end != 0 else samples):
+        raise ValueError(f"{snd_name}: {pcm_name} loop {loop_start}-{loop_end} is outside of its {samples} samples")
+    if loop_end == samples:
+        loop_end = 0
+
+    return loop_start, loop_end
+
+# entries with the same data share one payload in the file and one copy in sound RAM, returns index of the first copy per entry
+def first_copies(entries):
+    seen = {}
+    return [seen.setdefault((e[8], e[3], e[1]), index) for index, e in enumerate(entries)]
+
+# sound RAM needed by a bank, data used by several entries counts once
+def bank_sound_ram(entries) -> int:
+    return sum(align4(e[3]) for index, (e, first) in enumerate(zip(entries, first_copies(entries))) if first == index)
+
+# entries: list of (name, bit_depth, sample_rate, original_size, compressed_size, payload, loop_start, loop_end, content_hash)
+def build_snd_v2(entries) -> bytes:
+    count = len(entries)
+    size = SND_HASH_ENTRY_SIZE
+    payload_offset = SND_HEADER_SIZE + count * size
+    sound_ram = bank_sound_ram(entries)
+    firsts = first_copies(entries)
+
+    out = bytearray()
+    out += SND_MAGIC.to_bytes(4, "big")
+    out += SND_VERSION.to_bytes(2, "big")
+    out += count.to_bytes(2, "big")
+    out += size.to_bytes(2, "big")
+    out += (0).to_bytes(2, "big")
+    out += sound_ram.to_bytes(4, "big")
+    out += payload_offset.to_bytes(4, "big")
+
+    offset = payload_offset
+    offsets = []
+    for index, (name, bit_depth, sample_rate, original_size, compressed_size, payload, loop_start, loop_end, content_hash) in enumerate(entries):
+        offsets.append(offsets[firsts[index]] if firsts[index] != index else offset)
+        out += name_hash(name).to_bytes(4, "big")
+        out += offsets[index].to_bytes(4, "big")
+        out += compressed_size.to_bytes(4, "big")
+        out += original_size.to_bytes(4, "big")
+        out += sample_rate.to_bytes(2, "big")
+        out += bit_depth.to_bytes(1, "big")
+        out += (0).to_bytes(1, "big")
+        out += loop_start.to_bytes(2, "big")
+        out += loop_end.to_bytes(2, "big")
+        out += content_hash.to_bytes(4, "big")
+        if firsts[index] == index:
+            offset += len(payload)
+
+    for index, entry in enumerate(entries):
+        if firsts[index] == index:
+            out += entry[5]
+
+    return bytes(out)
+
+# control slot values, must match ConvertBitrateToPitchWord() and CalculateBytesPerBlank() in ponesound.hpp
+SCSP_FREQUENCY = 44100
+FRAMES_PER_SECOND = 60
+SOUND_RAM_BUDGET = 0x7F800 - (0x408 + 47 * 1024 + 0x20)
+
+def pitch_word(sample_rate: int) -> int:
+    octave = (SCSP_FREQUENCY // (sample_rate + 1)).bit_length()
+    shift = SCSP_FREQUENCY >> octave
+    fns = int(((sample_rate - shift) << 10) / shift)
+    return (((-octave) & 0xF) << 11) | (fns & 0x3FF)
+
+def bytes_per_blank(sample_rate: int, bit_depth: int) -> int:
+    return ((sample_rate * (8 if bit_depth == 1 else 16)) >> 3) // FRAMES_PER_SECOND
+
+# C++ identifier from a file name, "MEOW1.PCM" -> "MEOW1", "CAT.SND" -> "CAT_SND"
+def identifier(name: str, keep_extension: bool = False) -> str:
+    if not keep_extension:
+        name = name.rsplit(".", 1)[0]
+    ident = "".join(c if c.isalnum() else "_" for c in name.upper())
+    return "_" + ident if ident[:1].isdigit() else ident
+
+# constexpr manifest for Pcm::LoadBank(), entries as passed to build_snd_v2()
+def build_bank_header(snd_name: str, entries) -> str:
+    bank = identifier(snd_name, True)
+    offset = SND_HEADER_SIZE + len(entries) * SND_HASH_ENTRY_SIZE
+    sound_ram = 0
+    samples = []
+    placed = []
+    firsts = first_copies(entries)
+
+    for index, (name, bit_depth, sample_rate, original_size, compressed_size, payload, loop_start, loop_end, content_hash) in enumerate(entries):
+        if not 197 <= sample_rate <= SCSP_FREQUENCY:
+            raise ValueError(f"{snd_name}: {name} sample rate {sample_rate} is outside of what the driver can play")
+        if original_size > (0x10000 if bit_depth == 1 else 0x20000):
+            raise ValueError(f"{snd_name}: {name} is too long for one control slot")
+
+        # a repeated sample points at the first copy in the file and in sound RAM
+        placed.append(placed[firsts[index]] if firsts[index] != index else (offset, sound_ram))
+        play_size = original_size if bit_depth == 1 else original_size >> 1
+        samples.append(f"            {{ 0x{name_hash(name):08X}, {placed[index][0]}, {compressed_size}, {original_size}, {placed[index][1]}, "
+                       f"{sample_rate}, 0x{pitch_word(sample_rate):04X}, {bytes_per_blank(sample_rate, bit_depth)}, {play_size}, {bit_depth}, "
+                       f"{loop_start}, {loop_end}, 0x{content_hash:08X} }}, // {name}")
+        if firsts[index] == index:
+            offset += len(payload)
+            sound_ram += align4(original_size)
+
+    lines = [
+        f"// Generated by PcmCompress.py from SOUND.json, do not edit",
+        f"#pragma once",
+        f"#include <ponesound.hpp>",
+        f"",
+        f"namespace Banks",
+        f"{{",
+        f"    /** @brief Sound bank {snd_name}",
+        f"     */",
+        f"    struct {bank}",
+        f"    {{",
+        f"        /** @brief Index of each sample in the array passed to Pcm::LoadBank()",
+        f"         */",
+        f"        enum Sample : int16_t",
+        f"        {{",
+    ]
+    lines += [f"            {identifier(e[0])} = {index}," for index, e in enumerate(entries)]
+    lines += [
+        f"        }};",
+        f"",
+        f"        static constexpr int16_t Count = {len(entries)};",
+        f"        static constexpr uint32_t SoundRamSize = {sound_ram};",
+        f"",
+        f"        static constexpr SRL::Ponesound::BankManifest::Sample Samples[Count] =",
+        f"        {{",
+    ]
+    lines += samples
+    lines += [
+        f"        }};",
+        f"",
+        f"        static constexpr SRL::Ponesound::BankManifest Manifest = {{ \"{snd_name}\", Samples, Count, SoundRamSize }};",
+        f"    }};",
+        f"",
+        f"    static_assert({bank}::SoundRamSize <= SRL::Ponesound::BankManifest::MAX_SOUND_RAM, \"{snd_name} does not fit in sound RAM\");",
+        f"    static_assert({bank}::Count <= SRL::Ponesound::BankManifest::MAX_SAMPLES, \"{snd_name} has more samples than control slots\");",
+        f"}}",
+        f"",
+    ]
+
+    if sound_ram > SOUND_RAM_BUDGET:
+        print(f"  warning: {snd_name} needs {sound_ram} bytes of sound RAM, only {SOUND_RAM_BUDGET} are available")
+
+    return "\n".join(lines)
+
+# sound archive (.pak): header, directory, then every entry on its own run of whole sectors in load order
+PACK_MAGIC = fourcc("PPAK")
+PACK_VERSION = 1
+PACK_FILE = "AUDIO.PAK"
+PACK_HEADER_SIZE = 16
+PACK_NAME_SIZE = 36
+PACK_ENTRY_SIZE = 12 + PACK_NAME_SIZE
+PACK_MAX_ENTRIES = 128  # must match MAX_PACK_ENTRIES in ponesound.hpp
+SECTOR_SIZE = 2048
+
+def sectors(size: int) -> int:
+    return (size + SECTOR_SIZE - 1) // SECTOR_SIZE
+
+# files: list of (name, data) in load order, names are found by Pcm::HashName() so they must not collide
+def build_pack(files) -> bytes:
+    if len(files) > PACK_MAX_ENTRIES:
+        raise ValueError(f"{len(files)} pack entries, the runtime takes at most {PACK_MAX_ENTRIES}")
+
+    names = {}
+    for name, data in files:
+        if len(name.encode("ascii")) >= PACK_NAME_SIZE:
+            raise ValueError(f"pack entry name longer than {PACK_NAME_SIZE - 1} characters: '{name}'")
+        if name_hash(name) in names:
+            raise ValueError(f"pack entry names hash the same: '{names[name_hash(name)]}' and '{name}'")
+        names[name_hash(name)] = name
+
+    data_sector = sectors(PACK_HEADER_SIZE + len(files) * PACK_ENTRY_SIZE)
+
+    out = bytearray()
+    out += PACK_MAGIC.to_bytes(4, "big")
+    out += PACK_VERSION.to_bytes(2, "big")
+    out += PACK_ENTRY_SIZE.to_bytes(2, "big")
+    out += len(files).to_bytes(4, "big")
+    out += data_sector.to_bytes(4, "big")
+
+    sector = data_sector
+    for name, data in files:
+        out += name_hash(name).to_bytes(4, "big")
+        out += sector.to_bytes(4, "big")
+        out += len(data).to_bytes(4, "big")
+        out += name.encode("ascii").ljust(PACK_NAME_SIZE, b"\0")
+        sector += sectors(len(data))
+
+    out = out.ljust(data_sector * SECTOR_SIZE, b"\0")
+    for name, data in files:
+        out += data.ljust(sectors(len(data)) * SECTOR_SIZE, b"\0")
+
+    return bytes(out)
+
+# entries of the archive in load order: "Pack" from SOUND.json lists bank names, file paths relative to the assets folder
+# and {"Name": name, "File": path} for a name other than the file name, banks it does not list follow in SOUND.json order
+def pack_files(pack_list, bank_names, bank_folder: Path, assets_path: Path):
+    files = []
+    for item in pack_list:
+        name, path = (item["Name"], assets_path / item["File"]) if isinstance(item, dict) else (Path(item).name, None)
+        if path is None:
+            path = bank_folder / item if item in bank_names else assets_path / item
+        files.append((name, path.read_bytes()))
+
+    listed = set(name for name, data in files)
+    files += [(name, (bank_folder / name).read_bytes()) for name in bank_names if name not in listed]
+    return files
+
+# sound RAM budget: samples of a budgeted bank are trimmed of silence at both ends, then the ones that lose the least quality
+# per byte saved get a lower bit depth or sample rate until the bank, or the set of banks loaded together, fits
+MIN_QUALITY_DB = 30.0
+MIN_SAMPLE_RATE = 4000
+RATE_STEPS = ((3, 4), (2, 3), (1, 2), (1, 3), (1, 4))
+SINC_ZERO_CROSSINGS = 8
+
+# silence is measured on the 16 bit scale, one step of 8 bit PCM
+SILENCE = 256
+
+# longer samples are split into one control slot per part, split points are searched back this far for a quiet sample
+MAX_PLAY_SAMPLES = 0xFFFF
+SPLIT_SEARCH = 2048
+
+# signed big-endian PCM as the SCSP plays it, to and from samples on the 16 bit scale
+def decode_pcm(data: bytes, bit_depth: int):
+    if bit_depth == 1:
+        return [(b - 256 if b > 127 else b) << 8 for b in data]
+    return [int.from_bytes(data[i:i + 2], "big", signed=True) for i in range(0, len(data) - 1, 2)]
+
+def encode_pcm(samples, bit_depth: int) -> bytes:
+    if bit_depth == 1:
+        return bytes(max(-128, min(127, (s + 128) >> 8)) & 0xFF for s in samples)
+    return b"".join(max(-32768, min(32767, s)).to_bytes(2, "big", signed=True) for s in samples)
+
+def pcm_size(samples, bit_depth: int) -> int:
+    return align4(len(samples) if bit_depth == 1 else len(samples) * 2)
+
+# windowed sinc resampler, the cutoff follows the lower of both rates so a lower rate does not alias
+def resample(samples, from_rate: int, to_rate: int):
+    ratio = to_rate / from_rate
+    cutoff = min(1.0, ratio)
+    width = int(math.ceil(SINC_ZERO_CROSSINGS / cutoff))
+    out = []
+
+    for i in range(max(1, int(len(samples) * ratio))):
+        center = i / ratio
+        total = 0.0
+
+        for k in range(max(0, int(center) - width + 1), min(len(samples), int(center) + width + 1)):
+            x = center - k
+            sinc = math.sin(math.pi * cutoff * x) / (math.pi * cutoff * x) if x != 0 else 1.0
+            total += samples[k] * cutoff * sinc * (0.5 + 0.5 * math.cos(math.pi * x / width))
+
+        out.append(int(round(total)))
+
+    return out
+
+# signal to noise ratio of a candidate played back against the source, with the linear interpolation of the SCSP
+def quality_db(reference, samples, ratio: float) -> float:
+    signal = 0
+    noise = 0
+
+    for j, expected in enumerate(reference):
+        position = j * ratio
+        i = min(int(position), len(samples) - 1)
+        following = samples[i + 1] if i + 1 < len(samples) else samples[i]
+        played = samples[i] + (following - samples[i]) * (position - i)
+        signal += expected * expected
+        noise += (expected - played) * (expected - played)
+
+    if noise == 0:
+        return math.inf
+    return 10 * math.log10(signal / noise) if signal != 0 else -math.inf
+
+# cut leading and trailing silence, never past loop points, returns (samples, loop_start, loop_end)
+def trim_silence(samples, loop_start: int, loop_end: int):
+    start = next((i for i, s in enumerate(samples) if abs(s) > SILENCE), len(samples) - 1)
+    end = next((i + 1 for i in range(len(samples) - 1, -1, -1) if abs(samples[i]) > SILENCE), 1)
+    start = min(start, end - 1)
+
+    # looping samples keep everything from the loop start, and up to the end when the loop has no end point
+    if loop_start == 0 and loop_end == 0:
+        return samples[start:end], 0, 0
+
+    start = min(start, loop_start)
+    end = max(end, loop_end) if loop_end != 0 else len(samples)
+    return samples[start:end], loop_start - start, loop_end - start if loop_end != 0 else 0
+
+# loop points moved to a new sample rate, an end point on the last sample becomes 0
+def scale_loop(loop_start: int, loop_end: int, ratio: float, length: int):
+    start = min(int(round(loop_start * ratio)), length - 1)
+    end = max(min(int(round(loop_end * ratio)), length), start + 1) if loop_end != 0 else 0
+    return start, end if end != length else 0
+
+# bit depths and sample rates a sample can take above the quality floor, from the source down, each one better than all cheaper ones
+# a candidate is (sound RAM bytes, quality, bit depth, sample rate, samples)
+def candidates(samples, bit_depth: int, sample_rate: int, min_quality: float):
+    found = [(pcm_size(samples, bit_depth), math.inf, bit_depth, sample_rate, samples)]
+    rates = dict.fromkeys([sample_rate] + [sample_rate * n // d for n, d in RATE_STEPS if sample_rate * n // d >= max(MIN_SAMPLE_RATE, 197)])
+
+    for rate in rates:
+        resampled = resample(samples, sample_rate, rate) if rate != sample_rate else samples
+
+        for depth in (0, 1) if bit_depth == 0 else (1,):
+            if (depth, rate) == (bit_depth, sample_rate):
+                continue
+
+            stored = decode_pcm(encode_pcm(resampled, depth), depth)
+            quality = quality_db(samples, stored, rate / sample_rate)
+            if quality >= min_quality:
+                found.append((pcm_size(stored, depth), quality, depth, rate, stored))
+
+    frontier = []
+    for candidate in sorted(found, key = lambda c: (c[0], -c[1])):
+        if not frontier or candidate[1] > frontier[-1][1]:
+            frontier.append(candidate)
+
+    return frontier[::-1]
+
+# lower samples one step at a time until they fit, always taking the step that loses the least quality per byte saved
+# choices: name -> candidates with the one in use first, returns bytes used
+def fit_budget(choices, fixed_bytes: int, budget: int) -> int:
+    used = fixed_bytes + sum(options[0][0] for options in choices.values())
+
+    while used > budget:
+        steps = [((options[0][1] - options[1][1]) / max(1, options[0][0] - options[1][0]), options[1][0] - options[0][0], name)
+                 for name, options in choices.items() if len(options) > 1]
+        if not steps:
+            break
+
+        options = choices[min(steps)[2]]
+        used -= options[0][0] - options[1][0]
+        options.pop(0)
+
+    return used
+
+# cut a sample that is too long for one control slot at quiet points, parts after the first are named NAME_2.PCM, NAME_3.PCM, ...
+def split_sample(name: str, samples):
+    parts = []
+
+    while len(samples) > MAX_PLAY_SAMPLES:
+        first = MAX_PLAY_SAMPLES - SPLIT_SEARCH
+        cut = min(range(first, MAX_PLAY_SAMPLES + 1), key = lambda i: (abs(samples[i]), -i))
+        parts.append(samples[:cut])
+        samples = samples[cut:]
+
+    parts.append(samples)
+    stem, dot, extension = name.rpartition(".")
+    return [(name if index == 0 else f"{stem}_{index + 1}{dot}{extension}", part) for index, part in enumerate(parts)]
+
+# samples of every bank as they go into the .snd: bank -> [(name, bit_depth, sample_rate, data, loop_start, loop_end)]
+# budgets: [{"Banks": [...], "Bytes": n}] from SOUND.json, default_budget applies to each bank that is not in one of them
+# a sample keeps what the first budget it is in chose, so the same data is shared in sound RAM by every bank using it
+def prepare_samples(config, assets_path: Path, budgets = (), default_budget: int = None, trim: bool = False, min_quality: float = MIN_QUALITY_DB):
+    sets = [(list(b["Banks"]), int(str(b["Bytes"]), 0)) for b in budgets]
+    for banks, _ in sets:
+        for snd_name in banks:
+            if snd_name not in config:
+                raise ValueError(f"Budget names {snd_name}, which is not in SOUND.json")
+
+    budgeted = set(snd_name for banks, _ in sets for snd_name in banks)
+    if default_budget is not None:
+        sets += [([snd_name], default_budget) for snd_name in config if snd_name not in budgeted]
+
+    # name -> (bit_depth, sample_rate, samples, loop_start, loop_end), and the bank it was chosen for
+    chosen = {}
+    chosen_for = {}
+    for banks, budget in sets:
+        choices = {}
+        fixed_bytes = 0
+        trimmed = {}
+        shared = {}
+
+        for snd_name in banks:
+            for pcm_name, info in config[snd_name].items():
+                if pcm_name in choices or pcm_name in trimmed:
+                    continue
+
+                data = (assets_path / pcm_name).read_bytes()
+                bit_depth = int(info["BitDepth"])
+
+                if pcm_name in chosen:
+                    # an earlier budget lowered it, this one gets the same data
+                    size = pcm_size(chosen[pcm_name][2], chosen[pcm_name][0])
+                    fixed_bytes += size
+                    trimmed[pcm_name] = None
+                    shared[pcm_name] = (align4(len(data)), size)
+                    continue
+
+                if info.get("Fixed", False):
+                    fixed_bytes += align4(len(data))
+                    trimmed[pcm_name] = None
+                    continue
+
+                source = decode_pcm(data, bit_depth)
+                samples, loop_start, loop_end = trim_silence(source, *loop_points(snd_name, pcm_name, info, bit_depth, len(data)))
+                choices[pcm_name] = candidates(samples, bit_depth, int(info["SampleRate"]), min_quality)
+                trimmed[pcm_name] = (align4(len(data)), len(source) - len(samples), loop_start, loop_end)
+
+        used = fit_budget(choices, fixed_bytes, budget)
+        saved = sum(trimmed[name][0] for name in choices) - sum(options[0][0] for options in choices.values())
+        saved += sum(original_size - size for original_size, size in shared.values())
+        print(f"\nBudget {' + '.join(banks)}: {used} of {budget} bytes, saved {saved}{'' if used <= budget else '  (warning: does not fit)'}")
+
+        for pcm_name, (original_size, size) in shared.items():
+            print(f"  {pcm_name:12} {original_size:6} -> {size:6}  shared with {chosen_for[pcm_name]}")
+
+        for pcm_name, options in choices.items():
+            original_size, cut, loop_start, loop_end = trimmed[pcm_name]
+            size, quality, bit_depth, sample_rate, samples = options[0]
+            source_rate = int(next(config[b][pcm_name] for b in banks if pcm_name in config[b])["SampleRate"])
+            chosen[pcm_name] = (bit_depth, sample_rate, samples) + scale_loop(loop_start, loop_end, sample_rate / source_rate, len(samples))
+            chosen_for[pcm_name] = next(b for b in banks if pcm_name in config[b])
+
+            print(f"  {pcm_name:12} {original_size:6} -> {size:6}  {sample_rate:5} Hz {8 if bit_depth == 1 else 16:2} bit"
+                  f"  {'lossless' if quality == math.inf else f'{quality:.1f} dB':8}{f'  trimmed {cut} samples' if cut else ''}")
+
+    prepared = {}
+    for snd_name, files in config.items():
+        entries = []
+
+        for pcm_name, info in files.items():
+            data = (assets_path / pcm_name).read_bytes()
+            bit_depth = int(info["BitDepth"])
+            sample_rate = int(info["SampleRate"])
+            loop_start, loop_end = loop_points(snd_name, pcm_name, info, bit_depth, len(data))
+            samples = None
+
+            if pcm_name in chosen:
+                bit_depth, sample_rate, samples, loop_start, loop_end = chosen[pcm_name]
+            elif trim and not info.get("Fixed", False):
+                samples, loop_start, loop_end = trim_silence(decode_pcm(data, bit_depth), loop_start, loop_end)
+            elif len(data) > (MAX_PLAY_SAMPLES if bit_depth == 1 else MAX_PLAY_SAMPLES * 2):
+                samples = decode_pcm(data, bit_depth)
+
+            if samples is None:
+                entries.append((pcm_name, bit_depth, sample_rate, data, loop_start, loop_end))
+                continue
+
+            if len(samples) > MAX_PLAY_SAMPLES and (loop_start or loop_end):
+                raise ValueError(f"{snd_name}: {pcm_name} loops and is too long for one control slot")
+
+            parts = split_sample(pcm_name, samples)
+            if len(parts) > 1:
+                print(f"  {pcm_name} split into {len(parts)} samples for {snd_name}")
+
+            entries += [(name, bit_depth, sample_rate, encode_pcm(part, bit_depth), loop_start, loop_end) for name, part in parts]
+
+        prepared[snd_name] = entries
+
+    return prepared
+
 # LZSS compression
 WINDOW_SIZE = 4096
 LOOKAHEAD = 18
 MIN_MATCH = 3
 
+# bits per token, used by the optimal parse
+LITERAL_BITS = 9
+MATCH_BITS = 17
+
+# longest match for every position, earliest window position wins a tie like in lzss_compress_reference()
+# positions are chained by their first MIN_MATCH bytes, oldest first, so the search stops at the first full length match
+# greedy only searches where the greedy parse places a token
+def find_matches(data: bytes, greedy: bool = False):
+    length = len(data)
+    chains = {}
+    heads = {}
+    matches = [(0, 0)] * length
+    next_token = 0
+
+    for i in range(length - MIN_MATCH + 1):
+        key = data[i:i + MIN_MATCH]
+        chain = chains.get(key)
+
+        if chain is None:
+            chains[key] = [i]
+            heads[key] = 0
+            continue
+
+        if greedy and i < next_token:
+            chain.append(i)
+            continue
+
+        # drop positions that slid out of the window
+        head = heads[key]
+        start = i - WINDOW_SIZE
+        while head < len(chain) and chain[head] < start:
+            head += 1
+
+        if head >= WINDOW_SIZE:
+            del chain[:head]
+            head = 0
+
+        heads[key] = head
+
+        limit = min(LOOKAHEAD, length - i)
+        best_offset = 0
+        best_length = 0
+
+        for n in range(head, len(chain)):
+            j = chain[n]
+
+            # can only be longer if it also matches the byte the best one stopped at
+            if data[j + best_length] != data[i + best_length]:
+                continue
+
+            k = MIN_MATCH
+            while k < limit and data[j + k] == data[i + k]:
+                k += 1
+
+            if k > best_length:
+                best_length = k
+                best_offset = i - j
+                if k == limit:
+                    break
+
+        matches[i] = (best_offset, best_length)
+        next_token = i + best_length if best_length >= MIN_MATCH else i + 1
+        chain.append(i)
+
+    return matches
+
+# pack tokens as (offset, length) into flag bytes and payload, length below MIN_MATCH is a literal
+def lzss_encode(data: bytes, tokens) -> bytes:
+    out = bytearray()
+    i = 0
+
+    for group in range(0, len(tokens), 8):
+        flags_pos = len(out)
+        out.append(0)
+        flags = 0
+        bit_count = 0
+
+        for offset, length in tokens[group:group + 8]:
+            if length >= MIN_MATCH:
+                # match = 0 bit
+                flags <<= 1
+                pair = (((offset - 1) & 0xFFF) << 4) | ((length - MIN_MATCH) & 0xF)
+                out.append((pair >> 8) & 0xFF)
+                out.append(pair & 0xFF)
+                i += length
+            else:
+                # literal = 1 bit
+                flags = (flags << 1) | 1
+                out.append(data[i])
+                i += 1
+
+            bit_count += 1
+
+        flags <<= (8 - bit_count)
+        out[flags_pos] = flags & 0xFF
+
+    return bytes(out)
+
+# greedy parse, output is byte for byte the same as lzss_compress_reference()
 def lzss_compress(data: bytes) -> bytes:
+    matches = find_matches(data, True)
+    tokens = []
+    i = 0
+
+    while i < len(data):
+        offset, length = matches[i]
+        if length >= MIN_MATCH:
+            tokens.append((offset, length))
+            i += length
+        else:
+            tokens.append((0, 1))
+            i += 1
+
+    return lzss_encode(data, tokens)
+
+# optimal parse, picks the cheapest split into literals and matches instead of always the longest match
+# the stream format is the same, so the decoder does not change
+def lzss_compress_optimal(data: bytes) -> bytes:
+    length = len(data)
+    matches = find_matches(data)
+    cost = [0] * (length + 1)
+    choice = [1] * length
+
+    for i in range(length - 1, -1, -1):
+        best = cost[i + 1] + LITERAL_BITS
+        best_length = 1
+
+        # every prefix of the longest match is a match at the same offset
+        for n in range(MIN_MATCH, matches[i][1] + 1):
+            c = cost[i + n] + MATCH_BITS
+            if c < best:
+                best = c
+                best_length = n
+
+        cost[i] = best
+        choice[i] = best_length
+
+    tokens = []
+    i = 0
+    while i < length:
+        n = choice[i]
+        tokens.append((matches[i][0], n) if n >= MIN_MATCH else (0, 1))
+        i += n
+
+    return lzss_encode(data, tokens)
+
+# original brute force search, slow but kept to check lzss_compress() against
+def lzss_compress_reference(data: bytes) -> bytes:
     out = bytearray()
     i = 0
     length = len(data)
@@ -179,29 +815,291 @@ def compressLzssInFolder(folder: str, write_output: bool = False):
             out_path = file_path.with_suffix(".LZ")
             out_path.write_bytes(out_data)
 
-# specifically for packing .pcm samples to .snd format
-def packSndInFolder(assets_folder: str, out_folder: str):
+# compress one sample, top level so worker processes can run it
+def compress_data(args):
+    data, optimal = args
+    return lzss_compress_optimal(data) if optimal else lzss_compress(data)
+
+# build cache, bump when the compressor output changes so old payloads are not reused
+CACHE_FOLDER = ".sndcache"
+CACHE_VERSION = 3
+
+def content_hash(data: bytes) -> str:
+    return hashlib.sha1(data).hexdigest()
+
+# payloads are stored by content hash and parse mode, manifest.json remembers the inputs of every .snd
+def load_cache(assets_folder: Path):
+    folder = assets_folder / CACHE_FOLDER
+    manifest = {}
+
+    try:
+        with open(folder / "manifest.json", "r") as f:
+            manifest = json.load(f)
+    except (OSError, ValueError):
+        pass
+
+    if manifest.get("CacheVersion") != CACHE_VERSION:
+        manifest = {}
+
+    return folder, manifest.get("Banks", {}), manifest.get("Prepared")
+
+def save_cache(folder: Path, banks, prepared):
+    folder.mkdir(exist_ok=True)
+    with open(folder / "manifest.json", "w") as f:
+        json.dump({"CacheVersion": CACHE_VERSION, "Banks": banks, "Prepared": prepared}, f, indent=2)
+
+    # drop payloads and prepared samples nothing uses anymore
+    used = set(f"{sample[0]}-{bank['Mode']}.lz" for bank in banks.values() for sample in bank["Samples"].values())
+    if prepared is not None:
+        used |= set(f"{entry[3]}.pcm" for entries in prepared["Banks"].values() for entry in entries if entry[6])
+
+    for blob in list(folder.glob("*.lz")) + list(folder.glob("*.pcm")):
+        if blob.name not in used:
+            blob.unlink()
+
+# budgets resample and requantize every sample they may lower, so what prepare_samples() returned is cached as well
+# it is reused while SOUND.json, the budget settings and the content of every source stay the same
+PREPARE_VERSION = 1
+
+def prepare_key(config, assets_path: Path, budgets, default_budget: int, trim: bool, min_quality: float) -> str:
+    sources = {pcm_name: content_hash((assets_path / pcm_name).read_bytes()) for files in config.values() for pcm_name in files}
+    settings = {"Version": PREPARE_VERSION, "Banks": config, "Budgets": budgets, "Budget": default_budget, "Trim": trim, "MinQuality": min_quality, "Sources": sources}
+    return content_hash(json.dumps(settings).encode("utf-8"))
+
+# entries that differ from their source file are stored as <content hash>.pcm, the others are read from the source again
+def store_prepared(folder: Path, prepared, key: str, assets_path: Path):
+    record = {}
+    folder.mkdir(exist_ok=True)
+
+    for snd_name, entries in prepared.items():
+        record[snd_name] = []
+
+        for name, bit_depth, sample_rate, data, loop_start, loop_end in entries:
+            h = content_hash(data)
+            stored = not (assets_path / name).exists() or (assets_path / name).read_bytes() != data
+            if stored:
+                (folder / f"{h}.pcm").write_bytes(data)
+            record[snd_name].append([name, bit_depth, sample_rate, h, loop_start, loop_end, stored])
+
+    return {"Key": key, "Banks": record}
+
+# prepared samples of the last run, None when anything they depend on changed or a stored sample is gone
+def load_prepared(folder: Path, record, key: str, assets_path: Path):
+    if record is None or record.get("Key") != key:
+        return None
+
+    prepared = {}
+    try:
+        for snd_name, entries in record["Banks"].items():
+            prepared[snd_name] = [(name, bit_depth, sample_rate, (folder / f"{h}.pcm" if stored else assets_path / name).read_bytes(), loop_start, loop_end)
+                                  for name, bit_depth, sample_rate, h, loop_start, loop_end, stored in entries]
+    except OSError:
+        return None
+
+    return prepared
+
+# compress samples on all cores, data used by several banks is only compressed once
+# with a cache folder, payloads of unchanged data are read back instead, returns content hash -> (payload, from cache)
+def compress_samples(samples, optimal: bool = False, jobs: int = None, cache_folder: Path = None):
+    unique = sorted(samples)
+    jobs = jobs or os.cpu_count() or 1
+    mode = "optimal" if optimal else "greedy"
+    done = {}
+
+    for h in unique:
+        blob = cache_folder / f"{h}-{mode}.lz" if cache_folder is not None else None
+        if blob is not None and blob.exists():
+            done[h] = (blob.read_bytes(), True)
+
+    missing = [h for h in unique if h not in done]
+
+    if jobs <= 1 or len(missing) <= 1:
+        results = [compress_data((samples[h], optimal)) for h in missing]
+    else:
+        with ProcessPoolExecutor(max_workers=jobs) as pool:
+            results = list(pool.map(compress_data, [(samples[h], optimal) for h in missing]))
+
+    for h, compressed in zip(missing, results):
+        done[h] = (compressed, False)
+        if cache_folder is not None:
+            cache_folder.mkdir(exist_ok=True)
+            (cache_folder / f"{h}-{mode}.lz").write_bytes(compressed)
+
+    return done
+
+# why a bank has to be rebuilt, None when the output is up to date
+def rebuild_reason(record, bank, out_file: Path):
+    if record is None:
+        return "not built before"
+    if not out_file.exists():
+        return "output missing"
+    if content_hash(out_file.read_bytes()) != record["Output"]:
+        return "output changed outside of the pack step"
+    if record["Version"] != bank["Version"] or record["Mode"] != bank["Mode"]:
+        return "pack settings changed"
+
+    old = record["Samples"]
+    new = bank["Samples"]
+    changed = [name for name in new if name in old and old[name] != new[name]]
+    added = [name for name in new if name not in old]
+    removed = [name for name in old if name not in new]
+
+    reasons = []
+    if changed: reasons.append("changed " + ", ".join(changed))
+    if added: reasons.append("added " + ", ".join(added))
+    if removed: reasons.append("removed " + ", ".join(removed))
+    if not reasons and list(old) != list(new): reasons.append("sample order changed")
+
+    return "; ".join(reasons) if reasons else None
+
+# read a packed .snd back the way the loader does and compare every sample with its source
+# samples: list of (name, bit_depth, sample_rate, data, loop_start, loop_end) in bank order, data may be shared between entries
+def verify_snd(snd_path: Path, samples):
+    snd = snd_path.read_bytes()
+    entries = []
+
+    if int.from_bytes(snd[0:4], "big") == SND_MAGIC:
+        version = int.from_bytes(snd[4:6], "big")
+        count = int.from_bytes(snd[6:8], "big")
+        entry_size = int.from_bytes(snd[8:10], "big")
+        sound_ram = int.from_bytes(snd[12:16], "big")
+        payload_offset = int.from_bytes(snd[16:20], "big")
+
+        if version != SND_VERSION or entry_size < SND_ENTRY_SIZE or payload_offset != SND_HEADER_SIZE + count * entry_size:
+            raise ValueError(f"{snd_path.name}: bad header")
+
+        for index in range(count):
+            e = snd[SND_HEADER_SIZE + index * entry_size:SND_HEADER_SIZE + (index + 1) * entry_size]
+            loop = (int.from_bytes(e[20:22], "big"), int.from_bytes(e[22:24], "big")) if entry_size >= SND_LOOP_ENTRY_SIZE else (0, 0)
+            content = int.from_bytes(e[24:28], "big") if entry_size >= SND_HASH_ENTRY_SIZE else None
+            entries.append((int.from_bytes(e[0:4], "big"), int.from_bytes(e[4:8], "big"), int.from_bytes(e[8:12], "big"),
+                            int.from_bytes(e[12:16], "big"), int.from_bytes(e[16:18], "big"), e[18]) + loop + (content,))
+
+        # entries with the same data share sound RAM, entries without a hash always count
+        seen = set()
+        needed = 0
+        for e in entries:
+            if e[8] is None or (e[8], e[3], e[5]) not in seen:
+                needed += align4(e[3])
+                seen.add((e[8], e[3], e[5]))
+
+        if sound_ram != needed:
+            raise ValueError(f"{snd_path.name}: sound RAM total does not match the entries")
+    else:
+        offset = 0
+        while offset < len(snd):
+            h = snd[offset:offset + 12]
+            compressed_size = int.from_bytes(h[4:8], "big")
+            original_size = int.from_bytes(h[8:12], "big")
+            entries.append((None, offset + 12, compressed_size, original_size, int.from_bytes(h[2:4], "big"), int.from_bytes(h[0:2], "big"), None, None, None))
+            offset += 12 + (compressed_size if compressed_size != 0 else original_size)
+
+    if len(entries) != len(samples):
+        raise ValueError(f"{snd_path.name}: {len(entries)} entries, expected {len(samples)}")
+
+    for (name_hash_, offset, compressed_size, original_size, sample_rate, bit_depth, loop_start, loop_end, content), (name, depth, rate, data, start, end) in zip(entries, samples):
+        size = compressed_size if compressed_size != 0 else original_size
+        if offset + size > len(snd):
+            raise ValueError(f"{snd_path.name}: {name} runs past the end of the file")
+        if name_hash_ is not None and name_hash_ != name_hash(name):
+            raise ValueError(f"{snd_path.name}: {name} has the wrong name hash")
+        if (sample_rate, bit_depth, original_size) != (rate, depth, len(data)):
+            raise ValueError(f"{snd_path.name}: {name} has wrong parameters")
+        if loop_start is not None and (loop_start, loop_end) != (start, end):
+            raise ValueError(f"{snd_path.name}: {name} has wrong loop points")
+        if content is not None and content != sample_hash(data):
+            raise ValueError(f"{snd_path.name}: {name} has the wrong content hash")
+
+        payload = snd[offset:offset + size]
+        decoded = lzss_decompress(payload, original_size) if compressed_size != 0 else payload
+        if decoded != data:
+            raise ValueError(f"{snd_path.name}: {name} does not decode to its source")
+
+    print(f"Verified: {snd_path.name} ({len(entries)} samples)")
+
+# specifically for packing .pcm samples to .snd format (version 2 by default, 1 for the legacy layout)
+# optimal trades packing time for smaller payloads, jobs defaults to the number of cores
+# banks whose samples, parameters and settings did not change since the last run are skipped unless use_cache is off
+# verify reads every bank back (rebuilt or not) and checks that it decodes to the source samples
+# header_folder receives a constexpr manifest per bank for Pcm::LoadBank() (version 2 only, None to skip)
+# budget is the sound RAM each bank may use unless SOUND.json puts it in a "Budgets" set, trim cuts silence in every bank
+# pack names a single archive written to out_folder instead of loose .snd files, banks are then kept in the build cache
+def packSndInFolder(assets_folder: str, out_folder: str, version: int = SND_VERSION, optimal: bool = False, jobs: int = None, use_cache: bool = True, verify: bool = False, header_folder: str = None,
+                    budget: int = None, trim: bool = False, min_quality: float = MIN_QUALITY_DB, pack: str = None):
     assets_folder = Path(assets_folder)
 
     with open(assets_folder / "SOUND.json", "r") as f:
         config = json.load(f)
 
+    # "Budgets" and "Pack" are the only top level keys that are not a bank
+    budgets = config.pop("Budgets", [])
+    pack_list = config.pop("Pack", [])
+
     assets_path = Path(assets_folder)
     out_path = Path(out_folder)
+    cache_folder, records, prepared_record = load_cache(assets_path) if use_cache else (None, {}, None)
+    staging = None
 
-    for snd_name, files in config.items():
-        print(f"\nBuilding {snd_name}")
+    # packed banks only go into the archive, so they do not take up CD directory entries
+    if pack is not None:
+        staging = tempfile.TemporaryDirectory() if cache_folder is None else None
+        out_path = Path(staging.name) if staging is not None else cache_folder / "pack"
+        out_path.mkdir(parents=True, exist_ok=True)
 
-        snd_data = bytearray()
-                
-        for pcm_name, info in files.items():
-            pcm_path = assets_path / pcm_name
-            data = pcm_path.read_bytes()
+    mode = "optimal" if optimal else "greedy"
+    prepared = None
 
-            bit_depth = int(info["BitDepth"])
-            sample_rate = int(info["SampleRate"])
+    # budgets are only fitted again when a source or a setting they depend on changed
+    if use_cache:
+        key = prepare_key(config, assets_path, budgets, budget, trim, min_quality)
+        prepared = load_prepared(cache_folder, prepared_record, key, assets_path)
+        if prepared is not None and (budgets or budget is not None or trim):
+            print("\nSamples and budgets unchanged, prepared samples taken from the cache")
+
+    if prepared is None:
+        prepared = prepare_samples(config, assets_path, budgets, budget, trim, min_quality)
+        if use_cache:
+            prepared_record = store_prepared(cache_folder, prepared, key, assets_path)
+
+    # everything a bank's output depends on
+    hashes = {}
+    banks = {}
+    for snd_name, entries in prepared.items():
+        samples = {}
+        for name, bit_depth, sample_rate, data, loop_start, loop_end in entries:
+            h = content_hash(data)
+            hashes[h] = data
+            samples[name] = [h, bit_depth, sample_rate, loop_start, loop_end]
+        banks[snd_name] = {"Version": version, "Mode": mode, "Samples": samples}
+
+    reasons = {snd_name: rebuild_reason(records.get(snd_name), banks[snd_name], out_path / snd_name) if use_cache else "cache off"
+               for snd_name in config}
+
+    header_path = Path(header_folder) if header_folder is not None and version >= 2 else None
+    for snd_name in config:
+        if reasons[snd_name] is None and header_path is not None and not (header_path / f"{identifier(snd_name, True)}.hpp").exists():
+            reasons[snd_name] = "manifest header missing"
 
-            compressed = lzss_compress(data)
+    compressed_samples = compress_samples(
+        {sample[0]: hashes[sample[0]] for snd_name in config if reasons[snd_name] for sample in banks[snd_name]["Samples"].values()},
+        optimal,
+        jobs,
+        cache_folder)
+
+    for snd_name in config:
+        if reasons[snd_name] is None:
+            print(f"\nUp to date {snd_name}")
+            if verify:
+                verify_snd(out_path / snd_name, prepared[snd_name])
+            continue
+
+        print(f"\nBuilding {snd_name} ({reasons[snd_name]})")
+
+        snd_data = bytearray()
+        entries = []
+                
+        for pcm_name, bit_depth, sample_rate, data, loop_start, loop_end in prepared[snd_name]:
+            compressed, cached = compressed_samples[banks[snd_name]["Samples"][pcm_name][0]]
             original_size=len(data)
             compressed_size = 0
             
@@ -220,18 +1118,63 @@ def packSndInFolder(assets_folder: str, out_folder: str):
             )
 
             snd_data += header + payload
+            entries.append((pcm_name, bit_depth, sample_rate, original_size, compressed_size, payload, loop_start, loop_end, sample_hash(data)))
+
+            print(f"  {pcm_name:12} {len(data):6} -> {len(payload):6}{'  (cached)' if cached else ''}")
+
+        if version >= 2:
+            snd_data = build_snd_v2(entries)
+            print(f"  sound RAM needed: {bank_sound_ram(entries)} bytes")
 
-            print(f"  {pcm_name:12} {len(data):6} -> {len(payload):6}")
+        if header_path is not None:
+            header_path.mkdir(parents=True, exist_ok=True)
+            header_file = header_path / f"{identifier(snd_name, True)}.hpp"
+            header_file.write_bytes(build_bank_header(snd_name, entries).replace("\n", "\r\n").encode("ascii"))
+            print(f"Saved: {header_file}")
 
         out_file = out_path / snd_name
         out_file.write_bytes(snd_data)
+        records[snd_name] = dict(banks[snd_name], Output=content_hash(bytes(snd_data)))
         print(f"Saved: {out_file}")
 
+        if verify:
+            verify_snd(out_file, prepared[snd_name])
+
+    if use_cache:
+        save_cache(cache_folder, {snd_name: records[snd_name] for snd_name in config if snd_name in records}, prepared_record)
+
+    if pack is not None:
+        files = pack_files(pack_list, list(config), out_path, assets_path)
+        pack_data = build_pack(files)
+        pack_file = Path(out_folder) / pack
+        pack_file.write_bytes(pack_data)
+
+        print(f"\nPacked {pack} ({len(files)} entries, {len(pack_data) // SECTOR_SIZE} sectors)")
+        for name, data in files:
+            print(f"  {name:24} {len(data):8} bytes {sectors(len(data)):5} sectors")
+        print(f"Saved: {pack_file}")
+
+        if staging is not None:
+            staging.cleanup()
+
 # process PCM files and save them to the project as .snd:
 PROJECT_ROOT = Path(__file__).resolve().parent.parent
 INPUT = PROJECT_ROOT / "sfx"
 OUTPUT = PROJECT_ROOT.parent / "cd" / "data"
+HEADERS = PROJECT_ROOT.parent / "src" / "banks"
 
 if __name__ == "__main__":
-     packSndInFolder(INPUT, OUTPUT)
+    parser = argparse.ArgumentParser(description="Pack PCM samples listed in SOUND.json into .snd files")
+    parser.add_argument("--optimal", action="store_true", help="optimal parse, smaller but slower (default is the greedy parse)")
+    parser.add_argument("--jobs", type=int, default=None, help="number of files compressed at once (default is the number of cores)")
+    parser.add_argument("--version", type=int, default=SND_VERSION, help="container version to write (1 or 2)")
+    parser.add_argument("--no-cache", action="store_true", help=f"rebuild everything and leave {CACHE_FOLDER} alone")
+    parser.add_argument("--verify", action="store_true", help="read every .snd back and check it decodes to the source samples")
+    parser.add_argument("--budget", type=lambda v: int(v, 0), default=None, help="sound RAM bytes per bank that is not in a SOUND.json budget, lowers bit depth and rate to fit")
+    parser.add_argument("--trim", action="store_true", help="cut leading and trailing silence in every bank, not only budgeted ones")
+    parser.add_argument("--min-quality", type=float, default=MIN_QUALITY_DB, help=f"lowest signal to noise ratio in dB a budget may lower a sample to (default {MIN_QUALITY_DB})")
+    parser.add_argument("--pack", nargs="?", const=PACK_FILE, default=None, help=f"write every bank and the SOUND.json \"Pack\" files into one archive (default name {PACK_FILE}) instead of loose .snd files")
+    args = parser.parse_args()
+
+    packSndInFolder(INPUT, OUTPUT, args.version, args.optimal, args.jobs, not args.no_cache, args.verify, HEADERS, args.budget, args.trim, args.min_quality, args.pack)
      
@@ -0,0 +1,33 @@
+// Generated by PcmCompress.py from SOUND.json, do not edit
+#pragma once
+#include <ponesound.hpp>
+
+namespace Banks
+{
+    /** @brief Sound bank ANOTHER.SND
+     */
+    struct ANOTHER_SND
+    {
+        /** @brief Index of each sample in the array passed to Pcm::LoadBank()
+         */
+        enum Sample : int16_t
+        {
+            MEOW1 = 0,
+            MEOW2 = 1,
+        };
+
+        static constexpr int16_t Count = 2;
+        static constexpr uint32_t SoundRamSize = 6416;
+
+        static constexpr SRL::Ponesound::BankManifest::Sample Samples[Count] =
+        {
+            { 0x66A2C172, 76, 1774, 3315, 0, 15360, 0x7192, 256, 3315, 1, 0, 0, 0xAAA195AA }, // MEOW1.PCM
+            { 0x55B6AD1F, 1850, 2226, 3098, 3316, 15360, 0x7192, 256, 3098, 1, 0, 0, 0xE30A6049 }, // MEOW2.PCM
+        };
+
+        static constexpr SRL::Ponesound::BankManifest Manifest = { "ANOTHER.SND", Samples, Count, SoundRamSize };
+    };
+
+    static_assert(ANOTHER_SND::SoundRamSize <= SRL::Ponesound::BankManifest::MAX_SOUND_RAM, "ANOTHER.SND does not fit in sound RAM");
+    static_assert(ANOTHER_SND::Count <= SRL::Ponesound::BankManifest::MAX_SAMPLES, "ANOTHER.SND has more samples than control slots");
+}
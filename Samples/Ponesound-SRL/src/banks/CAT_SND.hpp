@@ -0,0 +1,47 @@
+// Generated by PcmCompress.py from SOUND.json, do not edit
+#pragma once
+#include <ponesound.hpp>
+
+namespace Banks
+{
+    /** @brief Sound bank CAT.SND
+     */
+    struct CAT_SND
+    {
+        /** @brief Index of each sample in the array passed to Pcm::LoadBank()
+         */
+        enum Sample : int16_t
+        {
+            MEOW1 = 0,
+            MEOW5 = 1,
+            MEOW2 = 2,
+            MEOW6 = 3,
+            MEOW3 = 4,
+            MEOW7 = 5,
+            MEOW4 = 6,
+            MEOW8 = 7,
+            MEOW9 = 8,
+        };
+
+        static constexpr int16_t Count = 9;
+        static constexpr uint32_t SoundRamSize = 46340;
+
+        static constexpr SRL::Ponesound::BankManifest::Sample Samples[Count] =
+        {
+            { 0x66A2C172, 272, 1774, 3315, 0, 15360, 0x7192, 256, 3315, 1, 0, 0, 0xAAA195AA }, // MEOW1.PCM
+            { 0xB5F3BA66, 2046, 3830, 5014, 3316, 15360, 0x7192, 256, 5014, 1, 0, 0, 0x63550070 }, // MEOW5.PCM
+            { 0x55B6AD1F, 5876, 2226, 3098, 8332, 15360, 0x7192, 256, 3098, 1, 0, 0, 0xE30A6049 }, // MEOW2.PCM
+            { 0x36016D13, 8102, 2161, 2692, 11432, 15360, 0x7192, 256, 2692, 1, 0, 0, 0xBDDE28D6 }, // MEOW6.PCM
+            { 0xC5386F88, 10263, 2140, 2400, 14124, 15360, 0x7192, 256, 2400, 1, 0, 0, 0x5FCAA65F }, // MEOW3.PCM
+            { 0x39531DBC, 12403, 4523, 6924, 16524, 15360, 0x7192, 256, 6924, 1, 0, 0, 0x2C4EC40B }, // MEOW7.PCM
+            { 0x9D628255, 16926, 2405, 2704, 23448, 15360, 0x7192, 256, 2704, 1, 0, 0, 0x58344262 }, // MEOW4.PCM
+            { 0x6285F6C9, 19331, 7559, 10565, 26152, 15360, 0x7192, 256, 10565, 1, 0, 0, 0xBCFCF6CB }, // MEOW8.PCM
+            { 0x254DA49A, 26890, 4883, 9618, 36720, 15360, 0x7192, 256, 9618, 1, 0, 0, 0x9C4FAB6B }, // MEOW9.PCM
+        };
+
+        static constexpr SRL::Ponesound::BankManifest Manifest = { "CAT.SND", Samples, Count, SoundRamSize };
+    };
+
+    static_assert(CAT_SND::SoundRamSize <= SRL::Ponesound::BankManifest::MAX_SOUND_RAM, "CAT.SND does not fit in sound RAM");
+    static_assert(CAT_SND::Count <= SRL::Ponesound::BankManifest::MAX_SAMPLES, "CAT.SND has more samples than control slots");
+}
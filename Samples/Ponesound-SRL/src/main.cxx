@@ -1,17 +1,18 @@
 #include <srl.hpp>
 #include <ponesound.hpp>
+#include "banks/CAT_SND.hpp"
 
 using namespace SRL::Types;
 using namespace SRL::Input;
 using namespace SRL::Ponesound;
 
-const int16_t maxSamples = 9;
+const int16_t maxSamples = Banks::CAT_SND::Count;
 
 int main()
 {
 	SRL::Core::Initialize(SRL::Types::HighColor::Colors::Black);
     
-    short catSnd[maxSamples] = {};
+    int16_t catSnd[maxSamples] = {};
     int16_t volume = 15;
     int16_t curSample = 0;
     int32_t currentTrack = 2;
@@ -21,12 +22,17 @@ int main()
     
     // Ponesound
     Sound::Driver::Initialize(ADXMode::ADX2304);    
-    Pcm::LoadSound("CAT.SND", catSnd, maxSamples);           // load compressed sound sample library (.snd)
     int16_t bumpPcm16    = Pcm::Load16("BUMP16.PCM", 15360); // explicitly specify bitrate
     int16_t gameOverPcm8 = Pcm::Load8("GMOVR8.PCM");         // or use the default (15360)
-    int16_t adx4snd      = Pcm::LoadAdx("NBGM.ADX");         // load ADX music (large file, takes a long time to load)
+    int16_t adx4snd      = AdxStream::Open("NBGM.ADX");      // stream ADX music, only a small buffer is kept in sound RAM
+
+    Stream bumpStream;
+    bumpStream.Open("BUMP16.PCM", BitDepth::PCM16, 15360);   // stream PCM from CD through a small ring in sound RAM
+    bumpStream.Loop(true);
+
+    // load compressed sound sample library (.snd) in the background, Loader::Update() below does the work
+    int16_t catRequest = Pcm::LoadBankAsync(Banks::CAT_SND::Manifest, catSnd);
 
-    SRL::Debug::Print(1,3, "NumberOfPCMs %d", Sound::GetNumberOfPCMs());
     SRL::Debug::Print(1,4, "CD Volume %d  ", volume);
     SRL::Debug::Print(1,5, "Cat sound %d     ", curSample+1);
     SRL::Debug::Print(1,8,  "Controls:");
@@ -39,6 +45,7 @@ int main()
     SRL::Debug::Print(5,15, "C: - PCM playback (protected)");
     SRL::Debug::Print(5,16, "X: - ADX playback");
     SRL::Debug::Print(5,17, "Y: - ADX stop");
+    SRL::Debug::Print(5,18, "Z: - PCM stream start/stop");
    
     Digital port0(0);
 
@@ -46,8 +53,22 @@ int main()
 	{
         DateTime time = DateTime::Now();
         SRL::Debug::Print(1,1, "%d:%d:%d %d.%d.%d    ", time.Hour(), time.Minute(), time.Second(), time.Day(), time.Month(), time.Year());
+
+        Loader::Update();
+        Stream::UpdateAll();                                 // refills PCM stream rings, CD reads stay out of vblank
+        AdxStream::Update();                                 // refills the ADX stream buffer halves the driver released
+        CD::Update();                                        // starts queued CD tracks when the current one ends
+
+        if (Loader::GetStatus(catRequest) == LoadStatus::Pending)
+        {
+            SRL::Debug::Print(1,3, "Loading CAT.SND %d%%  ", Loader::GetProgress(catRequest));
+        }
+        else
+        {
+            SRL::Debug::Print(1,3, "NumberOfPCMs %d      ", Sound::GetNumberOfPCMs());
+        }
     
-        if (port0.WasPressed(Digital::Button::A))
+        if (port0.WasPressed(Digital::Button::A) && Loader::GetStatus(catRequest) == LoadStatus::Ready)
         {
             SRL::Debug::Print(1,6, "Play sample %d ", catSnd[curSample]+1);
             // explicitly specify the playmode and volume
@@ -68,13 +89,29 @@ int main()
         if (port0.WasPressed(Digital::Button::X))
         {
             SRL::Debug::Print(1,6, "Play adx %d        ", adx4snd);
-            Pcm::Play(adx4snd, PlayMode::Semi, 7);
+            AdxStream::Play(7);
         }
         if (port0.WasPressed(Digital::Button::Y))
         {
             SRL::Debug::Print(1,6, "Stop adx %d        ", adx4snd);
-            Pcm::Stop(adx4snd);
+            AdxStream::Stop();
+        }
+        
+        if (port0.WasPressed(Digital::Button::Z))
+        {
+            if (!bumpStream.IsPlaying())
+            {
+                SRL::Debug::Print(1,6, "Play stream        ");
+                bumpStream.Play();
+            }
+            else
+            {
+                SRL::Debug::Print(1,6, "Stop stream        ");
+                bumpStream.Stop();
+            }
         }
+        SRL::Debug::Print(1,7, "Stream underruns %d  ", bumpStream.GetUnderruns());
+        Stats::Print(1,20);                                  // sound RAM map, slots, commands, last load, stream fill
         
         if (port0.WasPressed(Digital::Button::START))
         {
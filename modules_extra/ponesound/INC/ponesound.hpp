@@ -6,6 +6,18 @@
 using namespace SRL::Math::Types;
 using namespace SRL::Decompression;
 
+/** @brief Address bit of the cache-through alias of work RAM (host builds without a cache define it as 0)
+ */
+#ifndef PONESOUND_CACHE_THROUGH
+#define PONESOUND_CACHE_THROUGH 0x20000000
+#endif
+
+/** @brief Run while waiting for the vblank hook (host builds without interrupts run the hook from it)
+ */
+#ifndef PONESOUND_WAIT_FRAME
+#define PONESOUND_WAIT_FRAME() ((void)0)
+#endif
+
 namespace SRL::Ponesound
 {
     /**
@@ -73,12 +85,82 @@ namespace SRL::Ponesound
         */
         Semi = -2,
     };
+
+    /**
+    * @brief Enum defining which voice is taken when a sound has to steal one.
+    */
+    enum class StealMode : uint8_t
+    {
+        /** @brief Voice that started first
+        */
+        Oldest = 0,
+
+        /** @brief Voice with the lowest volume, oldest among equally quiet ones
+        */
+        Quietest = 1
+    };
+
+    /**
+    * @brief Enum defining status of an asynchronous load request.
+    */
+    enum class LoadStatus : int8_t
+    {
+        /** @brief Handle is not in use
+        */
+        Free = 0,
+
+        /** @brief Request is queued or loading
+        */
+        Pending = 1,
+
+        /** @brief Request finished loading
+        */
+        Ready = 2,
+
+        /** @brief Request failed, see Loader::GetResult()
+        */
+        Failed = 3
+    };
+
+    /**
+    * @brief Enum defining state of CD audio playback as reported by the drive.
+    */
+    enum class CdStatus : uint8_t
+    {
+        /** @brief Nothing is playing
+        */
+        Stopped = 0,
+
+        /** @brief Audio is playing
+        */
+        Playing = 1,
+
+        /** @brief Paused by CD::Pause(), CD::Resume() continues
+        */
+        Paused = 2,
+
+        /** @brief Drive is moving to the start of a range
+        */
+        Seeking = 3,
+
+        /** @brief Tray is open or there is no disc
+        */
+        NoDisc = 4,
+
+        /** @brief Drive reported an error
+        */
+        Error = 5
+    };
 		
 	/**
 	 * @brief Class for managing sound operations.
 	 */ 
 	class Sound final
 	{
+		/** @brief Host test harness (tests/host) reaches the internals through this
+		 */
+		friend struct HostAccess;
+
 	private:     // zzz   
 	// public:        
         /**
@@ -88,7 +170,7 @@ namespace SRL::Ponesound
          * @return Masked value containing the least significant N bits.
          */
         template <int N>
-        static auto ExtractLeastSignificantBits(auto value)
+        static constexpr auto ExtractLeastSignificantBits(auto value)
         {
             return ((1 << N) - 1) & value;
         }
@@ -102,7 +184,7 @@ namespace SRL::Ponesound
 		 * @param b The second integer.
 		 * @return The greatest common divisor of `a` and `b`.
 		 */
-		static int16_t CalculateGCD(int16_t a, int16_t b)
+		static constexpr int16_t CalculateGCD(int16_t a, int16_t b)
 		{
 			return a == 0 ? b : CalculateGCD(b % a, a);
 		}
@@ -117,10 +199,36 @@ namespace SRL::Ponesound
 		 * @param b The second integer.
 		 * @return The least common multiple of `a` and `b`.
 		 */
-		static int16_t CalculateLCM(int16_t a, int16_t b)
+		static constexpr int16_t CalculateLCM(int16_t a, int16_t b)
 		{
 			return (a / CalculateGCD(a, b)) * b;
 		}
+
+		/**
+		 * @brief Calculates the integer square root (rounded down) of a value.
+		 *
+		 * @param value Input value.
+		 * @return Largest integer whose square is not above `value`.
+		 */
+		static constexpr uint32_t CalculateSqrt(uint32_t value)
+		{
+			uint32_t root = 0;
+
+			for (uint32_t bit = 1UL << 30; bit != 0; bit >>= 2)
+			{
+				if (value >= root + bit)
+				{
+					value -= root + bit;
+					root = (root >> 1) + bit;
+				}
+				else
+				{
+					root >>= 1;
+				}
+			}
+
+			return root;
+		}
 
         /** @brief Struct representing packed Sound file header (.snd)
          */
@@ -143,6 +251,147 @@ namespace SRL::Ponesound
             uint32_t originalSize;
             
         };
+
+        /** @brief Struct representing header of a version 2 packed Sound file (.snd)
+         */
+        struct SndHeader
+        {
+            /** @brief File magic (SND_MAGIC)
+             */
+            uint32_t magic;
+
+            /** @brief Format version (SND_VERSION)
+             */
+            uint16_t version;
+
+            /** @brief Number of entries in the table of contents
+             */
+            uint16_t entryCount;
+
+            /** @brief Size of one table of contents entry in bytes (entries may grow in later versions)
+             */
+            uint16_t entrySize;
+
+            /** @brief Reserved
+             */
+            uint16_t reserved;
+
+            /** @brief Sound RAM needed to load every entry
+             */
+            uint32_t soundRamSize;
+
+            /** @brief Offset of the first payload byte from start of the file
+             */
+            uint32_t payloadOffset;
+        };
+
+        /** @brief Struct representing table of contents entry of a version 2 packed Sound file (.snd)
+         */
+        struct SndEntry
+        {
+            /** @brief Hash of the upper case PCM file name (see Pcm::HashName())
+             */
+            uint32_t nameHash;
+
+            /** @brief Offset of the payload from start of the file
+             */
+            uint32_t offset;
+
+            /** @brief Compressed PCM size (0 if stored uncompressed)
+             */
+            uint32_t compressedSize;
+
+            /** @brief Original PCM Size
+             */
+            uint32_t originalSize;
+
+            /** @brief Sample Rate (ie 15360)
+             */
+            uint16_t sampleRate;
+
+            /** @brief Bit Depth (PCM8 or PCM16)
+             */
+            uint8_t bitDepth;
+
+            /** @brief Reserved
+             */
+            uint8_t flags;
+
+            /** @brief Loop start in samples (only present when entrySize covers it, 0 otherwise)
+             */
+            uint16_t loopStart;
+
+            /** @brief Loop end in samples, playback stops or wraps here (0 for the end of the sample)
+             */
+            uint16_t loopEnd;
+
+            /** @brief Hash of the PCM data as it is stored in sound RAM (only present when entrySize covers it, 0 otherwise)
+             * @details Samples with the same hash share their sound RAM, even across files (see Stats::GetLoad())
+             */
+            uint32_t contentHash;
+        };
+
+        /** @brief Magic of version 2 sound files ('PSND')
+         */
+        static constexpr uint32_t SND_MAGIC = 0x50534E44;
+
+        /** @brief Size of table of contents entries without loop points, files without loops keep using it
+         */
+        static constexpr uint16_t SND_ENTRY_MIN_SIZE = 20;
+
+        /** @brief Current sound file version
+         */
+        static constexpr uint16_t SND_VERSION = 2;
+
+        /** @brief Struct representing header of a sound archive (.pak)
+         */
+        struct PackHeader
+        {
+            /** @brief File magic (PACK_MAGIC)
+             */
+            uint32_t magic;
+
+            /** @brief Format version (PACK_VERSION)
+             */
+            uint16_t version;
+
+            /** @brief Size of one directory entry in bytes, the entry name fills the rest of it
+             */
+            uint16_t entrySize;
+
+            /** @brief Number of entries in the directory
+             */
+            uint32_t entryCount;
+
+            /** @brief First sector behind the directory
+             */
+            uint32_t dataSector;
+        };
+
+        /** @brief Struct representing directory entry of a sound archive (.pak)
+         */
+        struct PackEntry
+        {
+            /** @brief Hash of the upper case entry name (see Pcm::HashName())
+             */
+            uint32_t nameHash;
+
+            /** @brief First sector of the entry from start of the archive
+             */
+            uint32_t firstSector;
+
+            /** @brief Size of the entry in bytes
+             */
+            uint32_t size;
+        };
+
+        /** @brief Magic of sound archives ('PPAK')
+         */
+        static constexpr uint32_t PACK_MAGIC = 0x5050414B;
+
+        /** @brief Current sound archive version
+         */
+        static constexpr uint16_t PACK_VERSION = 1;
         
 		/**
 		 * @brief Struct representing PCM sound parameters.
@@ -184,13 +433,200 @@ namespace SRL::Ponesound
 
 		static constexpr auto PCMEND = SNDRAM + 0x7F000;
 		static constexpr auto DRV_SYS_END = 47 * 1024;
+		static constexpr auto SECTOR_SIZE = 2048;
+		static constexpr auto SCSP_WORK_START = 0x408 + DRV_SYS_END + 0x20;
+		static constexpr auto SCSP_WORK_END = 0x7F800;
+		static constexpr auto VOICE_HANDLE_SHIFT = 7;
+		static constexpr auto LOAD_HISTORY = 8;
+		static constexpr auto DRIVER_FILE = "SDRV.BIN";
+		static constexpr auto PACK_FILE = "AUDIO.PAK";
+		static constexpr auto MAX_PACK_ENTRIES = 128;
+		static constexpr auto DRIVER_READY_TIMEOUT = 250;
+
+	public:
+		/**
+		 * @brief Constant description of a version 2 sound file, generated by PcmCompress.py next to the .snd
+		 *
+		 * Control slot values are precomputed, so loading a bank does no pitch or rate math. The table of contents
+		 * of the file is still checked against the manifest, a file packed after the manifest was built fails with -4.
+		 */
+		struct BankManifest
+		{
+			/** @brief Precomputed entry of one sample
+			 */
+			struct Sample
+			{
+				/** @brief Hash of the upper case PCM file name
+				 */
+				uint32_t nameHash;
+
+				/** @brief Offset of the payload from start of the file
+				 */
+				uint32_t fileOffset;
+
+				/** @brief Compressed PCM size (0 if stored uncompressed)
+				 */
+				uint32_t compressedSize;
+
+				/** @brief Original PCM size
+				 */
+				uint32_t originalSize;
+
+				/** @brief Offset in sound RAM from the start of the bank, when the bank is loaded as one run
+				 */
+				uint32_t soundRamOffset;
+
+				/** @brief Sample rate (ie 15360)
+				 */
+				uint16_t sampleRate;
+
+				/** @brief SCSP pitch word (octave and FNS)
+				 */
+				uint16_t pitchWord;
+
+				/** @brief Bytes played per NTSC frame
+				 */
+				uint16_t bytesPerBlank;
+
+				/** @brief Play size in samples
+				 */
+				uint16_t playSize;
+
+				/** @brief Bit Depth (PCM8 or PCM16)
+				 */
+				uint8_t bitDepth;
+
+				/** @brief Loop start in samples
+				 */
+				uint16_t loopStart;
+
+				/** @brief Loop end in samples (0 for the end of the sample)
+				 */
+				uint16_t loopEnd;
+
+				/** @brief Hash of the PCM data as it is stored in sound RAM
+				 */
+				uint32_t contentHash;
+			};
+
+			/** @brief Sound RAM left for samples after the driver
+			 */
+			static constexpr int32_t MAX_SOUND_RAM = SCSP_WORK_END - SCSP_WORK_START;
+
+			/** @brief Number of control slots
+			 */
+			static constexpr int16_t MAX_SAMPLES = PCM::CTRL_MAX;
+
+			/** @brief File name (.snd)
+			 */
+			const char* fileName;
+
+			/** @brief Samples in file order
+			 */
+			const Sample* samples;
+
+			/** @brief Number of samples
+			 */
+			int16_t count;
+
+			/** @brief Sound RAM needed by the whole bank
+			 */
+			uint32_t soundRamSize;
+		};
+
+		/**
+		 * @brief Where the time of one load went, see Stats::GetLoad()
+		 *
+		 * Times are in ticks of the SH-2 free running timer, Stats::ToMicroseconds() converts them.
+		 * Async loads only count time spent inside Loader::Update(), frames counts the whole wait.
+		 */
+		struct LoadProfile
+		{
+			/** @brief File that was loaded
+			 */
+			const char* fileName;
+
+			/** @brief Result of the load (< 0 if it failed)
+			 */
+			int32_t result;
+
+			/** @brief Bytes read from CD
+			 */
+			uint32_t bytesRead;
+
+			/** @brief Bytes written to sound RAM
+			 */
+			uint32_t bytesUploaded;
+
+			/** @brief Bytes of samples that were already in sound RAM and were not loaded again
+			 */
+			uint32_t bytesShared;
+
+			/** @brief Time spent waiting for CD
+			 */
+			uint32_t readTicks;
+
+			/** @brief Time spent in LZSS decoding
+			 */
+			uint32_t decodeTicks;
+
+			/** @brief Time spent copying to sound RAM
+			 */
+			uint32_t dmaTicks;
+
+			/** @brief Time spent in the load
+			 */
+			uint32_t totalTicks;
+
+			/** @brief Frames from start to end of the load
+			 */
+			uint32_t frames;
+		};
+
+		/**
+		 * @brief Where the time of the driver boot went, see Stats::GetBoot()
+		 *
+		 * Times are in ticks of the SH-2 free running timer, Stats::ToMicroseconds() converts them.
+		 */
+		struct BootProfile
+		{
+			/** @brief Size of the driver
+			 */
+			uint32_t driverBytes;
+
+			/** @brief Bytes of sound RAM cleared
+			 */
+			uint32_t clearedBytes;
+
+			/** @brief Time spent reading the driver from CD into sound RAM
+			 */
+			uint32_t loadTicks;
+
+			/** @brief Time spent clearing sound RAM
+			 */
+			uint32_t clearTicks;
+
+			/** @brief Time from starting the 68K until the driver published its control table
+			 */
+			uint32_t readyTicks;
+
+			/** @brief Time spent in the boot
+			 */
+			uint32_t totalTicks;
+
+			/** @brief Whether the driver reported ready before DRIVER_READY_TIMEOUT ran out
+			 */
+			bool ready;
+		};
+
+	private:
 
 		/**
 		 * @brief Struct representing ADX parameters.
 		 */
 		struct ADX
 		{
-			// static constexpr auto STREAM = -3;
+			static constexpr auto STREAM = -3;
 			static constexpr auto MASTER_768 = 0;
 			static constexpr auto MASTER_1152 = 1;
 			static constexpr auto MASTER_1536 = 2;
@@ -250,6 +686,109 @@ namespace SRL::Ponesound
 			uint8_t illegal;
 		};
 
+		/**
+		 * @brief Struct representing loop info of version 3 and 4 ADX headers.
+		 */
+		struct AdxLoopInfo
+		{
+			uint16_t alignmentSamples;
+			uint16_t enabledShort;
+			uint32_t enabled;
+			uint32_t beginSample;
+			uint32_t beginByte;
+			uint32_t endSample;
+			uint32_t endByte;
+		};
+
+		/** @brief Convert field read from a file to host byte order, files are big endian like the SH-2
+		 * @note Does nothing on the Saturn, only little endian host builds (tests/host) swap
+		 */
+		template <typename T>
+		static constexpr T FromBigEndian(T value)
+		{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+			if constexpr (sizeof(T) == 2) return (T)__builtin_bswap16((uint16_t)value);
+			if constexpr (sizeof(T) == 4) return (T)__builtin_bswap32((uint32_t)value);
+#endif
+			return value;
+		}
+
+		/** @brief Convert header read from a file to host byte order
+		 * @return The header
+		 */
+		static SndHeader& ToHostOrder(SndHeader& header)
+		{
+			header.magic = FromBigEndian(header.magic);
+			header.version = FromBigEndian(header.version);
+			header.entryCount = FromBigEndian(header.entryCount);
+			header.entrySize = FromBigEndian(header.entrySize);
+			header.soundRamSize = FromBigEndian(header.soundRamSize);
+			header.payloadOffset = FromBigEndian(header.payloadOffset);
+			return header;
+		}
+
+		static SndEntry& ToHostOrder(SndEntry& entry)
+		{
+			entry.nameHash = FromBigEndian(entry.nameHash);
+			entry.offset = FromBigEndian(entry.offset);
+			entry.compressedSize = FromBigEndian(entry.compressedSize);
+			entry.originalSize = FromBigEndian(entry.originalSize);
+			entry.sampleRate = FromBigEndian(entry.sampleRate);
+			entry.loopStart = FromBigEndian(entry.loopStart);
+			entry.loopEnd = FromBigEndian(entry.loopEnd);
+			entry.contentHash = FromBigEndian(entry.contentHash);
+			return entry;
+		}
+
+		static PcmHeader& ToHostOrder(PcmHeader& header)
+		{
+			header.bitDepth = FromBigEndian(header.bitDepth);
+			header.sampleRate = FromBigEndian(header.sampleRate);
+			header.compressedSize = FromBigEndian(header.compressedSize);
+			header.originalSize = FromBigEndian(header.originalSize);
+			return header;
+		}
+
+		static PackHeader& ToHostOrder(PackHeader& header)
+		{
+			header.magic = FromBigEndian(header.magic);
+			header.version = FromBigEndian(header.version);
+			header.entrySize = FromBigEndian(header.entrySize);
+			header.entryCount = FromBigEndian(header.entryCount);
+			header.dataSector = FromBigEndian(header.dataSector);
+			return header;
+		}
+
+		static PackEntry& ToHostOrder(PackEntry& entry)
+		{
+			entry.nameHash = FromBigEndian(entry.nameHash);
+			entry.firstSector = FromBigEndian(entry.firstSector);
+			entry.size = FromBigEndian(entry.size);
+			return entry;
+		}
+
+		static AdxHeader& ToHostOrder(AdxHeader& header)
+		{
+			header.oneHalf = FromBigEndian(header.oneHalf);
+			header.offset2Data = FromBigEndian(header.offset2Data);
+			header.sampleRate = FromBigEndian(header.sampleRate);
+			header.sampleCount = FromBigEndian(header.sampleCount);
+			header.highPassCutOff = FromBigEndian(header.highPassCutOff);
+			return header;
+		}
+
+		static AdxLoopInfo& ToHostOrder(AdxLoopInfo& loopInfo)
+		{
+			loopInfo.alignmentSamples = FromBigEndian(loopInfo.alignmentSamples);
+			loopInfo.enabledShort = FromBigEndian(loopInfo.enabledShort);
+			loopInfo.enabled = FromBigEndian(loopInfo.enabled);
+			loopInfo.beginSample = FromBigEndian(loopInfo.beginSample);
+			loopInfo.beginByte = FromBigEndian(loopInfo.beginByte);
+			loopInfo.endSample = FromBigEndian(loopInfo.endSample);
+			loopInfo.endByte = FromBigEndian(loopInfo.endByte);
+			return loopInfo;
+		}
+
 		static inline constexpr int32_t LogaritmicTable[] = {
 		 0,
 		 1,
@@ -272,9 +811,8 @@ namespace SRL::Ponesound
 		};
 
 		static inline auto& m68kCommands = *reinterpret_cast<SystemCommandParameters*> ((SNDPRG + DRV_SYS_END) | 0x20000000);
-		static inline auto scspWorkStart = reinterpret_cast<uint32_t*> (0x408 + DRV_SYS_END + 0x20);
+		static inline auto scspWorkStart = reinterpret_cast<uint32_t*> (SCSP_WORK_START);
 		static inline auto& masterVolume = *reinterpret_cast<uint16_t*> (SNDRAM + 0x100400);
-		static inline uint32_t* scspWorkAddr;
 		static inline uint16_t driverMasterVolume = 0;
 		static inline int16_t numberOfPCMs = 0;
 
@@ -294,453 +832,6932 @@ namespace SRL::Ponesound
 
         static void SdrvVblankRq(void)
         {
+            ReadBack();
+            ApplyCommands();
+            UpdateEnvelopes();
+            frameCounter = frameCounter + 1;
+            PcmStream::TrackAll();
+            AdxStream::Track();
+            SlaveAdxStream::TrackAll();
+            PushShadow();
             m68kCommands.start = 1;
         }
 
-		static void LoadDriver(int32_t masterAdxFrequency)
+		/** @brief Profile of the last driver boot
+		 */
+		static inline BootProfile driverBoot = {};
+
+		/** @brief Zero part of sound RAM by DMA
+		 * @param offset Offset from the start of sound RAM (4 byte aligned)
+		 * @param size Number of bytes to clear (multiple of 4)
+		 */
+		static void ClearSoundRam(uint32_t offset, uint32_t size)
+		{
+			// Source stays on one zero word, transfer count is in long words
+			static const uint32_t zero = 0;
+			slDMAWait();
+			uint32_t status = MaskInterrupts();
+			slDMAWait();
+			slDMAXCopy((void*)&zero, (void*)(SNDRAM + offset), size >> 2, Sfix_Dinc_Long);
+			RestoreInterrupts(status);
+			slDMAWait();
+		}
+
+		/** @brief Load driver into sound RAM, start the 68K and wait until the driver is up
+		 * @param masterAdxFrequency ADX mode (index into adxCoeficientTable)
+		 * @param clearSampleArea Clear the part of sound RAM samples are loaded into, skip if everything there gets loaded over anyway
+		 * @return true once the driver published its control table, false if the driver is missing or did not answer in time
+		 */
+		static bool LoadDriver(int32_t masterAdxFrequency, bool clearSampleArea = true)
 		{
+			TimerStamp last = ReadTimer();
+			driverBoot = BootProfile{};
+
 			*(uint8_t*)(0x25B00400) = 0x02;
 
-            // clear sound ram
- 			for (int32_t i = 0; i < 0x80000; i += 4)
+			int32_t firstSector, sectors, lastSize;
+			GfsHandle handle = OpenCdFile(DRIVER_FILE, firstSector, sectors, lastSize);
+			if (handle == nullptr) return false;
+
+			driverBoot.driverBytes = ((sectors - 1) * SECTOR_SIZE) + lastSize;
+
+			SRL::SMPC::DisableSoundCPU();
+
+			// Whole sectors go straight into sound RAM, the garbage behind the driver is cleared below
+			GFS_NwFread(handle, sectors, (void*)SNDRAM, sectors * SECTOR_SIZE);
+
+			do
 			{
-				*(uint32_t*)(SNDRAM + i) = 0x00000000;
+				GFS_NwExecOne(handle);
+				AddTicks(last, driverBoot.loadTicks);
 			}
+			while (!GFS_NwIsComplete(handle));
 
-			SRL::Cd::File file("SDRV.BIN");
-		    if (file.Open())
-		    {
-                SRL::SMPC::DisableSoundCPU();
-                file.Read(file.Size.Bytes, (void*)SNDRAM);
-                m68kCommands.driverAdxCoeficient1 = adxCoeficientTable[masterAdxFrequency][0];
-                m68kCommands.driverAdxCoeficient2 = adxCoeficientTable[masterAdxFrequency][1];
-                SRL::SMPC::EnableSoundCPU();
-            }
+			GFS_Close(handle);
+
+			uint32_t driverEnd = (driverBoot.driverBytes + 3) & ~3;
+
+			for (uint32_t i = driverBoot.driverBytes; i < driverEnd; i++)
+			{
+				*(uint8_t*)(SNDRAM + i) = 0;
+			}
+
+			// Driver work area and the system command block are always cleared, the driver expects them zeroed
+			if (clearSampleArea)
+			{
+				driverBoot.clearedBytes = 0x80000 - driverEnd;
+				ClearSoundRam(driverEnd, driverBoot.clearedBytes);
+			}
+			else
+			{
+				driverBoot.clearedBytes = (SCSP_WORK_START - driverEnd) + (0x80000 - SCSP_WORK_END);
+				ClearSoundRam(driverEnd, SCSP_WORK_START - driverEnd);
+				ClearSoundRam(SCSP_WORK_END, 0x80000 - SCSP_WORK_END);
+			}
 
+			AddTicks(last, driverBoot.clearTicks);
+
+			m68kCommands.driverAdxCoeficient1 = adxCoeficientTable[masterAdxFrequency][0];
+			m68kCommands.driverAdxCoeficient2 = adxCoeficientTable[masterAdxFrequency][1];
+			SRL::SMPC::EnableSoundCPU();
 			m68kCommands.start = 0xFFFF;
-			scspWorkAddr = scspWorkStart;
-			volatile int32_t i = reinterpret_cast<int32_t>(scspWorkAddr);
-            // appears to be for ADX playback
-			while (i) { i = i - 1; }
+
+			// Control table address stays null until the driver is through its setup
+			uint32_t timeout = (GetTimerRate() / 1000) * DRIVER_READY_TIMEOUT;
+
+			while (m68kCommands.pcmCtrl == nullptr && driverBoot.readyTicks < timeout)
+			{
+				AddTicks(last, driverBoot.readyTicks);
+			}
+
+			driverBoot.ready = m68kCommands.pcmCtrl != nullptr;
+			driverBoot.totalTicks = driverBoot.loadTicks + driverBoot.clearTicks + driverBoot.readyTicks;
+
 			numberOfPCMs = 0;
+			ResetSoundRam();
+
+			// Only fields the SH-2 owns are kept here, the rest are read back while needed
+			systemShadow.pcmCtrl = m68kCommands.pcmCtrl;
+			systemShadow.cddaLeftChannelVolPan = m68kCommands.cddaLeftChannelVolPan;
+			systemShadow.cddaRightChannelVolPan = m68kCommands.cddaRightChannelVolPan;
+			systemShadow.adxBufferPass[0] = 0;
+			systemShadow.adxBufferPass[1] = 0;
+			systemDirty = false;
+			return driverBoot.ready;
 		}
 
-		static int16_t CalculateBytesPerBlank(int32_t sampleRate, bool is8Bit, bool isPAL)
+		static constexpr int16_t CalculateBytesPerBlank(int32_t sampleRate, bool is8Bit, bool isPAL)
 		{
 			int32_t frameCount = isPAL ? 50 : 60;
 			int32_t sampleSize = is8Bit ? 8 : 16;
 			return ((sampleRate * sampleSize) >> 3) / frameCount;
 		}
 
-		static int16_t ConvertBitrateToPitchWord(int16_t sampleRate)
+		static constexpr int16_t ConvertBitrateToPitchWord(int32_t sampleRate)
 		{
 			int32_t octr = ((int32_t)LogaritmicTable[PCM::SCSP_FREQUENCY / ((sampleRate)+1)]);
 			int32_t shiftr = PCM::SCSP_FREQUENCY >> octr;
 			int32_t fnsr = ((((sampleRate)-(shiftr)) << 10) / (shiftr));
 			return ((int32_t)((ExtractLeastSignificantBits<4>(-(octr)) << 11) | ExtractLeastSignificantBits<10>(fnsr)));
+		}
+
+		/** @brief Check that a sample rate stays inside LogaritmicTable and the SCSP pitch range
+		 * @param sampleRate Sample rate
+		 */
+		static constexpr bool IsValidSampleRate(int32_t sampleRate)
+		{
+			return sampleRate > 0 && sampleRate <= PCM::SCSP_FREQUENCY &&
+				PCM::SCSP_FREQUENCY / (sampleRate + 1) < (int32_t)(sizeof(LogaritmicTable) / sizeof(LogaritmicTable[0]));
+		}
+
+		/** @brief Check sound file entry before anything is allocated for it
+		 * @param entry Entry from the table of contents (or built from a version 1 header)
+		 * @param payloadStart Offset of the payload in the file
+		 * @param fileSize Size of the file
+		 */
+		static constexpr bool IsValidSndEntry(const SndEntry& entry, int32_t payloadStart, int32_t fileSize)
+		{
+			// playSize is 16 bits wide and counts samples
+			uint32_t maxSize = entry.bitDepth == (uint8_t)BitDepth::PCM16 ? 0x20000 : 0x10000;
+			uint32_t payloadSize = entry.compressedSize != 0 ? entry.compressedSize : entry.originalSize;
+
+			uint32_t samples = entry.bitDepth == (uint8_t)BitDepth::PCM16 ? entry.originalSize >> 1 : entry.originalSize;
+			uint32_t loopEnd = entry.loopEnd != 0 ? entry.loopEnd : samples;
+
+			return entry.bitDepth <= (uint8_t)BitDepth::PCM8 && IsValidSampleRate(entry.sampleRate) &&
+				entry.originalSize > 0 && entry.originalSize <= maxSize &&
+				loopEnd <= samples && entry.loopStart < loopEnd &&
+				payloadStart >= 0 && payloadStart <= fileSize && payloadSize <= (uint32_t)(fileSize - payloadStart);
+		}
+
+		/** @brief Check ADX header for a format the driver decodes (mono, 4 bit, 18 byte blocks)
+		 * @param header ADX header
+		 */
+		static constexpr bool IsValidAdxHeader(const AdxHeader& header)
+		{
+			return header.oneHalf == 32768 && header.blockSize == 18 && header.bitDepth == 4 && header.channels == 1 &&
+				header.offset2Data >= (int16_t)(sizeof(AdxHeader) - 4) && IsValidSampleRate(header.sampleRate) && header.sampleCount > 0;
 		}
-		        /** @brief Register sample and update SCSP work address
-        */
-        static int16_t RegisterPcm(int32_t fileSize, BitDepth bitDepth, int32_t sampleRate)
-        {
-            m68kCommands.pcmCtrl[numberOfPCMs].hiAddrBits = (uint16_t)((uint32_t)scspWorkAddr >> 16);
-            m68kCommands.pcmCtrl[numberOfPCMs].loAddrBits = (uint16_t)((uint32_t)scspWorkAddr & 0xFFFF);
-            m68kCommands.pcmCtrl[numberOfPCMs].pitchWord    = ConvertBitrateToPitchWord(sampleRate);
-
-            if (bitDepth == BitDepth::PCM16)
-            {
-                m68kCommands.pcmCtrl[numberOfPCMs].bytesPerBlank = CalculateBytesPerBlank(sampleRate, false, PCM::SYS_REGION);
-                m68kCommands.pcmCtrl[numberOfPCMs].playSize = (fileSize >> 1);
-                m68kCommands.pcmCtrl[numberOfPCMs].bitDepth = PCM::TYPE_16BIT;
-            }
-            else if (bitDepth == BitDepth::PCM8) {
-                m68kCommands.pcmCtrl[numberOfPCMs].bytesPerBlank = CalculateBytesPerBlank(sampleRate, true, PCM::SYS_REGION);
-                m68kCommands.pcmCtrl[numberOfPCMs].playSize = (fileSize);
-                m68kCommands.pcmCtrl[numberOfPCMs].bitDepth = PCM::TYPE_8BIT;
-            }
-
-            m68kCommands.pcmCtrl[numberOfPCMs].loopType = 0;
-            m68kCommands.pcmCtrl[numberOfPCMs].volume = 7;
-
-            numberOfPCMs++;
-            scspWorkAddr = (uint32_t*)((uint32_t)scspWorkAddr + fileSize);
+		        /** @brief Register sample in a free control slot
+         * @param address Sound RAM address of the sample (from AllocateSoundRam())
+         * @param fileSize Size of the sample in bytes
+         * @param bitDepth Bit depth of the sample
+         * @param sampleRate Sample rate of the sample
+         * @return Sound effect identifier
+        */
+        static int16_t RegisterPcm(uint32_t address, int32_t fileSize, BitDepth bitDepth, int32_t sampleRate)
+        {
+            // Octave and FNS field of the SCSP pitch register, and bytes one NTSC frame plays
+            static_assert(ConvertBitrateToPitchWord(44100) == 0, "44.1 kHz plays at octave 0");
+            static_assert(ConvertBitrateToPitchWord(22050) == 0x7800, "22.05 kHz plays at octave -1");
+            static_assert(ConvertBitrateToPitchWord(15360) == 0x7192, "15.36 kHz plays at octave -2");
+            static_assert(CalculateBytesPerBlank(15360, false, false) == 512 && CalculateBytesPerBlank(15360, true, false) == 256);
+
+            bool is8Bit = bitDepth == BitDepth::PCM8;
+            return RegisterSample(
+                address,
+                bitDepth,
+                ConvertBitrateToPitchWord(sampleRate),
+                CalculateBytesPerBlank(sampleRate, is8Bit, PCM::SYS_REGION),
+                is8Bit ? fileSize : (fileSize >> 1));
+        }
+
+        /** @brief Register sample with precomputed control values in a free control slot
+         * @param address Sound RAM address of the sample (from AllocateSoundRam())
+         * @param bitDepth Bit depth of the sample
+         * @param pitchWord SCSP pitch word
+         * @param bytesPerBlank Bytes played per frame
+         * @param playSize Play size in samples
+         * @return Sound effect identifier
+         */
+        static int16_t RegisterSample(uint32_t address, BitDepth bitDepth, uint16_t pitchWord, uint16_t bytesPerBlank, uint16_t playSize)
+        {
+            int16_t sound = AcquireSlot();
+
+            ctrlShadow[sound].hiAddrBits = (uint16_t)(address >> 16);
+            ctrlShadow[sound].loAddrBits = (uint16_t)(address & 0xFFFF);
+            ctrlShadow[sound].pitchWord = pitchWord;
+            ctrlShadow[sound].bytesPerBlank = bytesPerBlank;
+            ctrlShadow[sound].playSize = playSize;
+            ctrlShadow[sound].bitDepth = bitDepth == BitDepth::PCM8 ? PCM::TYPE_8BIT : PCM::TYPE_16BIT;
+            ctrlShadow[sound].loopType = 0;
+            ctrlShadow[sound].volume = 7;
+            MarkDirty(sound);
 
-            return (numberOfPCMs - 1);
+            AssignSoundRam(address, sound);
+            InitVoice(sound, Voice::DEFAULT_INSTANCES);
+            return sound;
         }
 
-	public:
-		/** @brief Returns current number of PCMs
-		 */
-        static int16_t GetNumberOfPCMs()
-        {
-            return (numberOfPCMs - 1);
-        }
-        
-		/** @brief Hardware settings and Driver initialization
-		 */
-		struct Driver
-		{
-		    /**
-			 * @brief Initializes the sound driver.
-			 * @param mode ADX data mode.
+
+        /** @brief Register ADX sample in a free control slot
+         * @param header ADX header of the sample
+         * @param workAddress Sound RAM address of the first ADX block (inside a block from AllocateSoundRam())
+         * @param playSize Number of ADX blocks the driver plays from workAddress
+         * @return Sound effect identifier (-3 if sample rate is not supported by the driver)
+         */
+        static int16_t RegisterAdx(const AdxHeader& header, uint32_t workAddress, uint16_t playSize)
+        {
+            // Dictionary of every accepted rate has to fit the 16 bit decompressionSize
+            static_assert((CalculateLCM(768, 768 + 64) << 1) == 19968 && (CalculateLCM(512, 512 + 64) << 1) == 9216);
+            static_assert((CalculateLCM(384, 384 + 64) << 1) == 5376 && (CalculateLCM(256, 256 + 64) << 1) == 2560);
+
+            int16_t bytesPerBlank = CalculateBytesPerBlank((int32_t)header.sampleRate, false, PCM::SYS_REGION);
+
+            if (bytesPerBlank != 768 && bytesPerBlank != 512 && bytesPerBlank != 384 && bytesPerBlank != 256 && bytesPerBlank != 192 && bytesPerBlank != 128)
+            {
+                return -3;
+            }
+
+            int16_t sound = AcquireSlot();
+
+            ctrlShadow[sound].hiAddrBits = (uint16_t)((uint32_t)workAddress >> 16);
+            ctrlShadow[sound].loAddrBits = (uint16_t)((uint32_t)workAddress & 0xFFFF);
+            ctrlShadow[sound].pitchWord = ConvertBitrateToPitchWord(header.sampleRate);
+            ctrlShadow[sound].playSize = playSize;
+            ctrlShadow[sound].bytesPerBlank = bytesPerBlank;
+            uint16_t bigDictionarySize = (bytesPerBlank >= 256) ? CalculateLCM(bytesPerBlank, bytesPerBlank + 64) << 1 : 5376;
+            ctrlShadow[sound].decompressionSize = (bigDictionarySize > (header.sampleCount << 1)) ? header.sampleCount << 1 : bigDictionarySize;
+            ctrlShadow[sound].bitDepth = PCM::TYPE_ADX;
+            ctrlShadow[sound].loopType = PlayMode::Semi;
+            ctrlShadow[sound].volume = 7;
+            MarkDirty(sound);
+
+            AssignSoundRam(workAddress, sound);
+            InitVoice(sound, 1);
+            return sound;
+        }
+
+    public:
+        /** @brief Allocated region of sound RAM, see Stats::GetBlock()
+         */
+        struct SoundRamBlock
+        {
+            /** @brief Sound RAM address (offset from start of sound RAM)
+             */
+            uint32_t address;
+
+            /** @brief Size in bytes (multiple of 4)
+             */
+            uint32_t size;
+
+            /** @brief Control slot using this block (-1 while reserved by a load in progress)
+             */
+            int16_t sound;
+
+            /** @brief Block is written by a stream and must not be moved by SoundRam::Compact()
+             */
+            bool locked;
+        };
+
+    private:
+
+        /** @brief Allocated blocks sorted by address, everything between them is free
+         */
+        static inline SoundRamBlock soundRamBlocks[PCM::CTRL_MAX];
+
+        /** @brief Number of allocated blocks
+         */
+        static inline int16_t soundRamBlockCount = 0;
+
+        /** @brief Control slots below numberOfPCMs that were freed and can be given out again
+         */
+        static inline bool releasedSlots[PCM::CTRL_MAX];
+
+        /** @brief Number of entries set in releasedSlots
+         */
+        static inline int16_t releasedSlotCount = 0;
+
+        /** @brief Content hash of the data each sample plays (0 if unknown), see SndEntry::contentHash
+         */
+        static inline uint32_t sampleHashes[PCM::CTRL_MAX];
+
+        /** @brief Forget all allocations and control slots
+         */
+        static void ResetSoundRam()
+        {
+            soundRamBlockCount = 0;
+            releasedSlotCount = 0;
+
+            for (bool& released : releasedSlots)
+            {
+                released = false;
+            }
+
+            for (VoiceState& voice : voices)
+            {
+                voice.sample = -1;
+                voice.ends = 0;
+            }
+
+            for (int16_t slot = 0; slot < PCM::CTRL_MAX; slot++)
+            {
+                ctrlShadow[slot] = PCM::CTRL{};
+                ctrlDirty[slot] = 0;
+                sampleHashes[slot] = 0;
+                voiceCommands[slot].flags = 0;
+            }
+
+            queuedCommands = 0;
+        }
+
+        /** @brief Number of control slots that can still be acquired, finished extra instances are given back first
+         */
+        static int16_t GetFreeSlots()
+        {
+            ReclaimVoices();
+            return (PCM::CTRL_MAX - numberOfPCMs) + releasedSlotCount;
+        }
+
+        /** @brief Take lowest free control slot
+         * @return Control slot index (-1 if none is left)
+         */
+        static int16_t AcquireSlot()
+        {
+            if (releasedSlotCount > 0)
+            {
+                for (int16_t sound = 0; sound < numberOfPCMs; sound++)
+                {
+                    if (releasedSlots[sound])
+                    {
+                        releasedSlots[sound] = false;
+                        releasedSlotCount--;
+                        return sound;
+                    }
+                }
+            }
+
+            return numberOfPCMs < PCM::CTRL_MAX ? numberOfPCMs++ : -1;
+        }
+
+        /** @brief Silence control slot and give it back, trailing free slots are trimmed from numberOfPCMs
+         * @param sound Control slot index
+         */
+        static void ReleaseSlot(int16_t sound)
+        {
+            voiceCommands[sound].flags = 0;
+            QueueCommand(sound, COMMAND_HALT | COMMAND_VOLUME, 0);
+            voices[sound].sample = -1;
+            voices[sound].ends = 0;
+            sampleHashes[sound] = 0;
+            releasedSlots[sound] = true;
+            releasedSlotCount++;
+
+            while (numberOfPCMs > 0 && releasedSlots[numberOfPCMs - 1])
+            {
+                numberOfPCMs--;
+                releasedSlots[numberOfPCMs] = false;
+                releasedSlotCount--;
+            }
+        }
+
+        /** @brief Find block that contains an address
+         * @param address Sound RAM address
+         * @return Block index (-1 if address is not allocated)
+         */
+        static int16_t FindSoundRamBlock(uint32_t address)
+        {
+            for (int16_t block = 0; block < soundRamBlockCount; block++)
+            {
+                if (address >= soundRamBlocks[block].address && address < soundRamBlocks[block].address + soundRamBlocks[block].size)
+                {
+                    return block;
+                }
+            }
+
+            return -1;
+        }
+
+        /** @brief Find block used by a control slot
+         * @param sound Control slot index
+         * @return Block index (-1 if slot has no sound RAM)
+         */
+        static int16_t FindSoundRamBlock(int16_t sound)
+        {
+            for (int16_t block = 0; block < soundRamBlockCount; block++)
+            {
+                if (soundRamBlocks[block].sound == sound)
+                {
+                    return block;
+                }
+            }
+
+            return -1;
+        }
+
+        /** @brief Allocate sound RAM from the smallest free gap that fits
+         * @param size Number of bytes needed (rounded up to 4 bytes)
+         * @param locked Block is written by a stream and must stay in place
+         * @return Sound RAM address (0 if there is no gap large enough)
+         */
+        static uint32_t AllocateSoundRam(int32_t size, bool locked = false)
+        {
+            if (size <= 0 || soundRamBlockCount >= PCM::CTRL_MAX) return 0;
+
+            uint32_t alignedSize = (uint32_t)AlignSize(size);
+            uint32_t bestAddress = 0;
+            uint32_t bestSize = 0xFFFFFFFF;
+            int16_t bestIndex = 0;
+            uint32_t gapStart = SCSP_WORK_START;
+
+            for (int16_t block = 0; block <= soundRamBlockCount; block++)
+            {
+                uint32_t gapEnd = block < soundRamBlockCount ? soundRamBlocks[block].address : SCSP_WORK_END;
+                uint32_t gapSize = gapEnd - gapStart;
+
+                if (gapSize >= alignedSize && gapSize < bestSize)
+                {
+                    bestAddress = gapStart;
+                    bestSize = gapSize;
+                    bestIndex = block;
+                }
+
+                if (block < soundRamBlockCount)
+                {
+                    gapStart = soundRamBlocks[block].address + soundRamBlocks[block].size;
+                }
+            }
+
+            if (bestAddress == 0) return 0;
+
+            for (int16_t block = soundRamBlockCount; block > bestIndex; block--)
+            {
+                soundRamBlocks[block] = soundRamBlocks[block - 1];
+            }
+
+            soundRamBlocks[bestIndex] = SoundRamBlock{ bestAddress, alignedSize, -1, locked };
+            soundRamBlockCount++;
+            return bestAddress;
+        }
+
+        /** @brief Mark block as used by a control slot, a block that already has an owner keeps it
+         * @param address Any address inside the block
+         * @param sound Control slot index
+         */
+        static void AssignSoundRam(uint32_t address, int16_t sound)
+        {
+            int16_t block = FindSoundRamBlock(address);
+            if (block >= 0 && soundRamBlocks[block].sound < 0) soundRamBlocks[block].sound = sound;
+        }
+
+        /** @brief Get sound RAM address a control slot plays from
+         * @param sound Control slot index
+         */
+        static uint32_t GetSampleAddress(int16_t sound)
+        {
+            return ((uint32_t)ctrlShadow[sound].hiAddrBits << 16) | ctrlShadow[sound].loAddrBits;
+        }
+
+        /** @brief Find sample other than the block owner that plays data inside a block
+         * @param block Block index
+         * @param first First control slot to look at
+         * @return Control slot (-1 if no other sample shares the block)
+         */
+        static int16_t FindBlockSharer(int16_t block, int16_t first = 0)
+        {
+            const SoundRamBlock& current = soundRamBlocks[block];
+
+            for (int16_t sound = first; sound < numberOfPCMs; sound++)
+            {
+                uint32_t address = GetSampleAddress(sound);
+
+                if (sound != current.sound && voices[sound].sample == sound &&
+                    address >= current.address && address < current.address + current.size)
+                {
+                    return sound;
+                }
+            }
+
+            return -1;
+        }
+
+        /** @brief Return block to the free space
+         * @param address Any address inside the block
+         */
+        static void ReleaseSoundRam(uint32_t address)
+        {
+            int16_t block = FindSoundRamBlock(address);
+            if (block < 0) return;
+
+            soundRamBlockCount--;
+
+            for (; block < soundRamBlockCount; block++)
+            {
+                soundRamBlocks[block] = soundRamBlocks[block + 1];
+            }
+        }
+
+        /** @brief Release control slot and its sound RAM, sound RAM shared with another sample is handed over to it
+         * @param sound Control slot index
+         */
+        static void ReleaseSound(int16_t sound)
+        {
+            ReleaseInstances(sound);
+
+            int16_t block = FindSoundRamBlock(sound);
+
+            if (block >= 0)
+            {
+                int16_t heir = FindBlockSharer(block);
+
+                if (heir >= 0)
+                {
+                    soundRamBlocks[block].sound = heir;
+                }
+                else
+                {
+                    ReleaseSoundRam(soundRamBlocks[block].address);
+                }
+            }
+
+            ReleaseSlot(sound);
+        }
+
+        /** @brief Stop and give back extra instance slots of a sample
+         * @param sample Control slot of the sample
+         */
+        static void ReleaseInstances(int16_t sample)
+        {
+            for (int16_t slot = numberOfPCMs - 1; slot >= 0; slot--)
+            {
+                if (slot < numberOfPCMs && slot != sample && voices[slot].sample == sample)
+                {
+                    ReleaseSlot(slot);
+                }
+            }
+        }
+
+        /** @brief Playback state of a control slot
+         */
+        struct VoiceState
+        {
+            /** @brief Sample whose data the slot plays (-1 if slot is free, equal to the slot on the sample's own slot)
+             */
+            int16_t sample;
+
+            /** @brief Bumped on every start, so old instance handles stop matching
+             */
+            uint8_t generation;
+
+            /** @brief Priority of the current instance (higher wins)
+             */
+            uint8_t priority;
+
+            /** @brief Maximum number of instances playing at once (only used on the sample's own slot)
+             */
+            uint8_t maxInstances;
+
+            /** @brief Volume of the current instance
+             */
+            uint8_t volume;
+
+            /** @brief Loop type the slot was last started with
+             */
+            int8_t mode;
+
+            /** @brief Frame the current instance started on
+             */
+            uint32_t started;
+
+            /** @brief Frame the current instance is done on (0xFFFFFFFF while looping)
+             */
+            uint32_t ends;
+
+            /** @brief Play size of the whole sample, the control slot's playSize stops earlier at a loop end
+             */
+            uint16_t length;
+
+            /** @brief Pan last given to the slot
+             */
+            uint8_t pan;
+        };
+
+        /** @brief Playback state of each control slot
+         */
+        static inline VoiceState voices[PCM::CTRL_MAX];
+
+        /** @brief Number of vertical blanks since driver start
+         */
+        static inline volatile uint32_t frameCounter = 0;
+
+        /** @brief Maximum number of voices started by Pcm::Play() that play at once
+         */
+        static inline int16_t voiceLimit = 32;
+
+        /** @brief How a voice is picked when one has to be stolen
+         */
+        static inline StealMode voiceStealMode = StealMode::Oldest;
+
+        /** @brief Set up voice state of a freshly registered sample
+         * @param sound Control slot of the sample
+         * @param maxInstances Maximum number of instances playing at once
+         */
+        static void InitVoice(int16_t sound, uint8_t maxInstances)
+        {
+            voices[sound] = VoiceState{ sound, voices[sound].generation, 0, maxInstances, 7, ctrlShadow[sound].loopType, 0, 0, ctrlShadow[sound].playSize, ctrlShadow[sound].pan };
+        }
+
+        /** @brief Check whether slot is still playing an instance started by Pcm::Play()
+         * @param slot Control slot index
+         */
+        static bool IsVoiceActive(int16_t slot)
+        {
+            return voices[slot].sample >= 0 && voices[slot].ends > frameCounter;
+        }
+
+        /** @brief Estimate number of frames a one shot sample plays for
+         * @param slot Control slot index
+         */
+        static uint32_t EstimateVoiceFrames(int16_t slot)
+        {
+            const PCM::CTRL& ctrl = ctrlShadow[slot];
+            if (ctrl.bytesPerBlank == 0) return 1;
+
+            uint32_t bytes = ctrl.playSize;
+            bytes = ctrl.bitDepth == PCM::TYPE_16BIT ? bytes << 1 : bytes;
+            bytes = ctrl.bitDepth == PCM::TYPE_ADX ? bytes * 64 : bytes; // 32 samples of 16 bit output per block
+
+            return (bytes / ctrl.bytesPerBlank) + 1;
+        }
+
+        /** @brief Count active instances
+         * @param sample Sample to count instances of (-1 for all samples)
+         */
+        static int16_t CountVoices(int16_t sample)
+        {
+            int16_t count = 0;
+
+            for (int16_t slot = 0; slot < numberOfPCMs; slot++)
+            {
+                if (IsVoiceActive(slot) && (sample < 0 || voices[slot].sample == sample)) count++;
+            }
+
+            return count;
+        }
+
+        /** @brief Pick active voice to steal
+         * @param sample Only consider instances of this sample (-1 for any sample)
+         * @param priority Priority of the new instance, voices above it are kept
+         * @param clonesOnly Only consider extra instance slots, not the samples' own slots
+         * @return Control slot index (-1 if nothing can be stolen)
+         */
+        static int16_t FindVictim(int16_t sample, uint8_t priority, bool clonesOnly)
+        {
+            int16_t victim = -1;
+
+            for (int16_t slot = 0; slot < numberOfPCMs; slot++)
+            {
+                const VoiceState& voice = voices[slot];
+
+                if (!IsVoiceActive(slot) || voice.priority > priority ||
+                    (sample >= 0 && voice.sample != sample) || (clonesOnly && voice.sample == slot))
+                {
+                    continue;
+                }
+
+                if (victim < 0 || voice.priority < voices[victim].priority)
+                {
+                    victim = slot;
+                }
+                else if (voice.priority == voices[victim].priority)
+                {
+                    bool quieter = voice.volume < voices[victim].volume;
+                    bool older = voice.started < voices[victim].started;
+
+                    if (voiceStealMode == StealMode::Quietest ? (quieter || (voice.volume == voices[victim].volume && older)) : older)
+                    {
+                        victim = slot;
+                    }
+                }
+            }
+
+            return victim;
+        }
+
+        /** @brief Stop instance playing on a slot
+         * @param slot Control slot index
+         */
+        static void StopVoice(int16_t slot)
+        {
+            if (voices[slot].mode <= 0)
+            {
+                QueueCommand(slot, COMMAND_VOLUME, 0);
+            }
+            else
+            {
+                QueueCommand(slot, COMMAND_HALT);
+            }
+
+            voices[slot].ends = 0;
+        }
+
+        /** @brief Take free control slot for an extra instance of a sample
+         * @param sample Sample to play
+         * @return Control slot index (-1 if there is no free slot)
+         */
+        static int16_t CloneVoice(int16_t sample)
+        {
+            int16_t slot = AcquireSlot();
+            if (slot < 0) return -1;
+
+            // Slot was halted when it was released, driver owned fields are left alone
+            const PCM::CTRL& source = ctrlShadow[sample];
+            PCM::CTRL& target = ctrlShadow[slot];
+            target.loopType = source.loopType;
+            target.bitDepth = source.bitDepth;
+            target.hiAddrBits = source.hiAddrBits;
+            target.loAddrBits = source.loAddrBits;
+            target.LSA = source.LSA;
+            target.playSize = source.playSize;
+            target.pitchWord = source.pitchWord;
+            target.pan = source.pan;
+            target.volume = source.volume;
+            target.bytesPerBlank = source.bytesPerBlank;
+            target.decompressionSize = source.decompressionSize;
+            MarkDirty(slot);
+
+            voices[slot] = VoiceState{ sample, voices[slot].generation, 0, 1, 7, voices[sample].mode, 0, 0, voices[sample].length, source.pan };
+            return slot;
+        }
+
+        /** @brief Give back slots of extra instances that are done playing
+         */
+        static void ReclaimVoices()
+        {
+            for (int16_t slot = numberOfPCMs - 1; slot >= 0; slot--)
+            {
+                if (slot < numberOfPCMs && voices[slot].sample >= 0 && voices[slot].sample != slot && !IsVoiceActive(slot))
+                {
+                    ReleaseSlot(slot);
+                }
+            }
+        }
+
+        /** @brief Find slot of an instance handle
+         * @param handle Instance handle from Pcm::Play()
+         * @return Control slot index (-1 if instance is no longer playing)
+         */
+        static int16_t ResolveVoice(int16_t handle)
+        {
+            int16_t slot = handle & ((1 << VOICE_HANDLE_SHIFT) - 1);
+
+            if (slot >= numberOfPCMs || voices[slot].generation != (handle >> VOICE_HANDLE_SHIFT) || !IsVoiceActive(slot))
+            {
+                return -1;
+            }
+
+            return slot;
+        }
+
+        /** @brief Start instance on a slot
+         * @param slot Control slot index
+         * @param mode Loop/Playback mode
+         * @param volume Starting volume
+         * @param priority Priority of the instance
+         * @return Instance handle
+         */
+        static int16_t StartVoice(int16_t slot, PlayMode mode, uint8_t volume, uint8_t priority)
+        {
+            VoiceState& voice = voices[slot];
+            voice.generation = voice.generation >= 0xFF ? 1 : voice.generation + 1;
+            voice.priority = priority;
+            voice.volume = volume;
+            voice.started = frameCounter;
+            voice.ends = mode > PlayMode::Volatile ? 0xFFFFFFFF : frameCounter + EstimateVoiceFrames(slot);
+
+            voice.mode = (int8_t)mode;
+            QueueCommand(slot, COMMAND_LOOP_TYPE | COMMAND_VOLUME | COMMAND_START, volume, 0, (int8_t)mode);
+
+            return (int16_t)((voice.generation << VOICE_HANDLE_SHIFT) | slot);
+        }
+
+        /** @brief Fields of a queued control slot update
+         */
+        enum CommandFlags : uint8_t
+        {
+            COMMAND_VOLUME = 1 << 0,
+            COMMAND_PAN = 1 << 1,
+            COMMAND_LOOP_TYPE = 1 << 2,
+            COMMAND_START = 1 << 3,
+            COMMAND_HALT = 1 << 4
+        };
+
+        /** @brief Queued update of one control slot, later updates in the same frame overwrite earlier ones
+         */
+        struct VoiceCommand
+        {
+            /** @brief Fields to write (CommandFlags), cleared by the vblank before the fields are read
+             */
+            volatile uint8_t flags;
+
+            /** @brief New loop type
+             */
+            int8_t loopType;
+
+            /** @brief New volume
+             */
+            uint8_t volume;
+
+            /** @brief New pan
+             */
+            uint8_t pan;
+        };
+
+        /** @brief Control slot updates waiting for the next vblank, kept in work RAM
+         */
+        static inline VoiceCommand voiceCommands[PCM::CTRL_MAX];
+
+        /** @brief Number of commands queued since the last vblank
+         */
+        static inline volatile uint16_t queuedCommands = 0;
+
+        /** @brief Number of commands merged into the last vblank
+         */
+        static inline uint16_t lastFrameCommands = 0;
+
+        /** @brief Number of control slots written by the last vblank
+         */
+        static inline uint16_t lastFrameSlotWrites = 0;
+
+        /** @brief Most commands merged into one vblank since Stats::ResetPeaks()
+         */
+        static inline uint16_t peakFrameCommands = 0;
+
+        /** @brief Most control slots written by one vblank since Stats::ResetPeaks()
+         */
+        static inline uint16_t peakFrameSlotWrites = 0;
+
+        /** @brief Queued CD audio volume of left and right channel (bit 7 set while not yet written)
+         */
+        static inline volatile uint8_t cdVolumeCommand[2] = { 0, 0 };
+
+        /** @brief Work RAM copy of the driver control table, all SH-2 writes go here and PushShadow() sends them on
+         */
+        alignas(4) static inline PCM::CTRL ctrlShadow[PCM::CTRL_MAX];
+
+        /** @brief Driver control table as copied from sound RAM by ReadBack() (read it through CacheThrough())
+         */
+        alignas(4) static inline PCM::CTRL ctrlReadback[PCM::CTRL_MAX];
+
+        /** @brief Control slots whose shadow changed since the last push
+         */
+        static inline volatile uint8_t ctrlDirty[PCM::CTRL_MAX];
+
+        /** @brief Work RAM copy of the system command block (driver table address, CD audio volume, ADX buffer flags)
+         */
+        static inline SystemCommandParameters systemShadow;
+
+        /** @brief CD audio volume in systemShadow changed since the last push
+         */
+        static inline volatile bool systemDirty = false;
+
+        /** @brief Get cache-through alias of a work RAM buffer that was written by DMA
+         * @param buffer Buffer in work RAM
+         */
+        template <typename T>
+        static const T* CacheThrough(const T* buffer)
+        {
+            return reinterpret_cast<const T*>(reinterpret_cast<uintptr_t>(buffer) | PONESOUND_CACHE_THROUGH);
+        }
+
+        /** @brief Raise SH-2 interrupt mask to 15, so the vblank hook cannot run
+         * @return Status register to give to RestoreInterrupts()
+         */
+        static uint32_t MaskInterrupts()
+        {
+#if defined(__sh__)
+            uint32_t status;
+            __asm__ volatile ("stc sr, %0" : "=r"(status));
+            __asm__ volatile ("ldc %0, sr" : : "r"(status | 0xF0) : "memory");
+            return status;
+#else
+            return 0;
+#endif
+        }
+
+        /** @brief Put back interrupt mask saved by MaskInterrupts()
+         * @param status Status register returned by MaskInterrupts()
+         */
+        static void RestoreInterrupts(uint32_t status)
+        {
+#if defined(__sh__)
+            __asm__ volatile ("ldc %0, sr" : : "r"(status) : "memory");
+#else
+            (void)status;
+#endif
+        }
+
+        /** @brief Start DMA copy from the main loop without waiting for it to finish
+         * @param source Source address
+         * @param destination Destination address
+         * @param size Number of bytes
+         * @note ReadBack() and PushShadow() use the same channel from the vblank hook, which would program it over a
+         * half set up copy, so the hook is held off until this copy is started. Wait with slDMAWait() before reusing
+         * the source or reading the destination.
+         */
+        static void StartDma(const void* source, void* destination, uint32_t size)
+        {
+            // Long waits happen with interrupts on, the masked one only covers a copy the hook started in between
+            slDMAWait();
+            uint32_t status = MaskInterrupts();
+            slDMAWait();
+            slDMACopy((void*)source, destination, size);
+            RestoreInterrupts(status);
+        }
+
+        /** @brief Get address of the driver control table in sound RAM
+         * @return Control table (nullptr while the driver has not published it yet)
+         */
+        static volatile PCM::CTRL* DriverCtrl()
+        {
+            if (systemShadow.pcmCtrl == nullptr)
+            {
+                systemShadow.pcmCtrl = m68kCommands.pcmCtrl;
+            }
+
+            return systemShadow.pcmCtrl;
+        }
+
+        /** @brief Wait until the vblank hook pushed everything queued so far and the driver acted on it
+         * @note Returns right away while the driver is not running
+         */
+        static void WaitForDriver()
+        {
+            if (DriverCtrl() == nullptr) return;
+
+            // First vblank pushes the queue and starts the driver on it, it is done by the next one
+            uint32_t start = frameCounter;
+
+            while (frameCounter - start < 2)
+            {
+                PONESOUND_WAIT_FRAME();
+            }
+        }
+
+        /** @brief Mark control slot shadow for the next push, call after the fields are written
+         * @param slot Control slot index
+         */
+        static void MarkDirty(int16_t slot)
+        {
+            ctrlDirty[slot] = 1;
+        }
+
+        /** @brief Copy fields the driver writes back into the control table shadow
+         * @note Called from the vblank hook, the whole used part of the table comes over in one DMA. ADX buffer flags
+         * of the system block are read by AdxStream::Update(), and only while a stream plays.
+         */
+        static void ReadBack()
+        {
+            volatile PCM::CTRL* table = DriverCtrl();
+
+            if (table != nullptr && numberOfPCMs > 0)
+            {
+                slDMAWait();
+                slDMACopy((void*)table, ctrlReadback, numberOfPCMs * sizeof(PCM::CTRL));
+                slDMAWait();
+
+                const PCM::CTRL* readback = CacheThrough(ctrlReadback);
+
+                for (int16_t slot = 0; slot < numberOfPCMs; slot++)
+                {
+                    ctrlShadow[slot].icsrTarget = readback[slot].icsrTarget;
+
+                    // Pending start/stop of a dirty slot wins over what the driver has
+                    if (ctrlDirty[slot] == 0)
+                    {
+                        ctrlShadow[slot].sh2Permit = readback[slot].sh2Permit;
+                    }
+                }
+            }
+        }
+
+        /** @brief Send dirty control slots to sound RAM, one transfer per run of neighbouring dirty slots, and CD audio
+         * volume if it changed
+         * @note Called from the vblank hook before the driver is started for the frame. Clean slots are never written, the
+         * driver owns their start/stop and ICSR fields between pushes.
+         */
+        static void PushShadow()
+        {
+            volatile PCM::CTRL* table = DriverCtrl();
+            lastFrameSlotWrites = 0;
+
+            for (int16_t slot = 0; slot < PCM::CTRL_MAX && table != nullptr; slot++)
+            {
+                if (ctrlDirty[slot] == 0) continue;
+
+                int16_t first = slot;
+
+                while (slot < PCM::CTRL_MAX && ctrlDirty[slot] != 0)
+                {
+                    ctrlDirty[slot] = 0;
+                    slot++;
+                }
+
+                slDMAWait();
+                slDMACopy(&ctrlShadow[first], (void*)(table + first), (slot - first) * sizeof(PCM::CTRL));
+                slDMAWait();
+                lastFrameSlotWrites += slot - first;
+            }
+
+            peakFrameSlotWrites = lastFrameSlotWrites > peakFrameSlotWrites ? lastFrameSlotWrites : peakFrameSlotWrites;
+
+            if (systemDirty)
+            {
+                systemDirty = false;
+                m68kCommands.cddaLeftChannelVolPan = systemShadow.cddaLeftChannelVolPan;
+                m68kCommands.cddaRightChannelVolPan = systemShadow.cddaRightChannelVolPan;
+            }
+        }
+
+        /** @brief SCSP monitor register: MSLC (bits 11-15) selects a slot, CA (bits 7-10) returns bits 12-15 of its play position
+         */
+        static constexpr uint32_t SCSP_MONITOR = SNDRAM + 0x100408;
+
+        /** @brief Play positions the monitor register counts in (CA unit)
+         */
+        static constexpr int32_t MONITOR_SAMPLES = 4096;
+
+        /** @brief Control slot the monitor register was pointed at (-1 if it is free)
+         */
+        static inline int16_t monitoredSound = -1;
+
+        /** @brief Vblank the monitor register was pointed at monitoredSound
+         */
+        static inline uint32_t monitorFrame = 0;
+
+        /** @brief Read play position of a control slot from the SCSP, so streams follow the real sample clock
+         * @param sound Control slot of the stream
+         * @return Position from the start of the sample in MONITOR_SAMPLES units (-1 while not known yet)
+         * @note Called from the vblank hook, before the driver is started for the frame. The monitor register is shared,
+         * so a slot is selected on one vblank and read on a later one, streams take turns. A position that comes back
+         * with another slot selected (the driver used the register in between) is dropped.
+         */
+        static int16_t MonitorSlot(int16_t sound)
+        {
+            volatile uint16_t& monitor = *(volatile uint16_t*)SCSP_MONITOR;
+            int8_t scspSlot = ctrlShadow[sound].icsrTarget;
+            int16_t position = -1;
+
+            if (scspSlot < 0) return -1;
+
+            // Selection of a stream that stopped before reading it expires
+            if (monitoredSound >= 0 && frameCounter - monitorFrame > 2)
+            {
+                monitoredSound = -1;
+            }
+
+            if (monitoredSound == sound && monitorFrame != frameCounter)
+            {
+                uint16_t value = monitor;
+                position = (value >> 11) == (uint16_t)scspSlot ? (int16_t)((value >> 7) & 0xF) : -1;
+                monitoredSound = -1;
+            }
+            else if (monitoredSound < 0)
+            {
+                // CA bits are read only, they are written back as they are
+                monitor = (uint16_t)((monitor & 0x07FF) | (scspSlot << 11));
+                monitoredSound = sound;
+                monitorFrame = frameCounter;
+            }
+
+            return position;
+        }
+
+        /** @brief Queue control slot update
+         * @param slot Control slot index
+         * @param flags Fields to write (CommandFlags)
+         * @param volume New volume
+         * @param pan New pan
+         * @param loopType New loop type
+         */
+        static void QueueCommand(int16_t slot, uint8_t flags, uint8_t volume = 0, uint8_t pan = 0, int8_t loopType = 0)
+        {
+            VoiceCommand& command = voiceCommands[slot];
+
+            // Fields first and flags last, so a vblank in between only sees complete values
+            if (flags & COMMAND_VOLUME) command.volume = volume;
+            if (flags & COMMAND_PAN) command.pan = pan;
+            if (flags & COMMAND_LOOP_TYPE) command.loopType = loopType;
+
+            uint8_t pending = command.flags;
+            pending = (flags & COMMAND_START) ? (pending & ~COMMAND_HALT) : pending;
+            pending = (flags & COMMAND_HALT) ? (pending & ~COMMAND_START) : pending;
+            command.flags = pending | flags;
+            queuedCommands = queuedCommands + 1;
+        }
+
+        /** @brief Merge queued updates into the control table shadow
+         * @note Called from the vblank hook, released slots above numberOfPCMs still get their stop
+         */
+        static void ApplyCommands()
+        {
+            lastFrameCommands = queuedCommands;
+            peakFrameCommands = lastFrameCommands > peakFrameCommands ? lastFrameCommands : peakFrameCommands;
+
+            if (queuedCommands == 0) return;
+            queuedCommands = 0;
+
+            for (int16_t slot = 0; slot < PCM::CTRL_MAX; slot++)
+            {
+                uint8_t flags = voiceCommands[slot].flags;
+                if (flags == 0) continue;
+
+                voiceCommands[slot].flags = 0;
+                PCM::CTRL& ctrl = ctrlShadow[slot];
+                const VoiceCommand& command = voiceCommands[slot];
+
+                if (flags & COMMAND_LOOP_TYPE) ctrl.loopType = command.loopType;
+                if (flags & COMMAND_PAN) ctrl.pan = command.pan;
+                if (flags & COMMAND_VOLUME) ctrl.volume = command.volume;
+                if (flags & COMMAND_START) ctrl.sh2Permit = 1;
+                if (flags & COMMAND_HALT) ctrl.sh2Permit = 0;
+                MarkDirty(slot);
+            }
+
+            for (int32_t channel = 0; channel < 2; channel++)
+            {
+                uint8_t volume = cdVolumeCommand[channel];
+                if ((volume & 0x80) == 0) continue;
+
+                cdVolumeCommand[channel] = 0;
+                volatile uint8_t& volPan = channel == 0 ? systemShadow.cddaLeftChannelVolPan : systemShadow.cddaRightChannelVolPan;
+                volPan = (volPan & 0x1F) | ((volume & 0x7) << 5);
+                systemDirty = true;
+            }
+        }
+
+        /** @brief What a volume envelope drives
+         */
+        enum EnvelopeFlags : uint8_t
+        {
+            ENVELOPE_ACTIVE = 1 << 0,
+            ENVELOPE_STOP = 1 << 1,
+            ENVELOPE_ADX = 1 << 2,
+            ENVELOPE_CD = 1 << 3
+        };
+
+        /** @brief Volume ramp advanced once per vblank
+         */
+        struct Envelope
+        {
+            /** @brief EnvelopeFlags, ENVELOPE_ACTIVE is set last and cleared first so the vblank never sees a partial record
+             */
+            volatile uint8_t flags;
+
+            /** @brief Voice generation when the envelope started, a restarted or stolen voice drops it
+             */
+            uint8_t generation;
+
+            /** @brief Control slot, or channel (0 left, 1 right) with ENVELOPE_CD
+             */
+            int16_t target;
+
+            /** @brief Current volume (8.8 fixed point)
+             */
+            int16_t level;
+
+            /** @brief Change per frame (8.8 fixed point)
+             */
+            int16_t step;
+
+            /** @brief Volume reached on the last frame
+             */
+            uint8_t volume;
+
+            /** @brief Frames left
+             */
+            uint16_t frames;
+        };
+
+        /** @brief Maximum number of fades and timed stops running at once
+         */
+        static constexpr auto MAX_ENVELOPES = 16;
+
+        /** @brief Running fades and timed stops, kept in work RAM
+         */
+        static inline Envelope envelopes[MAX_ENVELOPES] = {};
+
+        /** @brief Drop envelope of a target
+         * @param target Control slot, or CD channel
+         * @param kind 0 for voices, ENVELOPE_ADX or ENVELOPE_CD
+         */
+        static void CancelEnvelope(int16_t target, uint8_t kind)
+        {
+            for (int16_t index = 0; index < MAX_ENVELOPES; index++)
+            {
+                Envelope& envelope = envelopes[index];
+
+                if ((envelope.flags & ENVELOPE_ACTIVE) && envelope.target == target && (envelope.flags & (ENVELOPE_ADX | ENVELOPE_CD)) == kind)
+                {
+                    envelope.flags = 0;
+                }
+            }
+        }
+
+        /** @brief Start volume ramp, replacing the one the target already has
+         * @param target Control slot, or CD channel
+         * @param kind 0 for voices, ENVELOPE_ADX or ENVELOPE_CD
+         * @param from Current volume (0-7)
+         * @param to Volume at the end (0-7)
+         * @param frames Length in frames (at least 1)
+         * @param stop Whether to stop the target at the end
+         * @return false if all envelopes are in use
+         */
+        static bool StartEnvelope(int16_t target, uint8_t kind, uint8_t from, uint8_t to, uint16_t frames, bool stop)
+        {
+            CancelEnvelope(target, kind);
+
+            for (int16_t index = 0; index < MAX_ENVELOPES; index++)
+            {
+                Envelope& envelope = envelopes[index];
+                if (envelope.flags != 0) continue;
+
+                envelope.generation = kind == 0 ? voices[target].generation : 0;
+                envelope.target = target;
+                envelope.level = (int16_t)(from << 8);
+                envelope.step = (int16_t)((((int32_t)to - from) << 8) / frames);
+                envelope.volume = to;
+                envelope.frames = frames;
+                envelope.flags = ENVELOPE_ACTIVE | kind | (stop ? ENVELOPE_STOP : 0);
+                return true;
+            }
+
+            return false;
+        }
+
+        /** @brief Get current volume of a CD channel, including a change not yet written
+         * @param channel 0 for left, 1 for right
+         */
+        static uint8_t GetCdVolume(int16_t channel)
+        {
+            uint8_t queued = cdVolumeCommand[channel];
+            if (queued & 0x80) return queued & 0x7;
+            return (channel == 0 ? systemShadow.cddaLeftChannelVolPan : systemShadow.cddaRightChannelVolPan) >> 5;
+        }
+
+        /** @brief Advance envelopes by one frame
+         * @note Called from the vblank hook after queued commands are merged, so it writes the control table shadow directly
+         */
+        static void UpdateEnvelopes()
+        {
+            for (int16_t index = 0; index < MAX_ENVELOPES; index++)
+            {
+                Envelope& envelope = envelopes[index];
+                uint8_t flags = envelope.flags;
+                if (flags == 0) continue;
+
+                int16_t target = envelope.target;
+
+                // Target was stopped, restarted or stolen since the envelope started
+                if (((flags & (ENVELOPE_ADX | ENVELOPE_CD)) == 0 && (voices[target].generation != envelope.generation || !IsVoiceActive(target))) ||
+                    ((flags & ENVELOPE_ADX) && !AdxStream::IsPlaying()))
+                {
+                    envelope.flags = 0;
+                    continue;
+                }
+
+                envelope.frames--;
+                envelope.level = envelope.frames == 0 ? (int16_t)(envelope.volume << 8) : envelope.level + envelope.step;
+                uint8_t volume = (uint8_t)((envelope.level + 128) >> 8);
+
+                if (flags & ENVELOPE_CD)
+                {
+                    volatile uint8_t& volPan = target == 0 ? systemShadow.cddaLeftChannelVolPan : systemShadow.cddaRightChannelVolPan;
+
+                    if ((volPan >> 5) != volume)
+                    {
+                        volPan = (volPan & 0x1F) | (volume << 5);
+                        systemDirty = true;
+                    }
+                }
+                else if (ctrlShadow[target].volume != volume)
+                {
+                    ctrlShadow[target].volume = volume;
+                    voices[target].volume = volume;
+                    MarkDirty(target);
+                }
+
+                if (envelope.frames != 0) continue;
+                envelope.flags = 0;
+
+                // Halt is queued for the next vblank, the voice is already silent or at its held volume until then
+                if ((flags & ENVELOPE_STOP) && (flags & ENVELOPE_ADX))
+                {
+                    AdxStream::Stop();
+                }
+                else if (flags & ENVELOPE_STOP)
+                {
+                    StopVoice(target);
+                }
+            }
+        }
+
+        /** @brief Fade one voice, or change it right away without a length or a free envelope
+         * @param slot Control slot of a playing voice
+         * @param volume Volume at the end (0-7)
+         * @param frames Length in frames
+         * @param stop Whether to stop the voice at the end
+         * @return false if the change had to be applied right away although a length was given
+         */
+        static bool FadeVoice(int16_t slot, uint8_t volume, uint16_t frames, bool stop)
+        {
+            if (frames > 0 && StartEnvelope(slot, 0, voices[slot].volume, volume, frames, stop)) return true;
+
+            CancelEnvelope(slot, 0);
+
+            if (stop)
+            {
+                StopVoice(slot);
+            }
+            else
+            {
+                voices[slot].volume = volume;
+                QueueCommand(slot, COMMAND_VOLUME, volume);
+            }
+
+            return frames == 0;
+        }
+
+        /** @brief Fade every playing instance of a sound, or one instance
+         * @param sound Sound, or instance handle returned by Pcm::Play()
+         * @param volume Volume at the end (0-7)
+         * @param frames Length in frames
+         * @param stop Whether to stop the voices at the end
+         * @param hold Keep the current volume of each voice instead of fading to volume
+         * @return false if nothing is playing or a change had to be applied right away
+         */
+        static bool FadeVoices(int16_t sound, uint8_t volume, uint16_t frames, bool stop, bool hold)
+        {
+            if (sound < 0) return false;
+
+            if (sound >= (1 << VOICE_HANDLE_SHIFT))
+            {
+                int16_t slot = ResolveVoice(sound);
+                return slot >= 0 && FadeVoice(slot, hold ? voices[slot].volume : volume, frames, stop);
+            }
+
+            bool found = false;
+            bool faded = true;
+
+            for (int16_t slot = 0; slot < numberOfPCMs; slot++)
+            {
+                if (voices[slot].sample == sound && IsVoiceActive(slot))
+                {
+                    found = true;
+                    faded = FadeVoice(slot, hold ? voices[slot].volume : volume, frames, stop) && faded;
+                }
+            }
+
+            return found && faded;
+        }
+
+        /** @brief SH-2 free running timer counter (FRC), upper byte first
+         */
+        static constexpr uint32_t FRT_COUNTER = 0xFFFFFE12;
+
+        /** @brief SH-2 free running timer control register (TCR)
+         */
+        static constexpr uint32_t FRT_CONTROL = 0xFFFFFE16;
+
+        /** @brief Nominal SH-2 clock (NTSC, 320 pixel wide modes) used to convert timer ticks
+         */
+        static constexpr uint32_t SH2_CLOCK = 26874100;
+
+        /** @brief Point in time for measuring load phases
+         */
+        struct TimerStamp
+        {
+            /** @brief Free running timer counter
+             */
+            uint16_t ticks;
+
+            /** @brief Vblank counter
+             */
+            uint32_t frame;
+        };
+
+        /** @brief Get rate of the free running timer as set up by the program
+         * @return Ticks per second
+         */
+        static uint32_t GetTimerRate()
+        {
+            // Clock select bits: 0 = clock / 8, 1 = clock / 32, 2 = clock / 128 (3 is an external clock, taken as 2)
+            uint8_t select = *(volatile uint8_t*)FRT_CONTROL & 3;
+            select = select > 2 ? 2 : select;
+            return SH2_CLOCK >> (3 + (select * 2));
+        }
+
+        /** @brief Take time stamp
+         */
+        static TimerStamp ReadTimer()
+        {
+            // Reading the upper byte latches the lower one
+            uint8_t high = *(volatile uint8_t*)FRT_COUNTER;
+            uint8_t low = *(volatile uint8_t*)(FRT_COUNTER + 1);
+            return TimerStamp{ (uint16_t)((high << 8) | low), frameCounter };
+        }
+
+        /** @brief Get time since a stamp
+         * @param start Stamp taken at the start
+         * @return Elapsed timer ticks
+         */
+        static uint32_t TimerElapsed(const TimerStamp& start)
+        {
+            TimerStamp now = ReadTimer();
+            uint32_t ticks = (uint16_t)(now.ticks - start.ticks);
+            uint32_t frames = now.frame - start.frame;
+            uint32_t perFrame = GetTimerRate() / 60;
+
+            if ((frames + 1) * perFrame >= 0x10000)
+            {
+                // Counter is 16 bits wide, the vblank count tells how many times it wrapped
+                uint32_t estimate = frames * perFrame;
+                if (perFrame >= 0x8000) return estimate > ticks ? estimate : ticks;
+                if (estimate > ticks) ticks += (estimate - ticks + 0x8000) & 0xFFFF0000;
+            }
+
+            return ticks;
+        }
+
+        /** @brief Add timer ticks passed since a stamp, for waits while no vblank is counted
+         * @param last Stamp of the previous call, moved to now
+         * @param ticks Sum the elapsed ticks are added to
+         * @note Has to be called more often than the 16 bit counter wraps
+         */
+        static void AddTicks(TimerStamp& last, uint32_t& ticks)
+        {
+            TimerStamp now = ReadTimer();
+            ticks += (uint16_t)(now.ticks - last.ticks);
+            last = now;
+        }
+
+		/** @brief GFS file id of the open sound archive (-1 if none, see Pack::Open())
+		 */
+		static inline int32_t packFileId = -1;
+
+		/** @brief Number of entries in the directory of the open sound archive
+		 */
+		static inline int16_t packEntryCount = 0;
+
+		/** @brief Directory of the open sound archive
+		 */
+		static inline PackEntry packDirectory[MAX_PACK_ENTRIES];
+
+		/** @brief Find entry of the open sound archive
+		 * @param fileName Entry name (any case)
+		 * @return Entry index (< 0 if no archive is open or it has no such entry)
+		 */
+		static int16_t FindPackEntry(const char* fileName)
+		{
+			if (packFileId < 0) return -1;
+
+			uint32_t hash = Pcm::HashName(fileName);
+
+			for (int16_t entry = 0; entry < packEntryCount; entry++)
+			{
+				if (packDirectory[entry].nameHash == hash) return entry;
+			}
+
+			return -1;
+		}
+
+		/** @brief Open file on CD, entries of the open sound archive are used before files of the same name
+		 * @param fileName File name
+		 * @param firstSector Set to the first sector of the file in the opened GFS file
+		 * @param sectors Set to number of sectors of the file
+		 * @param lastSize Set to number of bytes used in the last sector
+		 * @return GFS handle at the first sector of the file (nullptr if not found)
+		 */
+		static GfsHandle OpenCdFile(const char* fileName, int32_t& firstSector, int32_t& sectors, int32_t& lastSize)
+		{
+			int16_t entry = FindPackEntry(fileName);
+
+			if (entry >= 0)
+			{
+				// The archive was looked up once by Pack::Open(), its entries need no CD directory search
+				GfsHandle handle = GFS_Open(packFileId);
+				if (handle == nullptr) return nullptr;
+
+				firstSector = (int32_t)packDirectory[entry].firstSector;
+				sectors = ((int32_t)packDirectory[entry].size + SECTOR_SIZE - 1) / SECTOR_SIZE;
+				lastSize = (int32_t)packDirectory[entry].size - ((sectors - 1) * SECTOR_SIZE);
+				GFS_Seek(handle, firstSector, GFS_SEEK_SET);
+				return handle;
+			}
+
+			int32_t fileId = GFS_NameToId((Sint8*)fileName);
+			GfsHandle handle = fileId >= 0 ? GFS_Open(fileId) : nullptr;
+			if (handle == nullptr) return nullptr;
+
+			Sint32 sectorSize;
+			GFS_GetFileSize(handle, &sectorSize, &sectors, &lastSize);
+			firstSector = 0;
+			return handle;
+		}
+
+		/**
+		 * @brief Sequential reader over a CD file with non-blocking sector fetches.
+		 *
+		 * The drive reads ahead a run of sectors into the CD block buffer, each Poll() then moves at most one sector into
+		 * a local buffer, so the caller decides how much CD work is done per call. There are two local buffers: while the
+		 * caller decodes or uploads one sector, the transfer of the next one is already running into the other, and
+		 * uploads to sound RAM are only waited for before their buffer is filled again.
+		 */
+		class SectorReader
+		{
+		public:
+			/** @brief Number of sectors the drive is asked to read ahead
+			 */
+			static constexpr auto READ_AHEAD_SECTORS = 16;
+
+		private:
+			GfsHandle handle;
+			int32_t firstSector;
+			int32_t fileBytes;
+			int32_t fileSectors;
+			int32_t position;
+			int32_t bufferSector[2];
+			int32_t nextSector;
+			int32_t readAheadEnd;
+			uint8_t current;
+			uint8_t target;
+			bool reading;
+			bool uploading;
+			LoadProfile* profile;
+			alignas(4) uint8_t buffer[2][SECTOR_SIZE];
+
+			/** @brief Restart drive read-ahead at a sector
+			 * @param sector Sector to start at
+			 */
+			void Restart(int32_t sector)
+			{
+				GFS_NwStop(this->handle);
+				GFS_Seek(this->handle, this->firstSector + sector, GFS_SEEK_SET);
+				this->ReadAhead(sector);
+			}
+
+			/** @brief Ask the drive for the next run of sectors
+			 * @param sector First sector of the run
+			 */
+			void ReadAhead(int32_t sector)
+			{
+				int32_t count = this->fileSectors - sector;
+				count = count > READ_AHEAD_SECTORS ? READ_AHEAD_SECTORS : count;
+				GFS_NwCdRead(this->handle, count);
+				this->nextSector = sector;
+				this->readAheadEnd = sector + count;
+			}
+
+			/** @brief Start moving a sector from the drive into a local buffer
+			 * @param sector Sector to move
+			 * @param slot Local buffer to fill
+			 */
+			void BeginTransfer(int32_t sector, uint8_t slot)
+			{
+				if (sector != this->nextSector)
+				{
+					this->Restart(sector);
+				}
+				else if (sector >= this->readAheadEnd)
+				{
+					this->ReadAhead(sector);
+				}
+
+				// Upload from this buffer may still be running
+				this->WaitUpload();
+
+				GFS_NwFread(this->handle, 1, this->buffer[slot], SECTOR_SIZE);
+				this->bufferSector[slot] = -1;
+				this->target = slot;
+				this->reading = true;
+			}
+
+			/** @brief Start transfer of the sector after the current one into the other buffer, if it is not there yet
+			 */
+			void Prefetch()
+			{
+				uint8_t other = this->current ^ 1;
+				int32_t sector = this->bufferSector[this->current] + 1;
+
+				if (this->reading || sector >= this->fileSectors || sector != this->nextSector || this->bufferSector[other] == sector) return;
+
+				this->BeginTransfer(sector, other);
+				GFS_NwExecOne(this->handle);
+			}
+
+		public:
+			/** @brief Construct closed reader
+			 */
+			SectorReader() : handle(nullptr), firstSector(0), fileBytes(0), fileSectors(0), position(0), bufferSector{ -1, -1 }, nextSector(-1), readAheadEnd(0), current(0), target(0), reading(false), uploading(false), profile(nullptr)
+			{
+			}
+
+			/** @brief Set where CD and copy time of this reader is counted
+			 * @param record Profile of the load in progress (nullptr to stop counting)
+			 */
+			void SetProfile(LoadProfile* record)
+			{
+				this->profile = record;
+			}
+
+			/** @brief Profile CD and copy time of this reader is counted in (nullptr if none)
+			 */
+			LoadProfile* GetProfile() const
+			{
+				return this->profile;
+			}
+
+			/** @brief Open file for reading
+			 * @param fileName File name (entry of the open sound archive or file on CD)
+			 * @return true on success
+			 */
+			bool Open(const char* fileName)
+			{
+				this->Close();
+
+				int32_t lastSize;
+				this->handle = OpenCdFile(fileName, this->firstSector, this->fileSectors, lastSize);
+				if (this->handle == nullptr) return false;
+
+				this->fileBytes = ((this->fileSectors - 1) * SECTOR_SIZE) + lastSize;
+				this->position = 0;
+				this->bufferSector[0] = -1;
+				this->bufferSector[1] = -1;
+				this->reading = false;
+				this->ReadAhead(0);
+				return true;
+			}
+
+			/** @brief Close file, waits for uploads still reading from the local buffers
+			 */
+			void Close()
+			{
+				this->WaitUpload();
+
+				if (this->handle == nullptr) return;
+				GFS_NwStop(this->handle);
+				GFS_Close(this->handle);
+				this->handle = nullptr;
+				this->reading = false;
+			}
+
+			/** @brief Check whether file is open
+			 */
+			bool IsOpen() const
+			{
+				return this->handle != nullptr;
+			}
+
+			/** @brief File size in bytes
+			 */
+			int32_t Size() const
+			{
+				return this->fileBytes;
+			}
+
+			/** @brief Current read position in bytes
+			 */
+			int32_t Tell() const
+			{
+				return this->position;
+			}
+
+			/** @brief Move read position
+			 * @param offset Offset from start of the file in bytes
+			 */
+			void Seek(int32_t offset)
+			{
+				this->position = offset;
+			}
+
+			/** @brief Advance read position
+			 * @param bytes Number of bytes to skip
+			 */
+			void Skip(int32_t bytes)
+			{
+				this->position += bytes;
+			}
+
+			/** @brief Pointer to data at current read position, valid for the byte count returned by Poll()
+			 */
+			const uint8_t* Data() const
+			{
+				return this->buffer[this->current] + (this->position % SECTOR_SIZE);
+			}
+
+			/** @brief Make data at current read position available
+			 * @param blocking Wait until the sector arrives from CD
+			 * @return Number of bytes available at Data() (0 while the sector is still being read or at end of file)
+			 */
+			int32_t Poll(bool blocking = false)
+			{
+				if (this->profile == nullptr) return this->Fetch(blocking);
+
+				// Waits for uploads done while fetching are counted on their own
+				TimerStamp start = ReadTimer();
+				uint32_t dmaTicks = this->profile->dmaTicks;
+				int32_t available = this->Fetch(blocking);
+				this->profile->readTicks += TimerElapsed(start) - (this->profile->dmaTicks - dmaTicks);
+				return available;
+			}
+
+			/** @brief Copy data at current read position to sound RAM by DMA without waiting for it
+			 * @param destination Sound RAM address (SNDRAM based)
+			 * @param size Number of bytes to copy (at most what Poll() returned)
+			 * @note The copy is waited for before its buffer is filled again, by the next upload and by Close()
+			 */
+			void Upload(void* destination, int32_t size)
+			{
+				// Channel is shared with other copies, StartDma() waits for any of them
+				TimerStamp start = ReadTimer();
+				StartDma(this->Data(), destination, size);
+				this->uploading = true;
+
+				if (this->profile != nullptr)
+				{
+					this->profile->dmaTicks += TimerElapsed(start);
+					this->profile->bytesUploaded += size;
+				}
+			}
+
+			/** @brief Wait for the last upload to sound RAM started by Upload()
+			 */
+			void WaitUpload()
+			{
+				if (!this->uploading) return;
+
+				TimerStamp start = ReadTimer();
+				slDMAWait();
+				this->uploading = false;
+
+				if (this->profile != nullptr)
+				{
+					this->profile->dmaTicks += TimerElapsed(start);
+				}
+			}
+
+		private:
+			/** @brief Move sector at current read position from the drive to the local buffer, see Poll()
+			 * @param blocking Wait until the sector arrives from CD
+			 * @return Number of bytes available at Data()
+			 */
+			int32_t Fetch(bool blocking)
+			{
+				if (this->handle == nullptr) return 0;
+
+				while (this->position < this->fileBytes)
+				{
+					int32_t sector = this->position / SECTOR_SIZE;
+
+					if (this->bufferSector[this->current] == sector || this->bufferSector[this->current ^ 1] == sector)
+					{
+						// Next sector moves into the other buffer while this one is used
+						this->current = this->bufferSector[this->current] == sector ? this->current : this->current ^ 1;
+						this->Prefetch();
+
+						int32_t end = (sector + 1) * SECTOR_SIZE;
+						return (end > this->fileBytes ? this->fileBytes : end) - this->position;
+					}
+
+					if (!this->reading)
+					{
+						// Keep the buffer the caller may still be reading from
+						this->BeginTransfer(sector, this->current ^ 1);
+					}
+
+					GFS_NwExecOne(this->handle);
+
+					if (GFS_NwIsComplete(this->handle))
+					{
+						this->reading = false;
+						this->bufferSector[this->target] = this->nextSector++;
+
+						if (this->profile != nullptr)
+						{
+							int32_t end = (this->bufferSector[this->target] + 1) * SECTOR_SIZE;
+							this->profile->bytesRead += (end > this->fileBytes ? this->fileBytes : end) - (this->bufferSector[this->target] * SECTOR_SIZE);
+						}
+					}
+					else if (!blocking)
+					{
+						return 0;
+					}
+				}
+
+				return 0;
+			}
+
+		public:
+
+			/** @brief Read data, waiting for CD
+			 * @param destination Where to copy data to
+			 * @param size Number of bytes to read
+			 * @param dma Copy by DMA (for sound RAM destinations)
+			 * @return Number of bytes read
+			 */
+			int32_t Read(void* destination, int32_t size, bool dma = false)
+			{
+				int32_t done = 0;
+
+				while (done < size)
+				{
+					int32_t available = this->Poll(true);
+					if (available <= 0) break;
+
+					available = available > (size - done) ? (size - done) : available;
+					const uint8_t* source = this->Data();
+
+					if (dma)
+					{
+						// Runs while the next sector is fetched
+						this->Upload((uint8_t*)destination + done, available);
+					}
+					else
+					{
+						for (int32_t i = 0; i < available; i++)
+						{
+							((uint8_t*)destination)[done + i] = source[i];
+						}
+					}
+
+					this->Skip(available);
+					done += available;
+				}
+
+				this->WaitUpload();
+				return done;
+			}
+		};
+
+
+		/**
+		 * @brief Resumable LZSS decoder writing straight to sound RAM.
+		 *
+		 * Output goes through a ring the size of the LZSS window. Every time half of the ring fills up it is sent to
+		 * sound RAM by DMA, while decoding continues in the other half, so no buffer for the whole sample is needed.
+		 * Input can be fed in pieces of any size (e.g. one sector at a time).
+		 */
+		class LzssStream
+		{
+		public:
+			/** @brief LZSS window size (largest match distance)
+			 */
+			static constexpr auto WINDOW_SIZE = 4096;
+
+			/** @brief Number of bytes sent to sound RAM at once
+			 */
+			static constexpr auto FLUSH_SIZE = WINDOW_SIZE / 2;
+
+		private:
+			static constexpr auto MIN_MATCH = 3;
+
+			uint32_t destination;
+			int32_t total;
+			int32_t produced;
+			int32_t flushed;
+			int32_t matchLength;
+			int32_t matchDistance;
+			int16_t pairHigh;
+			uint8_t flags;
+			uint8_t mask;
+			LoadProfile* profile;
+			alignas(4) uint8_t window[WINDOW_SIZE];
+
+			/** @brief Send decoded bytes that were not sent yet to sound RAM
+			 */
+			void Flush()
+			{
+				int32_t size = this->produced - this->flushed;
+				if (size <= 0) return;
+
+				// Previous half must be in sound RAM before the ring wraps onto it
+				TimerStamp start = ReadTimer();
+				StartDma(this->window + (this->flushed & (WINDOW_SIZE - 1)), (void*)(this->destination + this->flushed), size);
+				this->flushed = this->produced;
+
+				if (this->profile != nullptr)
+				{
+					this->profile->dmaTicks += TimerElapsed(start);
+					this->profile->bytesUploaded += size;
+				}
+			}
+
+			/** @brief Store decoded byte
+			 * @param value Decoded byte
+			 */
+			void Put(uint8_t value)
+			{
+				this->window[this->produced & (WINDOW_SIZE - 1)] = value;
+				this->produced++;
+
+				if (this->produced - this->flushed == FLUSH_SIZE)
+				{
+					this->Flush();
+				}
+			}
+
+		public:
+			/** @brief Construct idle decoder
+			 */
+			LzssStream() : destination(0), total(0), produced(0), flushed(0), matchLength(0), matchDistance(0), pairHigh(-1), flags(0), mask(0), profile(nullptr)
+			{
+			}
+
+			/** @brief Start decoding a new stream
+			 * @param target Sound RAM address (SNDRAM based) to decode to
+			 * @param size Decompressed size in bytes
+			 * @param record Profile decode and copy time is counted in (nullptr for none)
+			 */
+			void Begin(uint32_t target, int32_t size, LoadProfile* record = nullptr)
+			{
+				this->profile = record;
+				this->destination = target;
+				this->total = size;
+				this->produced = 0;
+				this->flushed = 0;
+				this->matchLength = 0;
+				this->pairHigh = -1;
+				this->mask = 0;
+			}
+
+			/** @brief Decode compressed input
+			 * @param input Compressed data
+			 * @param size Number of bytes available at input
+			 * @param budget Maximum number of bytes to decode, reduced by the number of bytes decoded
+			 * @return Number of input bytes consumed
+			 */
+			int32_t Feed(const uint8_t* input, int32_t size, int32_t& budget)
+			{
+				if (this->profile == nullptr) return this->Decode(input, size, budget);
+
+				// Sound RAM uploads done while decoding are counted on their own
+				TimerStamp start = ReadTimer();
+				uint32_t dmaTicks = this->profile->dmaTicks;
+				int32_t consumed = this->Decode(input, size, budget);
+				this->profile->decodeTicks += TimerElapsed(start) - (this->profile->dmaTicks - dmaTicks);
+				return consumed;
+			}
+
+		private:
+			/** @brief Decode compressed input, see Feed()
+			 * @param input Compressed data
+			 * @param size Number of bytes available at input
+			 * @param budget Maximum number of bytes to decode, reduced by the number of bytes decoded
+			 * @return Number of input bytes consumed
+			 */
+			int32_t Decode(const uint8_t* input, int32_t size, int32_t& budget)
+			{
+				const uint8_t* start = input;
+				const uint8_t* end = input + size;
+
+				while (this->produced < this->total && budget > 0)
+				{
+					if (this->matchLength > 0)
+					{
+						this->Put(this->window[(this->produced - this->matchDistance) & (WINDOW_SIZE - 1)]);
+						this->matchLength--;
+						budget--;
+						continue;
+					}
+
+					if (this->mask == 0)
+					{
+						if (input >= end) break;
+						this->flags = *input++;
+						this->mask = 0x80;
+					}
+
+					if (this->flags & this->mask)
+					{
+						// Literal
+						if (input >= end) break;
+						this->Put(*input++);
+						budget--;
+					}
+					else
+					{
+						// Match, 12 bit distance and 4 bit length, may be split between two calls
+						if (this->pairHigh < 0)
+						{
+							if (input >= end) break;
+							this->pairHigh = *input++;
+						}
+
+						if (input >= end) break;
+						uint16_t pair = (uint16_t)((this->pairHigh << 8) | *input++);
+						this->pairHigh = -1;
+						this->matchDistance = ((pair >> 4) & 0x0FFF) + 1;
+						this->matchLength = (pair & 0x000F) + MIN_MATCH;
+					}
+
+					this->mask >>= 1;
+				}
+
+				return (int32_t)(input - start);
+			}
+
+		public:
+			/** @brief Check whether all output was decoded
+			 */
+			bool IsComplete() const
+			{
+				return this->produced >= this->total;
+			}
+
+			/** @brief Send rest of the output to sound RAM and wait for the transfer
+			 */
+			void Finish()
+			{
+				this->Flush();
+
+				TimerStamp start = ReadTimer();
+				slDMAWait();
+
+				if (this->profile != nullptr)
+				{
+					this->profile->dmaTicks += TimerElapsed(start);
+				}
+			}
+		};
+
+		/** @brief Decoder shared by sound file loads
+		 */
+		static inline LzssStream lzssStream;
+
+		/** @brief Reader used by blocking sound file loads
+		 */
+		static inline SectorReader soundReader;
+
+		/** @brief Last finished loads, oldest is overwritten first
+		 */
+		static inline LoadProfile loadHistory[LOAD_HISTORY];
+
+		/** @brief Number of loads finished since start
+		 */
+		static inline uint32_t loadCount = 0;
+
+		/** @brief Profile of the blocking load in progress
+		 */
+		static inline LoadProfile blockingProfile;
+
+		/** @brief Start of the blocking load in progress
+		 */
+		static inline TimerStamp blockingStart;
+
+		/** @brief Add finished load to the history
+		 * @param profile Profile of the load
+		 */
+		static void RecordLoad(const LoadProfile& profile)
+		{
+			loadHistory[loadCount % LOAD_HISTORY] = profile;
+			loadCount++;
+		}
+
+		/** @brief Start measuring a blocking load
+		 * @param fileName File being loaded
+		 */
+		static void BeginBlockingLoad(const char* fileName)
+		{
+			blockingProfile = LoadProfile{};
+			blockingProfile.fileName = fileName;
+			blockingStart = ReadTimer();
+		}
+
+		/** @brief Finish measuring a blocking load and add it to the history
+		 * @param result Value the load returns
+		 * @return result
+		 */
+		static int32_t EndBlockingLoad(int32_t result)
+		{
+			blockingProfile.result = result;
+			blockingProfile.totalTicks = TimerElapsed(blockingStart);
+			blockingProfile.frames = frameCounter - blockingStart.frame;
+			RecordLoad(blockingProfile);
+			return result;
+		}
+
+
+        /** @brief Round size up to the 4 byte alignment used for samples in sound RAM
+         */
+        static constexpr int32_t AlignSize(int32_t size)
+        {
+            return (size + 3) & ~3;
+        }
+
+        /** @brief Entries of a sound file selected for loading, in file order
+         */
+        static inline SndEntry soundToc[PCM::CTRL_MAX];
+
+        /** @brief Index into the caller's sample id array for each selected entry
+         */
+        static inline int16_t soundTocTarget[PCM::CTRL_MAX];
+
+        /** @brief Sound RAM reserved for each selected entry (0 once the entry is registered)
+         */
+        static inline uint32_t soundTocAddress[PCM::CTRL_MAX];
+
+        /** @brief Selected entry plays data that is already in sound RAM, or that an earlier entry loads
+         */
+        static inline bool soundTocShared[PCM::CTRL_MAX];
+
+        /** @brief Find loaded sample with the same data as a sound file entry
+         * @param entry Entry from the table of contents
+         * @return Control slot of the sample (-1 if the data is not in sound RAM)
+         */
+        static int16_t FindSharedSample(const SndEntry& entry)
+        {
+            if (entry.contentHash == 0) return -1;
+
+            uint8_t bitDepth = entry.bitDepth == (uint8_t)BitDepth::PCM8 ? PCM::TYPE_8BIT : PCM::TYPE_16BIT;
+            uint32_t length = entry.bitDepth == (uint8_t)BitDepth::PCM8 ? entry.originalSize : entry.originalSize >> 1;
+
+            for (int16_t sound = 0; sound < numberOfPCMs; sound++)
+            {
+                if (voices[sound].sample == sound && sampleHashes[sound] == entry.contentHash &&
+                    ctrlShadow[sound].bitDepth == bitDepth && voices[sound].length == length)
+                {
+                    return sound;
+                }
+            }
+
+            return -1;
+        }
+
+        /** @brief Mark selected entries whose data is already in sound RAM or repeats an earlier selected entry
+         * @param count Number of selected entries
+         * @return Sound RAM needed by the entries that still have to be loaded
+         */
+        static int32_t ShareSoundToc(int32_t count)
+        {
+            int32_t soundRam = 0;
+
+            for (int32_t index = 0; index < count; index++)
+            {
+                const SndEntry& entry = soundToc[index];
+                soundTocShared[index] = FindSharedSample(entry) >= 0;
+
+                for (int32_t earlier = 0; earlier < index && entry.contentHash != 0 && !soundTocShared[index]; earlier++)
+                {
+                    soundTocShared[index] = soundToc[earlier].contentHash == entry.contentHash &&
+                        soundToc[earlier].originalSize == entry.originalSize && soundToc[earlier].bitDepth == entry.bitDepth;
+                }
+
+                if (!soundTocShared[index])
+                {
+                    soundRam += AlignSize(entry.originalSize);
+                }
+            }
+
+            return soundRam;
+        }
+
+        /** @brief Register entry that plays the data of a loaded sample, nothing is read or uploaded
+         * @param entry Entry from the table of contents
+         * @param sample Manifest entry (nullptr to compute control values)
+         * @return Sound effect identifier (-3 if the data is no longer in sound RAM)
+         */
+        static int16_t ShareSoundEntry(const SndEntry& entry, const BankManifest::Sample* sample)
+        {
+            int16_t source = FindSharedSample(entry);
+            if (source < 0) return -3;
+
+            return RegisterEntry(entry, GetSampleAddress(source), sample);
+        }
+
+        /** @brief Reserve sound RAM for all selected entries that are not shared, nothing is reserved on failure
+         * @param count Number of selected entries
+         * @return true if every entry got sound RAM
+         */
+        static bool ReserveSoundToc(int32_t count)
+        {
+            int32_t total = 0;
+            int32_t blocks = 0;
+
+            for (int32_t index = 0; index < count; index++)
+            {
+                soundTocAddress[index] = 0;
+
+                if (!soundTocShared[index])
+                {
+                    total += AlignSize(soundToc[index].originalSize);
+                    blocks++;
+                }
+            }
+
+            if (blocks == 0) return true;
+
+            // One run keeps a bank together and leaves fewer gaps, it is then cut into a block per entry
+            uint32_t address = soundRamBlockCount + blocks <= PCM::CTRL_MAX ? AllocateSoundRam(total) : 0;
+
+            if (address != 0)
+            {
+                int16_t first = FindSoundRamBlock(address);
+
+                for (int16_t block = soundRamBlockCount - 1; block > first; block--)
+                {
+                    soundRamBlocks[block + blocks - 1] = soundRamBlocks[block];
+                }
+
+                for (int32_t index = 0; index < count; index++)
+                {
+                    if (soundTocShared[index]) continue;
+
+                    uint32_t size = (uint32_t)AlignSize(soundToc[index].originalSize);
+                    soundRamBlocks[first++] = SoundRamBlock{ address, size, -1, false };
+                    soundTocAddress[index] = address;
+                    address += size;
+                }
+
+                soundRamBlockCount += blocks - 1;
+                return true;
+            }
+
+            for (int32_t index = 0; index < count; index++)
+            {
+                if (soundTocShared[index]) continue;
+
+                soundTocAddress[index] = AllocateSoundRam(soundToc[index].originalSize);
+
+                if (soundTocAddress[index] == 0)
+                {
+                    ReleaseSoundToc(index);
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /** @brief Release sound RAM of selected entries that were not registered
+         * @param count Number of selected entries
+         */
+        static void ReleaseSoundToc(int32_t count)
+        {
+            for (int32_t index = 0; index < count; index++)
+            {
+                if (soundTocAddress[index] != 0)
+                {
+                    ReleaseSoundRam(soundTocAddress[index]);
+                    soundTocAddress[index] = 0;
+                }
+            }
+        }
+
+        /** @brief Find where a sound file entry goes in the caller's sample id array
+         * @param index Entry index in the file
+         * @param nameHash Entry name hash
+         * @param indices Requested entry indexes (nullptr to select by name or take all)
+         * @param hashes Requested name hashes (nullptr to select by index or take all)
+         * @param count Number of requested entries (or maximum number of entries to take all)
+         * @return Index into the sample id array (< 0 if entry is not selected)
+         */
+        static int16_t SelectEntry(int32_t index, uint32_t nameHash, const int16_t* indices, const uint32_t* hashes, int32_t count)
+        {
+            if (indices == nullptr && hashes == nullptr)
+            {
+                return index < count ? index : -1;
+            }
+
+            for (int16_t target = 0; target < count; target++)
+            {
+                if ((indices != nullptr && indices[target] == index) || (hashes != nullptr && hashes[target] == nameHash))
+                {
+                    return target;
+                }
+            }
+
+            return -1;
+        }
+
+        /** @brief Check that a table of contents entry is the one a manifest was generated from
+         * @param entry Entry from the file
+         * @param sample Manifest entry
+         */
+        static constexpr bool MatchesManifest(const SndEntry& entry, const BankManifest::Sample& sample)
+        {
+            return entry.nameHash == sample.nameHash && entry.offset == sample.fileOffset &&
+                entry.compressedSize == sample.compressedSize && entry.originalSize == sample.originalSize &&
+                entry.sampleRate == sample.sampleRate && entry.bitDepth == sample.bitDepth &&
+                entry.loopStart == sample.loopStart && entry.loopEnd == sample.loopEnd && entry.contentHash == sample.contentHash;
+        }
+
+        /** @brief Register loaded sound file entry, from precomputed values if there is a manifest entry
+         * @param entry Entry that was loaded
+         * @param address Sound RAM of the entry
+         * @param sample Manifest entry (nullptr to compute control values)
+         * @return Sound effect identifier
+         */
+        static int16_t RegisterEntry(const SndEntry& entry, uint32_t address, const BankManifest::Sample* sample)
+        {
+            int16_t sound = sample != nullptr ?
+                RegisterSample(address, (BitDepth)sample->bitDepth, sample->pitchWord, sample->bytesPerBlank, sample->playSize) :
+                RegisterPcm(address, entry.originalSize, (BitDepth)entry.bitDepth, entry.sampleRate);
+
+            SetLoopPoints(sound, entry.loopStart, entry.loopEnd);
+            sampleHashes[sound] = entry.contentHash;
+            return sound;
+        }
+
+        /** @brief Set loop points of a sample, checked by the caller
+         * @param sound Control slot of the sample
+         * @param loopStart Loop start in samples
+         * @param loopEnd Loop end in samples (0 for the end of the sample)
+         */
+        static void SetLoopPoints(int16_t sound, uint16_t loopStart, uint16_t loopEnd)
+        {
+            ctrlShadow[sound].LSA = loopStart;
+            ctrlShadow[sound].playSize = loopEnd != 0 ? loopEnd : voices[sound].length;
+            MarkDirty(sound);
+        }
+
+        /** @brief Load one sound file entry, blocking
+         * @param entry Entry to load, soundReader must be at its payload
+         * @param address Sound RAM allocated for the entry
+         * @param sample Manifest entry (nullptr to compute control values)
+         * @return Sound effect identifier
+         */
+        static int16_t LoadSoundEntry(const SndEntry& entry, uint32_t address, const BankManifest::Sample* sample = nullptr)
+        {
+            uint32_t destination = address + SNDRAM;
+
+            if (entry.compressedSize == 0)
+            {
+                // RAW PCM
+                soundReader.Read((void*)destination, entry.originalSize, true);
+            }
+            else
+            {
+                // COMPRESSED PCM, decoded one sector of input at a time straight to sound RAM
+                int32_t end = soundReader.Tell() + entry.compressedSize;
+                lzssStream.Begin(destination, entry.originalSize, soundReader.GetProfile());
+
+                while (soundReader.Tell() < end && !lzssStream.IsComplete())
+                {
+                    int32_t available = soundReader.Poll(true);
+                    if (available <= 0) break;
+
+                    int32_t budget = entry.originalSize;
+                    available = available > (end - soundReader.Tell()) ? (end - soundReader.Tell()) : available;
+                    soundReader.Skip(lzssStream.Feed(soundReader.Data(), available, budget));
+                }
+
+                lzssStream.Finish();
+                soundReader.Seek(end);
+            }
+
+            return RegisterEntry(entry, address, sample);
+        }
+
+        /** @brief Load selected entries of a packed sound file (version 1 or 2)
+         * @param fileName File name (.snd)
+         * @param sounds Array to hold sample ids
+         * @param indices Requested entry indexes (nullptr to select by name or take all)
+         * @param hashes Requested name hashes (nullptr to select by index or take all)
+         * @param count Number of requested entries (or maximum number of entries to take all)
+         * @param manifest Manifest the file must match, all entries are taken (nullptr for none)
+         * @return Number of samples loaded (-1 file not found, -2 out of control slots, -3 out of sound RAM, -4 bad file)
+         */
+        static int32_t LoadSoundEntries(const char* fileName, int16_t* sounds, const int16_t* indices, const uint32_t* hashes, int32_t count, const BankManifest* manifest = nullptr)
+        {
+            // Table of contents and LZSS window are shared with the Loader, so queued requests are finished first
+            while (!Loader::IsIdle()) Loader::Update();
+
+            BeginBlockingLoad(fileName);
+            soundReader.SetProfile(&blockingProfile);
+            int32_t loaded = ReadSoundEntries(fileName, sounds, indices, hashes, count, manifest);
+            soundReader.SetProfile(nullptr);
+            return EndBlockingLoad(loaded);
+        }
+
+        /** @brief Load selected entries of a packed sound file without measuring it, see LoadSoundEntries()
+         */
+        static int32_t ReadSoundEntries(const char* fileName, int16_t* sounds, const int16_t* indices, const uint32_t* hashes, int32_t count, const BankManifest* manifest)
+        {
+            if (!soundReader.Open(fileName)) return -1;
+
+            SndHeader header{};
+            int32_t loaded = 0;
+
+            if (soundReader.Read(&header, sizeof(SndHeader)) == sizeof(SndHeader) && ToHostOrder(header).magic == SND_MAGIC)
+            {
+                if (header.version != SND_VERSION || header.entrySize < SND_ENTRY_MIN_SIZE ||
+                    sizeof(SndHeader) + ((int32_t)header.entryCount * header.entrySize) > (uint32_t)soundReader.Size() ||
+                    (manifest != nullptr && (header.entryCount != manifest->count || header.soundRamSize != manifest->soundRamSize)))
+                {
+                    soundReader.Close();
+                    return -4;
+                }
+
+                // Table of contents is read in one pass, only selected entries are kept
+                int32_t selected = 0;
+
+                for (int32_t index = 0; index < header.entryCount && selected < PCM::CTRL_MAX; index++)
+                {
+                    SndEntry entry{};
+                    soundReader.Seek(sizeof(SndHeader) + (index * header.entrySize));
+                    soundReader.Read(&entry, header.entrySize < sizeof(SndEntry) ? header.entrySize : sizeof(SndEntry));
+                    ToHostOrder(entry);
+
+                    int16_t target = SelectEntry(index, entry.nameHash, indices, hashes, count);
+
+                    if (target >= 0 && (!IsValidSndEntry(entry, entry.offset, soundReader.Size()) ||
+                        (manifest != nullptr && !MatchesManifest(entry, manifest->samples[index]))))
+                    {
+                        soundReader.Close();
+                        return -4;
+                    }
+
+                    if (target >= 0)
+                    {
+                        soundToc[selected] = entry;
+                        soundTocTarget[selected] = target;
+                        selected++;
+                    }
+                }
+
+                // Entries whose data is already in sound RAM only take a control slot
+                int32_t soundRam = ShareSoundToc(selected);
+
+                // Check budget before sound RAM is touched
+                if (GetFreeSlots() < selected)
+                {
+                    soundReader.Close();
+                    return -2;
+                }
+
+                // Free space is only a quick reject, the allocation decides whether it fits around other samples
+                if (soundRam > SoundRam::GetFreeSpace() || !ReserveSoundToc(selected))
+                {
+                    soundReader.Close();
+                    return -3;
+                }
+
+                // Payloads are stored in table order, so this is one sequential read
+                for (loaded = 0; loaded < selected; loaded++)
+                {
+                    const BankManifest::Sample* sample = manifest != nullptr ? &manifest->samples[soundTocTarget[loaded]] : nullptr;
+
+                    if (soundTocShared[loaded])
+                    {
+                        sounds[soundTocTarget[loaded]] = ShareSoundEntry(soundToc[loaded], sample);
+                        blockingProfile.bytesShared += soundToc[loaded].originalSize;
+                        continue;
+                    }
+
+                    soundReader.Seek(soundToc[loaded].offset);
+                    sounds[soundTocTarget[loaded]] = LoadSoundEntry(soundToc[loaded], soundTocAddress[loaded], sample);
+                    soundTocAddress[loaded] = 0;
+                }
+            }
+            else if (manifest != nullptr)
+            {
+                // Manifests are only generated for version 2 files
+                soundReader.Close();
+                return -4;
+            }
+            else
+            {
+                // Version 1 file is a plain run of headers and payloads
+                soundReader.Seek(0);
+
+                for (int32_t index = 0; loaded < count; index++)
+                {
+                    PcmHeader pcmHeader;
+                    if (soundReader.Read(&pcmHeader, sizeof(PcmHeader)) != sizeof(PcmHeader)) break;
+                    ToHostOrder(pcmHeader);
+
+                    SndEntry entry{};
+                    entry.compressedSize = pcmHeader.compressedSize;
+                    entry.originalSize = pcmHeader.originalSize;
+                    entry.sampleRate = pcmHeader.sampleRate;
+                    entry.bitDepth = (uint8_t)pcmHeader.bitDepth;
+
+                    int32_t payloadSize = entry.compressedSize != 0 ? entry.compressedSize : entry.originalSize;
+
+                    if (!IsValidSndEntry(entry, soundReader.Tell(), soundReader.Size()))
+                    {
+                        soundReader.Close();
+                        return -4;
+                    }
+
+                    // Version 1 has no names, so only index selection applies
+                    int16_t target = hashes == nullptr ? SelectEntry(index, 0, indices, nullptr, count) : -1;
+
+                    if (target < 0)
+                    {
+                        soundReader.Skip(payloadSize);
+                        continue;
+                    }
+
+                    if (GetFreeSlots() <= 0)
+                    {
+                        soundReader.Close();
+                        return -2;
+                    }
+
+                    uint32_t address = AllocateSoundRam(entry.originalSize);
+
+                    if (address == 0)
+                    {
+                        soundReader.Close();
+                        return -3;
+                    }
+
+                    sounds[target] = LoadSoundEntry(entry, address);
+                    loaded++;
+                }
+            }
+
+            soundReader.Close();
+            return loaded;
+        }
+
+        /** @brief Load raw PCM file without measuring it, see Pcm::LoadPcm()
+         */
+        static int16_t ReadPcmFile(const char* fileName, const BitDepth bitDepth, const int32_t sampleRate)
+        {
+            if (GetFreeSlots() <= 0) return -2;
+            if (!soundReader.Open(fileName)) return -4;
+
+            int32_t fileSize = soundReader.Size();
+
+            if (fileSize > (128 * 1024) && bitDepth == BitDepth::PCM16)
+            {
+                return -3;
+            }
+            else if (fileSize > (64 * 1024) && bitDepth == BitDepth::PCM8)
+            {
+                return -3;
+            }
+
+            fileSize += ((uint32_t)fileSize & 1) ? 1 : 0;
+            fileSize += ((uint32_t)fileSize & 3) ? 2 : 0;
+
+            uint32_t address = AllocateSoundRam(fileSize);
+            if (address == 0) return -1;
+
+            soundReader.Read((void*)(address + SNDRAM), fileSize, true);
+            return RegisterPcm(address, fileSize, bitDepth, sampleRate);
+        }
+
+        /** @brief Load ADX file without measuring it, see Pcm::LoadAdx()
+         */
+        static int16_t ReadAdxFile(const char* fileName)
+        {
+            if (GetFreeSlots() <= 0) return -2;
+            if (!soundReader.Open(fileName)) return -5;
+
+            AdxHeader adxHeader{};
+
+            if (soundReader.Read(&adxHeader, sizeof(AdxHeader)) != sizeof(AdxHeader) || !IsValidAdxHeader(ToHostOrder(adxHeader)))
+            {
+                return -4;
+            }
+
+            uint32_t bytesToLoad = (adxHeader.sampleCount / 32) * 18;
+            bytesToLoad += ((uint32_t)bytesToLoad & 1) ? 1 : 0;
+            bytesToLoad += ((uint32_t)bytesToLoad & 3) ? 2 : 0;
+
+            uint32_t address = AllocateSoundRam(bytesToLoad);
+            if (address == 0) return -1;
+
+            uint32_t workAddress = address + 16;  // we are not copying the header so this offset is different
+            int16_t sound = RegisterAdx(adxHeader, workAddress, adxHeader.sampleCount / 32);
+
+            if (sound >= 0)
+            {
+                soundReader.Read((void*)(address + SNDRAM), bytesToLoad, true);
+            }
+            else
+            {
+                ReleaseSoundRam(address);
+            }
+
+            return sound;
+        }
+
+        /** @brief Byte range of the blocks in an ADX file
+         */
+        struct AdxRange
+        {
+            /** @brief Offset of the first block
+             */
+            int32_t dataStart;
+
+            /** @brief Offset of the block playback continues at when the stream loops
+             */
+            int32_t loopStart;
+
+            /** @brief Offset behind the last block that is played
+             */
+            int32_t loopEnd;
+        };
+
+        /** @brief Read ADX header and loop info from the start of an opened file
+         * @param reader Reader of the file
+         * @param header Read header
+         * @param range Where the blocks are, loop points are snapped to whole blocks
+         * @return false if the file is not an ADX the library can play
+         */
+        static bool ReadAdxHeader(SectorReader& reader, AdxHeader& header, AdxRange& range)
+        {
+            constexpr int32_t blockSize = 18;
+            constexpr int32_t blockSamples = 32;
+            AdxLoopInfo loopInfo{};
+
+            reader.Seek(0);
+
+            if (reader.Read(&header, sizeof(AdxHeader)) != sizeof(AdxHeader) || !IsValidAdxHeader(ToHostOrder(header)))
+            {
+                return false;
+            }
+
+            range.dataStart = header.offset2Data + 4;
+            range.loopStart = range.dataStart;
+            range.loopEnd = range.dataStart + (((int32_t)header.sampleCount / blockSamples) * blockSize);
+            range.loopEnd = range.loopEnd > reader.Size() ? reader.Size() : range.loopEnd;
+
+            // Loop info sits behind the common header, its position depends on header version
+            int32_t loopInfoOffset = header.loop == 4 ? 0x20 : 0x14;
+
+            if ((header.loop == 3 || header.loop == 4) && loopInfoOffset + (int32_t)sizeof(AdxLoopInfo) <= range.dataStart)
+            {
+                reader.Seek(loopInfoOffset);
+                reader.Read(&loopInfo, sizeof(AdxLoopInfo));
+                ToHostOrder(loopInfo);
+
+                if (loopInfo.enabled != 0 && loopInfo.endByte > loopInfo.beginByte && (int32_t)loopInfo.beginByte >= range.dataStart)
+                {
+                    range.loopStart = range.dataStart + ((((int32_t)loopInfo.beginByte - range.dataStart) / blockSize) * blockSize);
+                    int32_t end = range.dataStart + (((((int32_t)loopInfo.endByte - range.dataStart) + blockSize - 1) / blockSize) * blockSize);
+                    range.loopEnd = end < range.loopEnd ? end : range.loopEnd;
+                }
+            }
+
+            return range.loopEnd > range.loopStart;
+        }
+
+	public:
+		/** @brief Returns current number of PCMs
+		 */
+        static int16_t GetNumberOfPCMs()
+        {
+            return (numberOfPCMs - 1);
+        }
+
+		/** @brief Returns number of Play/SetVolume/Stop commands merged into the last vblank
+		 */
+        static uint16_t GetCommandCount()
+        {
+            return lastFrameCommands;
+        }
+
+		/** @brief Returns number of control slots the last vblank wrote to sound RAM
+		 */
+        static uint16_t GetCommandWrites()
+        {
+            return lastFrameSlotWrites;
+        }
+        
+		/** @brief Hardware settings and Driver initialization
+		 */
+		struct Driver
+		{
+		    /**
+			 * @brief Initializes the sound driver.
+			 * @param mode ADX data mode.
+			 * @param clearSampleArea Clear sample part of sound RAM, skip it to boot faster when every sample is loaded anyway
+			 * @return true if the driver reported ready (see Stats::GetBoot())
+			 */
+			static bool Initialize(const ADXMode mode, const bool clearSampleArea = true)
+			{
+				// Load driver
+				bool ready = LoadDriver(mode, clearSampleArea);
+				SRL::Core::OnVblank += SdrvVblankRq;
+                // Set default volumes
+                SetMasterVolume(15);
+				CD::SetVolume(15);
+				return ready;
+			}
+
+			/** @brief Set master volume
+			 * @param volume New volume (0-15)
+			 */
+			static void SetMasterVolume(uint16_t volume)
+			{
+                volume = volume >= 0xF ? 0xF : volume;
+                masterVolume = 0x200 | (volume & 0xF);
+                driverMasterVolume = volume;
+			}
+		};
+
+		/**
+		 * @brief Single sound archive (.pak) holding all audio files, built by PcmCompress.py --pack
+		 *
+		 * While an archive is open, every load by file name looks the name up in its directory first and reads the
+		 * entry from the archive, names it does not have are opened as files on CD. Entries start on whole sectors in
+		 * the order they are loaded, and their names are hashed, so they can be longer than 8.3.
+		 */
+		struct Pack
+		{
+			/** @brief Most entries an archive may have
+			 */
+			static constexpr auto MAX_ENTRIES = MAX_PACK_ENTRIES;
+
+			/** @brief Open sound archive and read its directory, the archive open before is closed
+			 * @param fileName Archive file name
+			 * @return Number of entries (-1 file not found, -2 bad file, -3 more than MAX_ENTRIES entries)
+			 */
+			static int32_t Open(const char* fileName = PACK_FILE)
+			{
+				Pack::Close();
+				if (!soundReader.Open(fileName)) return -1;
+
+				PackHeader header{};
+				int32_t result = -2;
+
+				if (soundReader.Read(&header, sizeof(PackHeader)) == sizeof(PackHeader) &&
+					ToHostOrder(header).magic == PACK_MAGIC &&
+					header.version == PACK_VERSION &&
+					header.entrySize >= sizeof(PackEntry) &&
+					sizeof(PackHeader) + (header.entryCount * header.entrySize) <= (uint32_t)soundReader.Size())
+				{
+					result = header.entryCount > MAX_PACK_ENTRIES ? -3 : (int32_t)header.entryCount;
+				}
+
+				for (int32_t entry = 0; entry < result; entry++)
+				{
+					soundReader.Seek(sizeof(PackHeader) + (entry * header.entrySize));
+					soundReader.Read(&packDirectory[entry], sizeof(PackEntry));
+					ToHostOrder(packDirectory[entry]);
+
+					// Entries lie behind the directory and inside the archive, a bad one stops the loop
+					if (packDirectory[entry].firstSector < header.dataSector ||
+						(packDirectory[entry].firstSector * SECTOR_SIZE) + packDirectory[entry].size > (uint32_t)soundReader.Size())
+					{
+						result = -2;
+					}
+				}
+
+				if (result >= 0)
+				{
+					packFileId = GFS_NameToId((Sint8*)fileName);
+					packEntryCount = (int16_t)result;
+				}
+
+				soundReader.Close();
+				return result;
+			}
+
+			/** @brief Close sound archive, later loads open files on CD again
+			 * @note Streams and loads already reading from the archive are not affected
+			 */
+			static void Close()
+			{
+				packFileId = -1;
+				packEntryCount = 0;
+			}
+
+			/** @brief Check whether a sound archive is open
+			 */
+			static bool IsOpen()
+			{
+				return packFileId >= 0;
+			}
+
+			/** @brief Get number of entries in the open sound archive
+			 */
+			static int16_t GetEntryCount()
+			{
+				return packEntryCount;
+			}
+
+			/** @brief Find entry in the open sound archive
+			 * @param name Entry name (any case)
+			 * @return Entry identifier, its index in the directory (< 0 if not found)
+			 */
+			static int16_t Find(const char* name)
+			{
+				return FindPackEntry(name);
+			}
+
+			/** @brief Get size of an entry in the open sound archive
+			 * @param entry Entry identifier
+			 * @return Size in bytes (-1 if there is no such entry)
+			 */
+			static int32_t GetSize(int16_t entry)
+			{
+				return entry >= 0 && entry < packEntryCount ? (int32_t)packDirectory[entry].size : -1;
+			}
+		};
+
+		struct Pcm
+		{
+			/** @brief Load PCM sound effect
+			 * @param file File name
+			 * @param bitDepth Bit depth of the sound effect
+			 * @param sampleRate Sample rate of the sound effect
+			 * @return Sound effect identifier (< 0 on fail)
+			 */
+			static int16_t LoadPcm(const char* fileName, const BitDepth bitDepth, const int32_t sampleRate)
+			{
+                BeginBlockingLoad(fileName);
+                soundReader.SetProfile(&blockingProfile);
+                int16_t sound = ReadPcmFile(fileName, bitDepth, sampleRate);
+                soundReader.SetProfile(nullptr);
+                soundReader.Close();
+                return EndBlockingLoad(sound);
+			}
+			
+            /** @brief Load packed PCM sound effects
+			 * @param fileName File name (.snd)
+			 * @param sounds Array to hold sample ids
+			 * @param maxSamples Maximum number of samples to load (version 2 files stop at their entry count)
+			 * @return Index of the last sample loaded (-1 file not found, -2 out of control slots, -3 out of sound RAM, -4 bad file)
+			 */
+			static int LoadSound(const char* fileName, int16_t* sounds, int maxSamples)
+			{
+				int32_t loaded = LoadSoundEntries(fileName, sounds, nullptr, nullptr, maxSamples);
+				return loaded < 0 ? loaded : loaded - 1;
+			}
+
+			/** @brief Load selected entries of packed PCM sound effects
+			 * @param fileName File name (.snd)
+			 * @param sounds Array to hold sample ids, in the same order as indices
+			 * @param indices Entry indexes to load
+			 * @param count Number of entries to load
+			 * @return Number of samples loaded (-1 file not found, -2 out of control slots, -3 out of sound RAM, -4 bad file)
+			 */
+			static int LoadSound(const char* fileName, int16_t* sounds, const int16_t* indices, int count)
+			{
+				return LoadSoundEntries(fileName, sounds, indices, nullptr, count);
+			}
+
+			/** @brief Load entries of packed PCM sound effects by PCM file name (version 2 .snd only)
+			 * @param fileName File name (.snd)
+			 * @param sounds Array to hold sample ids, in the same order as names
+			 * @param names PCM file names as listed in SOUND.json (ie "MEOW1.PCM")
+			 * @param count Number of entries to load
+			 * @return Number of samples loaded (-1 file not found, -2 out of control slots, -3 out of sound RAM, -4 bad file)
+			 */
+			static int LoadSoundByName(const char* fileName, int16_t* sounds, const char* const* names, int count)
+			{
+				uint32_t hashes[PCM::CTRL_MAX];
+				count = count > PCM::CTRL_MAX ? PCM::CTRL_MAX : count;
+
+				for (int32_t i = 0; i < count; i++)
+				{
+					hashes[i] = HashName(names[i]);
+				}
+
+				return LoadSoundEntries(fileName, sounds, nullptr, hashes, count);
+			}
+
+			/** @brief Load single entry of packed PCM sound effects by PCM file name (version 2 .snd only)
+			 * @param fileName File name (.snd)
+			 * @param name PCM file name as listed in SOUND.json (ie "MEOW1.PCM")
+			 * @return Sound effect identifier (-5 if there is no such entry, other values as LoadSoundByName())
+			 */
+			static int16_t LoadSoundByName(const char* fileName, const char* name)
+			{
+				int16_t sound = -1;
+				uint32_t hash = HashName(name);
+				int32_t loaded = LoadSoundEntries(fileName, &sound, nullptr, &hash, 1);
+				return loaded < 0 ? loaded : (loaded == 0 ? -5 : sound);
+			}
+
+			/** @brief Load every sample of a sound bank described by a generated manifest
+			 * @param bank Manifest from the bank's generated header
+			 * @param sounds Array to hold sample ids, indexed by the bank's Sample enum (bank.count entries)
+			 * @return Number of samples loaded (-1 file not found, -2 out of control slots, -3 out of sound RAM, -4 file does not match the manifest)
+			 */
+			static int32_t LoadBank(const BankManifest& bank, int16_t* sounds)
+			{
+				return LoadSoundEntries(bank.fileName, sounds, nullptr, nullptr, bank.count, &bank);
+			}
+
+			/** @brief Queue sound bank described by a generated manifest for loading by Loader::Update()
+			 * @param bank Manifest from the bank's generated header (must stay valid until the request is done)
+			 * @param sounds Array to hold sample ids, indexed by the bank's Sample enum (must stay valid until the request is done)
+			 * @return Request handle (< 0 if queue is full)
+			 */
+			static int16_t LoadBankAsync(const BankManifest& bank, int16_t* sounds)
+			{
+				int16_t request = Loader::Enqueue(Loader::RequestType::Sound, bank.fileName);
+				if (request < 0) return request;
+
+				Loader::requests[request].sounds = sounds;
+				Loader::requests[request].maxSamples = bank.count;
+				Loader::requests[request].manifest = &bank;
+				return request;
+			}
+
+			/** @brief Hash of a PCM file name as stored in version 2 .snd files (32-bit FNV-1a of the upper case name)
+			 * @param name PCM file name
+			 * @return Name hash
+			 */
+			static constexpr uint32_t HashName(const char* name)
+			{
+				uint32_t hash = 2166136261u;
+
+				for (; *name != '\0'; name++)
+				{
+					char c = *name;
+					c = (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
+					hash = (hash ^ (uint8_t)c) * 16777619u;
+				}
+
+				return hash;
+			}
+
+			/** @brief Queue packed PCM sound effects for loading by Loader::Update()
+			 * @param fileName File name (.snd, must stay valid until the request is done)
+			 * @param sounds Array to hold sample ids (must stay valid until the request is done)
+			 * @param maxSamples Number of samples in the .snd file
+			 * @return Request handle (< 0 if queue is full)
+			 */
+			static int16_t LoadSoundAsync(const char* fileName, int16_t* sounds, int maxSamples)
+			{
+				int16_t request = Loader::Enqueue(Loader::RequestType::Sound, fileName);
+				if (request < 0) return request;
+
+				Loader::requests[request].sounds = sounds;
+				Loader::requests[request].maxSamples = maxSamples;
+				return request;
+			}
+
+			/** @brief Queue PCM sound effect for loading by Loader::Update()
+			 * @param fileName File name (must stay valid until the request is done)
+			 * @param bitDepth Bit depth of the sound effect
+			 * @param sampleRate Sample rate of the sound effect
+			 * @return Request handle (< 0 if queue is full)
+			 */
+			static int16_t LoadPcmAsync(const char* fileName, const BitDepth bitDepth, const int32_t sampleRate = 15360)
+			{
+				int16_t request = Loader::Enqueue(Loader::RequestType::Pcm, fileName);
+				if (request < 0) return request;
+
+				Loader::requests[request].bitDepth = bitDepth;
+				Loader::requests[request].sampleRate = sampleRate;
+				return request;
+			}
+
+			/** @brief Queue ADX sound effect for loading by Loader::Update()
+			 * @param fileName File name (must stay valid until the request is done)
+			 * @return Request handle (< 0 if queue is full)
+			 */
+			static int16_t LoadAdxAsync(const char* fileName)
+			{
+				return Loader::Enqueue(Loader::RequestType::Adx, fileName);
+			}
+
+			/** @brief Load 8 bit PCM sound effect
+			 * @param file File name
+			 * @param sampleRate Sample rate of the sound effect
+			 * @return Sound effect identifier (< 0 on fail)
+			 */
+			static int16_t Load8(const char* fileName, const int32_t sampleRate = 15360)
+			{
+			    return LoadPcm(fileName, BitDepth::PCM8, sampleRate);
+			}
+			
+			/** @brief Load 16 bit PCM sound effect
+			 * @param file File name
+			 * @param sampleRate Sample rate of the sound effect
+			 * @return Sound effect identifier (< 0 on fail)
+			 */
+			static int16_t Load16(const char* fileName, const int32_t sampleRate = 15360)
+			{
+			    return LoadPcm(fileName, BitDepth::PCM16, sampleRate);
+			}
+			
+			/** @brief Load ADX sound effect
+			 * @param fileName File name
+			 * @return Sound effect identifier (< 0 on fail)
+			 */
+			static int16_t LoadAdx(const char* fileName)
+			{
+                BeginBlockingLoad(fileName);
+                soundReader.SetProfile(&blockingProfile);
+                int16_t sound = ReadAdxFile(fileName);
+                soundReader.SetProfile(nullptr);
+                soundReader.Close();
+                return EndBlockingLoad(sound);
+			}
+
+			/** @brief Set volume of currently playing sound
+			 * @param sound Sound to modify (all of its instances), or instance handle returned by Play()
+			 * @param volume New volume (0-7)
+			 * @param pan Stereo pan to set (right being 0, left being 16)
+			 */
+			static void SetVolume(const int16_t sound, const uint8_t volume, const uint8_t pan = 7)
+			{
+				if (sound < 0) return;
+
+				if (sound >= (1 << VOICE_HANDLE_SHIFT))
+				{
+					int16_t slot = ResolveVoice(sound);
+					if (slot < 0) return;
+
+					voices[slot].volume = volume;
+					voices[slot].pan = pan;
+					CancelEnvelope(slot, 0);
+					QueueCommand(slot, COMMAND_VOLUME | COMMAND_PAN, volume, pan);
+					return;
+				}
+
+				for (int16_t slot = 0; slot < numberOfPCMs; slot++)
+				{
+					if (slot == sound || (voices[slot].sample == sound && IsVoiceActive(slot)))
+					{
+						voices[slot].volume = volume;
+						voices[slot].pan = pan;
+						CancelEnvelope(slot, 0);
+						QueueCommand(slot, COMMAND_VOLUME | COMMAND_PAN, volume, pan);
+					}
+				}
+			}
+
+			/** @brief Stop playing sound
+			 * @param sound Sound to stop (all of its instances), or instance handle returned by Play()
+			 */
+			static void Stop(const int16_t sound)
+			{
+				if (sound < 0) return;
+
+				if (sound >= (1 << VOICE_HANDLE_SHIFT))
+				{
+					int16_t slot = ResolveVoice(sound);
+					if (slot >= 0) StopVoice(slot);
+					return;
+				}
+
+				for (int16_t slot = 0; slot < numberOfPCMs; slot++)
+				{
+					if (slot == sound || (voices[slot].sample == sound && IsVoiceActive(slot)))
+					{
+						StopVoice(slot);
+					}
+				}
+			}
+
+			/** @brief Change volume of a playing sound gradually, one step per vblank
+			 * @param sound Sound to modify (all of its instances), or instance handle returned by Play()
+			 * @param volume Volume at the end (0-7)
+			 * @param frames Length of the fade in frames (0 changes the volume right away)
+			 * @return false if nothing is playing, or no envelope was free and the volume was set right away
+			 */
+			static bool FadeTo(const int16_t sound, const uint8_t volume, const uint16_t frames)
+			{
+				return FadeVoices(sound, volume, frames, false, false);
+			}
+
+			/** @brief Fade playing sound out and stop it, instead of the click of Stop() cutting it at full volume
+			 * @param sound Sound to stop (all of its instances), or instance handle returned by Play()
+			 * @param frames Length of the fade in frames (0 stops right away)
+			 * @return false if nothing is playing, or no envelope was free and the sound was stopped right away
+			 */
+			static bool FadeOut(const int16_t sound, const uint16_t frames)
+			{
+				return FadeVoices(sound, 0, frames, true, false);
+			}
+
+			/** @brief Stop playing sound after a number of frames
+			 * @param sound Sound to stop (all of its instances), or instance handle returned by Play()
+			 * @param frames Frames to keep playing (0 stops right away)
+			 * @return false if nothing is playing, or no envelope was free and the sound was stopped right away
+			 */
+			static bool StopAfter(const int16_t sound, const uint16_t frames)
+			{
+				return FadeVoices(sound, 0, frames, true, true);
+			}
+
+			/** @brief Play sound starting silent and fade it in
+			 * @param sound Sound to play
+			 * @param frames Length of the fade in frames
+			 * @param mode Loop/Playback mode
+			 * @param volume Volume at the end of the fade
+			 * @param priority Priority of this instance (higher keeps its voice)
+			 * @return Instance handle (< 0 if no voice could be taken)
+			 */
+			static int16_t FadeIn(int16_t sound,
+				uint16_t frames,
+				PlayMode mode = PlayMode::Protected,
+				uint8_t volume = 7,
+				uint8_t priority = Voice::DEFAULT_PRIORITY)
+			{
+				int16_t handle = Play(sound, mode, frames > 0 ? 0 : volume, priority);
+				if (handle >= 0 && frames > 0) FadeVoices(handle, volume, frames, false, false);
+				return handle;
+			}
+
+			/** @brief Fade one sound out and another one in over the same frames
+			 * @param from Sound (all of its instances) or instance handle to fade out and stop
+			 * @param to Sound to play
+			 * @param frames Length of the crossfade in frames
+			 * @param mode Loop/Playback mode of the new sound
+			 * @param volume Volume of the new sound at the end of the crossfade
+			 * @param priority Priority of the new instance
+			 * @return Instance handle of the new sound (< 0 if no voice could be taken)
+			 */
+			static int16_t Crossfade(const int16_t from,
+				int16_t to,
+				uint16_t frames,
+				PlayMode mode = PlayMode::Protected,
+				uint8_t volume = 7,
+				uint8_t priority = Voice::DEFAULT_PRIORITY)
+			{
+				FadeOut(from, frames);
+				return FadeIn(to, frames, mode, volume, priority);
+			}
+
+			/** @brief Set how many instances of a sound can play at once
+			 * @param sound Sound to modify
+			 * @param maxInstances Maximum number of instances (ADX and stream sounds are limited to 1)
+			 */
+			static void SetMaxInstances(const int16_t sound, const uint8_t maxInstances)
+			{
+				if (sound < 0 || sound >= numberOfPCMs || voices[sound].sample != sound) return;
+
+				int16_t block = FindSoundRamBlock(sound);
+				if (ctrlShadow[sound].bitDepth == PCM::TYPE_ADX || (block >= 0 && soundRamBlocks[block].locked)) return;
+
+				voices[sound].maxInstances = maxInstances > 0 ? maxInstances : 1;
+			}
+
+			/** @brief Set loop points of a PCM sample (.snd entries get the ones from SOUND.json at load)
+			 * @details PlayMode::ForwardLoop, ReversLoop and AlternatingLoop play from the start to loopEnd once and then
+			 * repeat loopStart to loopEnd, so an intro with a short sustain loop does not need the sustain stored twice.
+			 * One shot modes stop at loopEnd. Takes effect the next time the sound is played.
+			 * @param sound Sound to modify
+			 * @param loopStart Loop start in samples from the start of the sample
+			 * @param loopEnd Loop end in samples (0 for the end of the sample)
+			 * @return false if sound is not a loaded PCM sample or the points are outside of it
+			 */
+			static bool SetLoop(const int16_t sound, const uint16_t loopStart, const uint16_t loopEnd = 0)
+			{
+				if (sound < 0 || sound >= numberOfPCMs || voices[sound].sample != sound) return false;
+
+				int16_t block = FindSoundRamBlock(sound);
+				if (ctrlShadow[sound].bitDepth == PCM::TYPE_ADX || (block >= 0 && soundRamBlocks[block].locked)) return false;
+
+				uint16_t end = loopEnd != 0 ? loopEnd : voices[sound].length;
+				if (end > voices[sound].length || loopStart >= end) return false;
+
+				SetLoopPoints(sound, loopStart, loopEnd);
+				return true;
+			}
+
+			/** @brief Will remove all sounds after the specified sound
+			 * @param lastToKeep Index of the last sound to be kept loaded
+			 */
+			static void Unload(const int16_t lastTokeep)
+			{
+				// Highest slot is always in use, free slots below it are trimmed as it goes
+				while (numberOfPCMs > 0 && numberOfPCMs - 1 > lastTokeep)
+				{
+					ReleaseSound(numberOfPCMs - 1);
+				}
+			}
+
+			/** @brief Remove single sound and return its sound RAM and control slot
+			 * @param sound Sound to remove
+			 * @return false if sound is not loaded or belongs to an open stream (use its Close() instead)
+			 */
+			static bool Free(const int16_t sound)
+			{
+				if (sound < 0 || sound >= numberOfPCMs || voices[sound].sample != sound) return false;
+
+				int16_t block = FindSoundRamBlock(sound);
+				if (block >= 0 && soundRamBlocks[block].locked) return false;
+
+				ReleaseSound(sound);
+				return true;
+			}
+
+			/** @brief Play sound
+			 * @details Sound plays on its own control slot, extra instances are placed on free control slots.
+			 * When the sound is at its instance limit, or Voice::SetLimit() voices already play, a voice with
+			 * the same or lower priority is stolen.
+			 * @param sound Sound to play
+			 * @param mode Loop/Playback mode mode
+			 * @param volume Starting volume
+			 * @param priority Priority of this instance (higher keeps its voice)
+			 * @return Instance handle for SetVolume() and Stop() (< 0 if no voice could be taken)
+			 */
+            static int16_t Play(int16_t sound,
+            PlayMode mode = PlayMode::Protected,
+            uint8_t volume = 7, // 15?
+            uint8_t priority = Voice::DEFAULT_PRIORITY)
+            {
+				if (sound < 0 || sound >= numberOfPCMs || voices[sound].sample != sound) return -1;
+
+				int16_t slot = -1;
+
+				if (!IsVoiceActive(sound))
+				{
+					slot = sound;
+				}
+				else if (CountVoices(sound) < voices[sound].maxInstances)
+				{
+					if (GetFreeSlots() <= 0)
+					{
+						// Out of control slots, take one from an extra instance of any sound
+						int16_t victim = FindVictim(-1, priority, true);
+
+						if (victim >= 0 && voices[victim].sample == sound)
+						{
+							slot = victim;
+						}
+						else if (victim >= 0)
+						{
+							ReleaseSlot(victim);
+						}
+					}
+
+					slot = slot < 0 ? CloneVoice(sound) : slot;
+				}
+
+				if (slot < 0)
+				{
+					slot = FindVictim(sound, priority, false);
+					if (slot < 0) return -1;
+				}
+
+				if (IsVoiceActive(slot))
+				{
+					StopVoice(slot);
+				}
+				else if (CountVoices(-1) >= voiceLimit)
+				{
+					int16_t victim = FindVictim(-1, priority, false);
+
+					if (victim < 0)
+					{
+						if (slot != sound) ReleaseSlot(slot);
+						return -1;
+					}
+
+					StopVoice(victim);
+				}
+
+				return StartVoice(slot, mode, volume, priority);
+			}
+
+			/** @brief Check whether sound is playing, only work RAM state is read
+			 * @param sound Sound (any of its instances), or instance handle returned by Play()
+			 * @return true while playing (one shot sounds count until their estimated end)
+			 */
+			static bool IsPlaying(const int16_t sound)
+			{
+				if (sound < 0) return false;
+				if (sound >= (1 << VOICE_HANDLE_SHIFT)) return ResolveVoice(sound) >= 0;
+				return sound < numberOfPCMs && voices[sound].sample == sound && CountVoices(sound) > 0;
+			}
+
+			/** @brief Get volume last given to a sound, only work RAM state is read
+			 * @param sound Sound (volume of its own slot), or instance handle returned by Play()
+			 * @return Volume (0-7, 0 if the instance is no longer playing)
+			 */
+			static uint8_t GetVolume(const int16_t sound)
+			{
+				int16_t slot = sound >= (1 << VOICE_HANDLE_SHIFT) ? ResolveVoice(sound) : sound;
+				if (slot < 0 || slot >= numberOfPCMs || voices[slot].sample < 0) return 0;
+				return voices[slot].volume;
+			}
+
+			/** @brief Get number of voices started by Play() that are still playing, only work RAM state is read
+			 */
+			static int16_t GetActiveVoiceCount()
+			{
+				return CountVoices(-1);
+			}
+		};
+		
+		/** @brief Voice allocation settings for Pcm::Play()
+		 *
+		 * Every control slot the driver has can play one voice. A sound plays on its own slot first, further instances
+		 * take free slots and point them at the same sample data, so loaded sounds and extra instances share CTRL_MAX slots.
+		 * Whether a one shot voice is done is estimated from its length, looping voices play until stopped.
+		 */
+		struct Voice
+		{
+			/** @brief Priority Pcm::Play() uses when none is given
+			 */
+			static constexpr uint8_t DEFAULT_PRIORITY = 128;
+
+			/** @brief Number of instances a PCM sound can play at once after loading
+			 */
+			static constexpr uint8_t DEFAULT_INSTANCES = 4;
+
+			/** @brief Number of SCSP slots
+			 */
+			static constexpr int16_t HARDWARE_VOICES = 32;
+
+			/** @brief Set maximum number of voices started by Pcm::Play() that play at once
+			 * @param limit Number of voices (1 to CTRL_MAX, default HARDWARE_VOICES)
+			 */
+			static void SetLimit(int16_t limit)
+			{
+				voiceLimit = limit < 1 ? 1 : (limit > PCM::CTRL_MAX ? PCM::CTRL_MAX : limit);
+			}
+
+			/** @brief Get maximum number of voices started by Pcm::Play() that play at once
+			 */
+			static int16_t GetLimit()
+			{
+				return voiceLimit;
+			}
+
+			/** @brief Set which voice is stolen among voices of the lowest priority
+			 * @param mode Steal mode
+			 */
+			static void SetStealMode(StealMode mode)
+			{
+				voiceStealMode = mode;
+			}
+
+			/** @brief Get number of voices started by Pcm::Play() that are still playing
+			 */
+			static int16_t GetActiveCount()
+			{
+				return CountVoices(-1);
+			}
+
+			/** @brief Get number of instances of a sound that are still playing
+			 * @param sound Sound to check
+			 */
+			static int16_t GetInstanceCount(int16_t sound)
+			{
+				return sound < 0 ? 0 : CountVoices(sound);
+			}
+
+			/** @brief Check whether an instance is still playing
+			 * @param handle Instance handle returned by Pcm::Play()
+			 */
+			static bool IsActive(int16_t handle)
+			{
+				return handle >= (1 << VOICE_HANDLE_SHIFT) && ResolveVoice(handle) >= 0;
+			}
+		};
+
+		/** @brief Positional audio, volume and pan of many voices worked out from emitter positions in one pass
+		 *
+		 * Emitters are voices started by Pcm::Play() with a position in world space. Update() places them around the
+		 * listener using a distance table built by SetRange() and a pan table built at compile time, so each emitter
+		 * costs a few multiplies and one divide. Only voices whose volume or pan changed are queued for the vblank.
+		 */
+		struct Spatial
+		{
+			/** @brief Sound source in world space
+			 */
+			struct Emitter
+			{
+				/** @brief World position
+				 */
+				Vector3D position;
+
+				/** @brief Instance handle returned by Pcm::Play() (emitters whose voice stopped are skipped)
+				 */
+				int16_t voice;
+
+				/** @brief Volume at or inside the minimum distance (0-7)
+				 */
+				uint8_t volume;
+			};
+
+			/** @brief Number of steps of the distance table, indexed by squared distance
+			 */
+			static constexpr int16_t DISTANCE_STEPS = 64;
+
+			/** @brief Number of steps of the pan table, indexed by squared sideways share of the distance
+			 */
+			static constexpr int16_t PAN_STEPS = 32;
+
+		private:
+			/** @brief Distance table and scale of the current range
+			 */
+			struct Range
+			{
+				/** @brief Right shift from 16.16 world units to range units
+				 */
+				int32_t shift;
+
+				/** @brief Maximum distance in range units
+				 */
+				int32_t units;
+
+				/** @brief Squared maximum distance in range units
+				 */
+				uint32_t maxSquared;
+
+				/** @brief Squared distance to table index multiplier (20 bit fraction)
+				 */
+				uint32_t scale;
+
+				/** @brief Volume multiplier per step (256 being full volume)
+				 */
+				uint16_t gain[DISTANCE_STEPS];
+			};
+
+			/** @brief Pan level per step of the squared sideways share
+			 */
+			struct PanTable
+			{
+				uint8_t level[PAN_STEPS + 1];
+			};
+
+			/** @brief Build distance table
+			 * @param minDistance Full volume distance (16.16)
+			 * @param maxDistance Silent distance (16.16)
+			 */
+			static constexpr Range BuildRange(int32_t minDistance, int32_t maxDistance)
+			{
+				Range built = {};
+				maxDistance = maxDistance > 0 ? maxDistance : 1;
+				minDistance = minDistance < 0 ? 0 : (minDistance >= maxDistance ? maxDistance - 1 : minDistance);
+
+				// Up to 10 bits per axis keeps the sum of three squares and its table index inside 32 bits
+				while ((maxDistance >> built.shift) > 1023) built.shift++;
+
+				built.units = (maxDistance >> built.shift) > 0 ? (maxDistance >> built.shift) : 1;
+				built.maxSquared = (uint32_t)(built.units * built.units);
+				built.scale = ((uint32_t)DISTANCE_STEPS << 20) / built.maxSquared;
+
+				// Step i starts at sqrt(i / DISTANCE_STEPS) of the maximum, in 1/256
+				uint32_t start = (uint32_t)(((int64_t)minDistance << 8) / maxDistance);
+
+				for (int16_t step = 0; step < DISTANCE_STEPS; step++)
+				{
+					uint32_t distance = CalculateSqrt((uint32_t)step * (65536 / DISTANCE_STEPS));
+					built.gain[step] = distance <= start ? 256 : (uint16_t)((256 * (256 - distance)) / (256 - start));
+				}
+
+				return built;
+			}
+
+			/** @brief Build pan table, the far channel is turned down by 3 dB steps up to muted when fully to one side
+			 */
+			static constexpr PanTable BuildPanTable()
+			{
+				PanTable built = {};
+
+				for (int16_t step = 0; step <= PAN_STEPS; step++)
+				{
+					built.level[step] = (uint8_t)CalculateSqrt((uint32_t)(step * 225) / PAN_STEPS);
+				}
+
+				return built;
+			}
+
+			static inline const PanTable panLevels = BuildPanTable();
+			static inline Vector3D listener = {};
+			static inline int32_t right[3] = { 1 << 16, 0, 0 };
+			static inline Range range = BuildRange(0, 1024 << 16);
+
+		public:
+			/** @brief Set listener position and orientation
+			 * @param position World position
+			 * @param right Unit vector pointing to the listener's right
+			 */
+			static void SetListener(const Vector3D& position, const Vector3D& right)
+			{
+				Spatial::listener = position;
+				Spatial::right[0] = right.X.RawValue();
+				Spatial::right[1] = right.Y.RawValue();
+				Spatial::right[2] = right.Z.RawValue();
+			}
+
+			/** @brief Set distances sounds fade over, volume falls linearly from the minimum to silence at the maximum
+			 * @param minDistance Distance up to which emitters play at full volume
+			 * @param maxDistance Distance from which emitters are silent
+			 */
+			static void SetRange(const Fxp& minDistance, const Fxp& maxDistance)
+			{
+				Spatial::range = BuildRange(minDistance.RawValue(), maxDistance.RawValue());
+			}
+
+			/** @brief Set volume and pan of every emitter's voice
+			 * @param emitters Emitters to update
+			 * @param count Number of emitters
+			 * @return Number of voices whose volume or pan changed
+			 */
+			static int16_t Update(const Emitter* emitters, const int16_t count)
+			{
+				// Centered, fully to one side mutes the far channel, default range works in 512 units
+				static_assert(BuildPanTable().level[0] == 0 && BuildPanTable().level[PAN_STEPS] == 15);
+				static_assert(BuildRange(0, 1024 << 16).shift == 17 && BuildRange(0, 1024 << 16).gain[0] == 256);
+				static_assert(BuildRange(512 << 16, 1024 << 16).gain[DISTANCE_STEPS / 4] == 256 && BuildRange(0, 1024 << 16).gain[DISTANCE_STEPS - 1] < 8);
+
+				int16_t changed = 0;
+				int32_t limit = Spatial::range.units;
+
+				for (int16_t index = 0; index < count; index++)
+				{
+					const Emitter& emitter = emitters[index];
+					int16_t slot = emitter.voice >= (1 << VOICE_HANDLE_SHIFT) ? ResolveVoice(emitter.voice) : -1;
+					if (slot < 0) continue;
+
+					// Offset in range units, components past the maximum distance cannot be inside it
+					int32_t dx = (emitter.position.X.RawValue() - Spatial::listener.X.RawValue()) >> Spatial::range.shift;
+					int32_t dy = (emitter.position.Y.RawValue() - Spatial::listener.Y.RawValue()) >> Spatial::range.shift;
+					int32_t dz = (emitter.position.Z.RawValue() - Spatial::listener.Z.RawValue()) >> Spatial::range.shift;
+					uint8_t volume = 0;
+					uint8_t pan = 0;
+
+					if (dx > -limit && dx < limit && dy > -limit && dy < limit && dz > -limit && dz < limit)
+					{
+						uint32_t distance = (uint32_t)((dx * dx) + (dy * dy) + (dz * dz));
+
+						if (distance < Spatial::range.maxSquared)
+						{
+							uint16_t gain = Spatial::range.gain[(distance * Spatial::range.scale) >> 20];
+							volume = (uint8_t)(((emitter.volume * gain) + 128) >> 8);
+						}
+
+						if (volume != 0)
+						{
+							int32_t side = ((dx * Spatial::right[0]) + (dy * Spatial::right[1]) + (dz * Spatial::right[2])) >> 16;
+							uint32_t share = distance != 0 ? ((uint32_t)(side * side) * PAN_STEPS) / distance : 0;
+							uint8_t level = panLevels.level[share < PAN_STEPS ? share : PAN_STEPS];
+							pan = level != 0 ? (uint8_t)((side < 0 ? PCM::PAN_LEFT : PCM::PAN_RIGHT) | level) : 0;
+						}
+					}
+
+					if (voices[slot].volume != volume || voices[slot].pan != pan)
+					{
+						voices[slot].volume = volume;
+						voices[slot].pan = pan;
+						QueueCommand(slot, COMMAND_VOLUME | COMMAND_PAN, volume, pan);
+						changed++;
+					}
+				}
+
+				return changed;
+			}
+		};
+
+		/** @brief Sound RAM allocator queries and defragmentation
+		 *
+		 * Samples, streaming rings and ADX buffers get their sound RAM from the free gaps between blocks already in use,
+		 * so Pcm::Free() can return any single sample without touching the rest.
+		 */
+		struct SoundRam
+		{
+			/** @brief Get total size of sound RAM available to samples
+			 * @return Size in bytes
+			 */
+			static int32_t GetSize()
+			{
+				return BankManifest::MAX_SOUND_RAM;
+			}
+
+			/** @brief Get number of bytes in use
+			 * @return Size in bytes
+			 */
+			static int32_t GetUsedSpace()
+			{
+				int32_t used = 0;
+
+				for (int16_t block = 0; block < soundRamBlockCount; block++)
+				{
+					used += soundRamBlocks[block].size;
+				}
+
+				return used;
+			}
+
+			/** @brief Get number of free bytes, possibly split over several gaps
+			 * @return Size in bytes
+			 */
+			static int32_t GetFreeSpace()
+			{
+				return SoundRam::GetSize() - SoundRam::GetUsedSpace();
+			}
+
+			/** @brief Get size of the largest free gap, which is the largest sample that can be loaded right now
+			 * @return Size in bytes
+			 */
+			static int32_t GetLargestFreeBlock()
+			{
+				uint32_t largest = 0;
+				uint32_t gapStart = SCSP_WORK_START;
+
+				for (int16_t block = 0; block <= soundRamBlockCount; block++)
+				{
+					uint32_t gapEnd = block < soundRamBlockCount ? soundRamBlocks[block].address : SCSP_WORK_END;
+					largest = (gapEnd - gapStart) > largest ? (gapEnd - gapStart) : largest;
+
+					if (block < soundRamBlockCount)
+					{
+						gapStart = soundRamBlocks[block].address + soundRamBlocks[block].size;
+					}
+				}
+
+				return (int32_t)largest;
+			}
+
+			/** @brief Get how much of the free space lies outside of the largest free gap
+			 * @return Fragmentation in percent (0 when all free space is in one piece)
+			 */
+			static int32_t GetFragmentation()
+			{
+				int32_t freeSpace = SoundRam::GetFreeSpace();
+				if (freeSpace <= 0) return 0;
+
+				return 100 - ((SoundRam::GetLargestFreeBlock() * 100) / freeSpace);
+			}
+
+			/** @brief Get number of allocated blocks
+			 * @return Number of blocks
+			 */
+			static int16_t GetBlockCount()
+			{
+				return soundRamBlockCount;
+			}
+
+		private:
+			/** @brief Stop a sample and point it at the new place of its block
+			 * @param sound Control slot of the sample
+			 * @param from Old block address
+			 * @param to New block address
+			 * @note Only queued, the data must not move before WaitForDriver() returns
+			 */
+			static void Relocate(int16_t sound, uint32_t from, uint32_t to)
+			{
+				// Extra instances point at the old data
+				ReleaseInstances(sound);
+				QueueCommand(sound, COMMAND_HALT);
+
+				// ADX samples start inside their block, keep the same offset
+				uint32_t start = to + (GetSampleAddress(sound) - from);
+				ctrlShadow[sound].hiAddrBits = (uint16_t)(start >> 16);
+				ctrlShadow[sound].loAddrBits = (uint16_t)(start & 0xFFFF);
+				MarkDirty(sound);
+				voices[sound].ends = 0;
+			}
+
+		public:
+			/** @brief Move samples down to close the gaps between them
+			 * @note Samples that are moved are stopped. Streaming rings and buffers stay in place, samples are packed around them.
+			 * @return Number of samples moved (-1 while Loader has work queued)
+			 */
+			static int16_t Compact()
+			{
+				if (!Loader::IsIdle()) return -1;
+
+				int16_t moved = 0;
+				uint32_t target = SCSP_WORK_START;
+
+				// Samples that move are stopped and pointed at their new place first
+				for (int16_t block = 0; block < soundRamBlockCount; block++)
+				{
+					const SoundRamBlock& current = soundRamBlocks[block];
+
+					if (!current.locked && current.sound >= 0 && current.address > target)
+					{
+						// Samples sharing the block move with it
+						SoundRam::Relocate(current.sound, current.address, target);
+
+						for (int16_t sharer = FindBlockSharer(block); sharer >= 0; sharer = FindBlockSharer(block, sharer + 1))
+						{
+							SoundRam::Relocate(sharer, current.address, target);
+						}
+
+						target += current.size;
+						moved++;
+					}
+					else
+					{
+						target = current.address + current.size;
+					}
+				}
+
+				if (moved == 0) return 0;
+
+				// Driver has to halt them before their data is overwritten
+				WaitForDriver();
+				target = SCSP_WORK_START;
+
+				for (int16_t block = 0; block < soundRamBlockCount; block++)
+				{
+					SoundRamBlock& current = soundRamBlocks[block];
+
+					if (!current.locked && current.sound >= 0 && current.address > target)
+					{
+						// Blocks only move down, so an ascending copy is safe even when source and target overlap
+						StartDma((void*)(current.address + SNDRAM), (void*)(target + SNDRAM), current.size);
+						slDMAWait();
+
+						current.address = target;
+					}
+
+					target = current.address + current.size;
+				}
+
+				return moved;
+			}
+		};
+
+		/** @brief Non-blocking loading of sounds
+		 *
+		 * Requests are queued by Pcm::LoadSoundAsync(), Pcm::LoadPcmAsync() and Pcm::LoadAdxAsync() and processed in order.
+		 * Each call to Update() moves at most a given number of bytes through CD reads, decompression and sound RAM uploads,
+		 * so the main loop keeps its frame rate while sounds load. Compressed entries are decoded straight to sound RAM
+		 * through the shared LZSS window, so loading does not allocate from the heap.
+		 *
+		 * @note Sound RAM is taken when a request starts loading, control slots once its data is in sound RAM. Blocking sound file
+		 * loads share the table of contents and LZSS window, so they finish queued requests first.
+		 * The file being loaded takes one of the SRL_MAX_CD_BACKGROUND_JOBS GFS handles (see MAX_OPEN_FILES).
+		 */
+		struct Loader
+		{
+			/** @brief Maximum number of queued requests
+			 */
+			static constexpr auto MAX_REQUESTS = 8;
+
+			/** @brief Default number of bytes processed per Update() call
+			 */
+			static constexpr auto DEFAULT_BUDGET = 8 * 1024;
+
+		private:
+			friend struct Pcm;
+
+			/** @brief Kind of asset requested
+			 */
+			enum class RequestType : uint8_t
+			{
+				Sound,
+				Pcm,
+				Adx
+			};
+
+			/** @brief Stage of the request being processed
+			 */
+			enum class Step : uint8_t
+			{
+				Open,
+				Header,
+				Toc,
+				Payload
+			};
+
+			/** @brief Queued load request
+			 */
+			struct Request
+			{
+				LoadStatus status;
+				RequestType type;
+				BitDepth bitDepth;
+				const char* fileName;
+				int16_t* sounds;
+				const BankManifest* manifest;
+				int32_t maxSamples;
+				int32_t sampleRate;
+				int32_t result;
+				int32_t bytesDone;
+				int32_t bytesTotal;
+				uint32_t sequence;
+				uint32_t queuedFrame;
+			};
+
+			static inline Request requests[MAX_REQUESTS] = {};
+			static inline SectorReader reader;
+			static inline int16_t active = -1;
+			static inline uint32_t sequence = 0;
+
+			static inline Step step = Step::Open;
+			static inline SndHeader fileHeader;
+			static inline SndEntry entry;
+			static inline PcmHeader pcmHeader;
+			static inline AdxHeader adx;
+			static inline uint8_t fileVersion = 0;
+			static inline int32_t entriesTotal = 0;
+			static inline int32_t tocIndex = 0;
+			static inline int32_t loaded = 0;
+			static inline int32_t gathered = 0;
+			static inline int32_t payloadSize = 0;
+			static inline int32_t payloadEnd = 0;
+			static inline uint32_t destination = 0;
+			static inline uint32_t address = 0;
+			static inline bool decoding = false;
+			static inline LoadProfile profile;
+
+			/** @brief Add request to the queue
+			 * @param type Kind of asset
+			 * @param fileName File name (must stay valid until the request is done)
+			 * @return Request handle (< 0 if queue is full)
+			 */
+			static int16_t Enqueue(RequestType type, const char* fileName)
+			{
+				for (int16_t id = 0; id < MAX_REQUESTS; id++)
+				{
+					if (Loader::requests[id].status == LoadStatus::Free)
+					{
+						Loader::requests[id] = Request{};
+						Loader::requests[id].status = LoadStatus::Pending;
+						Loader::requests[id].type = type;
+						Loader::requests[id].fileName = fileName;
+						Loader::requests[id].sequence = Loader::sequence++;
+						Loader::requests[id].queuedFrame = frameCounter;
+						return id;
+					}
+				}
+
+				return -1;
+			}
+
+			/** @brief Finish active request
+			 * @param status Final status
+			 * @param result Result of the request
+			 */
+			static void Finish(LoadStatus status, int32_t result)
+			{
+				Request& request = Loader::requests[Loader::active];
+				request.status = status;
+				request.result = result;
+				request.bytesDone = request.bytesTotal;
+				Loader::profile.result = result;
+				Loader::profile.frames = frameCounter - request.queuedFrame;
+
+				if (Loader::decoding)
+				{
+					lzssStream.Finish();
+					Loader::decoding = false;
+				}
+
+				if (Loader::fileVersion == SND_VERSION)
+				{
+					// Entries that were not reached give their reserved sound RAM back
+					ReleaseSoundToc(Loader::entriesTotal);
+				}
+
+				Loader::reader.Close();
+
+				if (Loader::address != 0)
+				{
+					// Sample never got all of its data, so it was not registered
+					ReleaseSoundRam(Loader::address);
+					Loader::address = 0;
+				}
+
+				Loader::active = -1;
+			}
+
+			/** @brief Copy data from the file as it arrives
+			 * @param target Where to copy data to
+			 * @param size Number of bytes to copy
+			 * @param toSoundRam Copy by DMA to sound RAM
+			 * @param budget Remaining bytes allowed this update
+			 * @return true when all data (or the rest of the file) was copied
+			 */
+			static bool Gather(uint8_t* target, int32_t size, bool toSoundRam, int32_t& budget)
+			{
+				while (Loader::gathered < size && budget > 0)
+				{
+					int32_t available = Loader::reader.Poll(false);
+
+					if (available <= 0)
+					{
+						return Loader::reader.Tell() >= Loader::reader.Size();
+					}
+
+					int32_t left = size - Loader::gathered;
+					available = available > left ? left : available;
+					available = available > budget ? budget : available;
+
+					if (toSoundRam)
+					{
+						// Runs while the next sector is fetched
+						Loader::reader.Upload(target + Loader::gathered, available);
+					}
+					else
+					{
+						const uint8_t* source = Loader::reader.Data();
+
+						for (int32_t i = 0; i < available; i++)
+						{
+							target[Loader::gathered + i] = source[i];
+						}
+					}
+
+					Loader::reader.Skip(available);
+					Loader::gathered += available;
+					budget -= available;
+				}
+
+				return Loader::gathered >= size;
+			}
+
+			/** @brief Move to next entry of a sound file, or finish
+			 * @param request Active request
+			 */
+			static void NextEntry(Request& request)
+			{
+				Loader::loaded++;
+				Loader::gathered = 0;
+
+				if (Loader::loaded >= request.maxSamples ||
+					(Loader::fileVersion == SND_VERSION ? Loader::loaded >= Loader::entriesTotal : Loader::reader.Tell() >= Loader::reader.Size()))
+				{
+					Loader::Finish(LoadStatus::Ready, Loader::loaded - 1);
+					return;
+				}
+
+				Loader::step = Step::Header;
+			}
+
+			/** @brief Open file of the active request
+			 * @param request Active request
+			 */
+			static void Open(Request& request)
+			{
+				Loader::profile = LoadProfile{};
+				Loader::profile.fileName = request.fileName;
+				Loader::reader.SetProfile(&Loader::profile);
+
+				if (!Loader::reader.Open(request.fileName))
+				{
+					Loader::Finish(LoadStatus::Failed, request.type == RequestType::Sound ? -1 : (request.type == RequestType::Pcm ? -4 : -5));
+					return;
+				}
+
+				request.bytesTotal = Loader::reader.Size();
+				Loader::fileVersion = 0;
+				Loader::loaded = 0;
+				Loader::gathered = 0;
+				Loader::step = Step::Header;
+
+				if (request.type == RequestType::Pcm)
+				{
+					if (GetFreeSlots() <= 0) return Loader::Finish(LoadStatus::Failed, -2);
+
+					int32_t fileSize = Loader::reader.Size();
+
+					if ((fileSize > (128 * 1024) && request.bitDepth == BitDepth::PCM16) ||
+						(fileSize > (64 * 1024) && request.bitDepth == BitDepth::PCM8))
+					{
+						return Loader::Finish(LoadStatus::Failed, -3);
+					}
+
+					fileSize += ((uint32_t)fileSize & 1) ? 1 : 0;
+					fileSize += ((uint32_t)fileSize & 3) ? 2 : 0;
+
+					uint32_t address = AllocateSoundRam(fileSize);
+					if (address == 0) return Loader::Finish(LoadStatus::Failed, -1);
+
+					Loader::address = address;
+					Loader::destination = address + SNDRAM;
+					Loader::payloadSize = fileSize;
+					Loader::step = Step::Payload;
+				}
+				else if (request.type == RequestType::Adx)
+				{
+					if (GetFreeSlots() <= 0) return Loader::Finish(LoadStatus::Failed, -2);
+				}
+			}
+
+			/** @brief Parse header of the active request
+			 * @param request Active request
+			 * @param budget Remaining bytes allowed this update
+			 * @return false while waiting for CD
+			 */
+			static bool Header(Request& request, int32_t& budget)
+			{
+				if (request.type == RequestType::Adx)
+				{
+					if (!Loader::Gather((uint8_t*)&Loader::adx, sizeof(AdxHeader), false, budget)) return false;
+
+					if (Loader::gathered < (int32_t)sizeof(AdxHeader) || !IsValidAdxHeader(ToHostOrder(Loader::adx)))
+					{
+						Loader::Finish(LoadStatus::Failed, -4);
+						return true;
+					}
+
+					Loader::payloadSize = (Loader::adx.sampleCount / 32) * 18;
+					Loader::payloadSize += ((uint32_t)Loader::payloadSize & 1) ? 1 : 0;
+					Loader::payloadSize += ((uint32_t)Loader::payloadSize & 3) ? 2 : 0;
+
+					uint32_t address = AllocateSoundRam(Loader::payloadSize);
+
+					if (address == 0)
+					{
+						Loader::Finish(LoadStatus::Failed, -1);
+						return true;
+					}
+
+					Loader::address = address;
+					Loader::destination = address + SNDRAM;
+				}
+				else if (Loader::fileVersion == 0)
+				{
+					// Find out which version of sound file this is
+					if (!Loader::Gather((uint8_t*)&Loader::fileHeader, sizeof(SndHeader), false, budget)) return false;
+
+					Loader::gathered = 0;
+					ToHostOrder(Loader::fileHeader);
+
+					if (Loader::fileHeader.magic != SND_MAGIC && request.manifest != nullptr)
+					{
+						// Manifests are only generated for version 2 files
+						Loader::Finish(LoadStatus::Failed, -4);
+						return true;
+					}
+
+					if (Loader::fileHeader.magic != SND_MAGIC)
+					{
+						// Version 1 file starts with the first entry header
+						Loader::fileVersion = 1;
+						Loader::reader.Seek(0);
+						return true;
+					}
+
+					if (Loader::fileHeader.version != SND_VERSION || Loader::fileHeader.entrySize < SND_ENTRY_MIN_SIZE ||
+						sizeof(SndHeader) + ((int32_t)Loader::fileHeader.entryCount * Loader::fileHeader.entrySize) > (uint32_t)Loader::reader.Size() ||
+						(request.manifest != nullptr &&
+						(Loader::fileHeader.entryCount != request.manifest->count || Loader::fileHeader.soundRamSize != request.manifest->soundRamSize)))
+					{
+						Loader::Finish(LoadStatus::Failed, -4);
+						return true;
+					}
+
+					Loader::fileVersion = SND_VERSION;
+					Loader::entriesTotal = Loader::fileHeader.entryCount < request.maxSamples ? Loader::fileHeader.entryCount : request.maxSamples;
+					Loader::entriesTotal = Loader::entriesTotal < PCM::CTRL_MAX ? Loader::entriesTotal : PCM::CTRL_MAX;
+					Loader::tocIndex = 0;
+					Loader::reader.Seek(sizeof(SndHeader));
+					Loader::step = Step::Toc;
+					return true;
+				}
+				else if (Loader::fileVersion == SND_VERSION)
+				{
+					Loader::entry = soundToc[Loader::loaded];
+					if (!soundTocShared[Loader::loaded]) Loader::reader.Seek(Loader::entry.offset);
+					return Loader::BeginEntry(request);
+				}
+				else
+				{
+					if (!Loader::Gather((uint8_t*)&Loader::pcmHeader, sizeof(PcmHeader), false, budget)) return false;
+
+					if (Loader::gathered < (int32_t)sizeof(PcmHeader))
+					{
+						// Ran out of file before all requested entries were found
+						Loader::Finish(LoadStatus::Ready, Loader::loaded - 1);
+						return true;
+					}
+
+					ToHostOrder(Loader::pcmHeader);
+					Loader::entry = SndEntry{};
+					Loader::entry.compressedSize = Loader::pcmHeader.compressedSize;
+					Loader::entry.originalSize = Loader::pcmHeader.originalSize;
+					Loader::entry.sampleRate = Loader::pcmHeader.sampleRate;
+					Loader::entry.bitDepth = (uint8_t)Loader::pcmHeader.bitDepth;
+
+					if (!IsValidSndEntry(Loader::entry, Loader::reader.Tell(), Loader::reader.Size()))
+					{
+						Loader::Finish(LoadStatus::Failed, -4);
+						return true;
+					}
+
+					return Loader::BeginEntry(request);
+				}
+
+				Loader::gathered = 0;
+				Loader::step = Step::Payload;
+				return true;
+			}
+
+			/** @brief Take sound RAM for the current entry of a sound file, shared entries take their control slot here
+			 * @param request Active request
+			 * @return Always true
+			 */
+			static bool BeginEntry(Request& request)
+			{
+				if (GetFreeSlots() <= 0)
+				{
+					Loader::Finish(LoadStatus::Failed, -2);
+					return true;
+				}
+
+				uint32_t address;
+
+				if (Loader::fileVersion == SND_VERSION && soundTocShared[Loader::loaded])
+				{
+					// Data is already in sound RAM, fails if its sample was freed since the table of contents was read
+					const BankManifest::Sample* sample = request.manifest != nullptr ? &request.manifest->samples[Loader::loaded] : nullptr;
+					request.sounds[Loader::loaded] = ShareSoundEntry(Loader::entry, sample);
+
+					if (request.sounds[Loader::loaded] < 0)
+					{
+						Loader::Finish(LoadStatus::Failed, -3);
+						return true;
+					}
+
+					Loader::profile.bytesShared += Loader::entry.originalSize;
+					Loader::NextEntry(request);
+					return true;
+				}
+				else if (Loader::fileVersion == SND_VERSION)
+				{
+					// Reserved when table of contents was read
+					address = soundTocAddress[Loader::loaded];
+					soundTocAddress[Loader::loaded] = 0;
+				}
+				else
+				{
+					address = AllocateSoundRam(Loader::entry.originalSize);
+
+					if (address == 0)
+					{
+						Loader::Finish(LoadStatus::Failed, -3);
+						return true;
+					}
+				}
+
+				Loader::address = address;
+				Loader::destination = address + SNDRAM;
+
+				if (Loader::entry.compressedSize == 0)
+				{
+					Loader::payloadSize = Loader::entry.originalSize;
+				}
+				else
+				{
+					Loader::payloadSize = Loader::entry.compressedSize;
+					Loader::payloadEnd = Loader::reader.Tell() + Loader::entry.compressedSize;
+					Loader::decoding = true;
+					lzssStream.Begin(Loader::destination, Loader::entry.originalSize, &Loader::profile);
+				}
+
+				Loader::gathered = 0;
+				Loader::step = Step::Payload;
+				return true;
+			}
+
+			/** @brief Register the sample once all of its data is in sound RAM, then move on
+			 * @param request Active request
+			 */
+			static void Commit(Request& request)
+			{
+				uint32_t address = Loader::address;
+				int16_t sound = -2;
+				Loader::address = 0;
+
+				// Blocking loads may have taken the last control slot since the request started
+				if (GetFreeSlots() > 0)
+				{
+					if (request.type == RequestType::Pcm)
+					{
+						sound = RegisterPcm(address, Loader::payloadSize, request.bitDepth, request.sampleRate);
+					}
+					else if (request.type == RequestType::Adx)
+					{
+						// Header is not copied, so data starts 16 bytes in
+						sound = RegisterAdx(Loader::adx, address + 16, Loader::adx.sampleCount / 32);
+					}
+					else
+					{
+						sound = RegisterEntry(Loader::entry, address, request.manifest != nullptr ? &request.manifest->samples[Loader::loaded] : nullptr);
+					}
+				}
+
+				if (sound < 0)
+				{
+					ReleaseSoundRam(address);
+					Loader::Finish(LoadStatus::Failed, sound);
+				}
+				else if (request.type == RequestType::Sound)
+				{
+					request.sounds[Loader::loaded] = sound;
+					Loader::NextEntry(request);
+				}
+				else
+				{
+					Loader::Finish(LoadStatus::Ready, sound);
+				}
+			}
+
+			/** @brief Read table of contents of a version 2 sound file
+			 * @param request Active request
+			 * @param budget Remaining bytes allowed this update
+			 * @return false while waiting for CD
+			 */
+			static bool Toc(Request& request, int32_t& budget)
+			{
+				if (Loader::tocIndex < Loader::entriesTotal)
+				{
+					// Entries without loop points are shorter, the fields they lack stay 0
+					int32_t entrySize = Loader::fileHeader.entrySize < sizeof(SndEntry) ? Loader::fileHeader.entrySize : sizeof(SndEntry);
+					if (Loader::gathered == 0) soundToc[Loader::tocIndex] = SndEntry{};
+					if (!Loader::Gather((uint8_t*)&soundToc[Loader::tocIndex], entrySize, false, budget)) return false;
+
+					ToHostOrder(soundToc[Loader::tocIndex]);
+
+					if (!IsValidSndEntry(soundToc[Loader::tocIndex], soundToc[Loader::tocIndex].offset, Loader::reader.Size()) ||
+						(request.manifest != nullptr && !MatchesManifest(soundToc[Loader::tocIndex], request.manifest->samples[Loader::tocIndex])))
+					{
+						Loader::Finish(LoadStatus::Failed, -4);
+						return true;
+					}
+
+					Loader::tocIndex++;
+					Loader::gathered = 0;
+					Loader::reader.Seek(sizeof(SndHeader) + (Loader::tocIndex * Loader::fileHeader.entrySize));
+					return true;
+				}
+
+				// Check budget before sound RAM is touched, entries whose data is already in sound RAM only take a control slot
+				int32_t soundRam = ShareSoundToc(Loader::entriesTotal);
+
+				if (GetFreeSlots() < Loader::entriesTotal)
+				{
+					Loader::Finish(LoadStatus::Failed, -2);
+				}
+				else if (soundRam > SoundRam::GetFreeSpace() || !ReserveSoundToc(Loader::entriesTotal))
+				{
+					Loader::Finish(LoadStatus::Failed, -3);
+				}
+				else
+				{
+					Loader::step = Step::Header;
+				}
+
+				return true;
+			}
+
+			/** @brief Decode compressed entry as its data arrives
+			 * @param request Active request
+			 * @param budget Remaining bytes allowed this update
+			 * @return false while waiting for CD
+			 */
+			static bool Decode(Request& request, int32_t& budget)
+			{
+				while (budget > 0 && !lzssStream.IsComplete())
+				{
+					if (Loader::reader.Tell() >= Loader::payloadEnd)
+					{
+						// Last match can still be copying after all of its input was read
+						lzssStream.Feed(nullptr, 0, budget);
+						break;
+					}
+
+					int32_t available = Loader::reader.Poll(false);
+
+					if (available <= 0)
+					{
+						if (Loader::reader.Tell() < Loader::reader.Size()) return false;
+						break;
+					}
+
+					int32_t left = Loader::payloadEnd - Loader::reader.Tell();
+					available = available > left ? left : available;
+					Loader::reader.Skip(lzssStream.Feed(Loader::reader.Data(), available, budget));
+				}
+
+				if (budget <= 0 && !lzssStream.IsComplete())
+				{
+					// Out of budget, continue next update
+					return true;
+				}
+
+				lzssStream.Finish();
+				Loader::decoding = false;
+				Loader::reader.Seek(Loader::payloadEnd);
+				Loader::Commit(request);
+				return true;
+			}
+
+			/** @brief Process active request
+			 * @param budget Remaining bytes allowed this update
+			 * @return false while waiting for CD
+			 */
+			static bool Advance(int32_t& budget)
+			{
+				Request& request = Loader::requests[Loader::active];
+
+				switch (Loader::step)
+				{
+				case Step::Open:
+					Loader::Open(request);
+					budget -= SECTOR_SIZE;
+					return true;
+
+				case Step::Header:
+					return Loader::Header(request, budget);
+
+				case Step::Toc:
+					return Loader::Toc(request, budget);
+
+				case Step::Payload:
+					if (Loader::decoding)
+					{
+						return Loader::Decode(request, budget);
+					}
+
+					if (!Loader::Gather((uint8_t*)Loader::destination, Loader::payloadSize, true, budget)) return false;
+
+					// Sample must be in sound RAM before it can be played
+					Loader::reader.WaitUpload();
+					Loader::Commit(request);
+					return true;
+				}
+
+				return false;
+			}
+
+		public:
+			/** @brief Process queued requests
+			 * @param budget Maximum number of bytes to read, decompress and upload during this call
+			 */
+			static void Update(int32_t budget = DEFAULT_BUDGET)
+			{
+				while (budget > 0)
+				{
+					if (Loader::active < 0)
+					{
+						// Pick oldest pending request
+						for (int16_t id = 0; id < MAX_REQUESTS; id++)
+						{
+							if (Loader::requests[id].status == LoadStatus::Pending &&
+								(Loader::active < 0 || (int32_t)(Loader::requests[id].sequence - Loader::requests[Loader::active].sequence) < 0))
+							{
+								Loader::active = id;
+							}
+						}
+
+						if (Loader::active < 0) return;
+						Loader::step = Step::Open;
+					}
+
+					TimerStamp start = ReadTimer();
+					bool progressed = Loader::Advance(budget);
+					Loader::profile.totalTicks += TimerElapsed(start);
+
+					if (Loader::active < 0)
+					{
+						// Request finished during this step
+						RecordLoad(Loader::profile);
+					}
+					else
+					{
+						Loader::requests[Loader::active].bytesDone = Loader::reader.Tell();
+					}
+
+					if (!progressed) return;
+				}
+			}
+
+			/** @brief Check whether there is nothing left to load
+			 */
+			static bool IsIdle()
+			{
+				for (const Request& request : Loader::requests)
+				{
+					if (request.status == LoadStatus::Pending) return false;
+				}
+
+				return true;
+			}
+
+			/** @brief Get status of a request
+			 * @param request Request handle
+			 * @return Request status
+			 */
+			static LoadStatus GetStatus(int16_t request)
+			{
+				if (request < 0 || request >= MAX_REQUESTS) return LoadStatus::Failed;
+				return Loader::requests[request].status;
+			}
+
+			/** @brief Get how much of a request was loaded
+			 * @param request Request handle
+			 * @return Progress in percent (0-100)
+			 */
+			static int32_t GetProgress(int16_t request)
+			{
+				if (request < 0 || request >= MAX_REQUESTS) return 0;
+				if (Loader::requests[request].status == LoadStatus::Ready) return 100;
+				if (Loader::requests[request].bytesTotal <= 0) return 0;
+				return (Loader::requests[request].bytesDone * 100) / Loader::requests[request].bytesTotal;
+			}
+
+			/** @brief Get result of a finished request
+			 * @param request Request handle
+			 * @return Same value the blocking load would return (sound identifier, or last sample index for sound files, < 0 on fail)
+			 */
+			static int32_t GetResult(int16_t request)
+			{
+				if (request < 0 || request >= MAX_REQUESTS) return -1;
+				return Loader::requests[request].result;
+			}
+
+			/** @brief Free a finished request handle for reuse
+			 * @param request Request handle
+			 */
+			static void Release(int16_t request)
+			{
+				if (request < 0 || request >= MAX_REQUESTS || Loader::requests[request].status == LoadStatus::Pending) return;
+				Loader::requests[request].status = LoadStatus::Free;
+			}
+		};
+
+		/** @brief Shared handle to a sound bank kept in sound RAM
+		 *
+		 * Handles of the same manifest share one copy of the bank, which is counted by its handles. Loading a bank that
+		 * is already resident costs no CD access. Once the last handle lets go, the bank stays resident until a load runs
+		 * out of sound RAM or control slots, then unused banks are evicted, least recently used first. So a level change
+		 * that releases the old level's handles before loading the new ones only reads the banks that changed.
+		 *
+		 * @note Samples of a bank belong to it, do not remove them with Pcm::Unload() or Pcm::Free(). Do not load banks
+		 * while Loader has work queued.
+		 */
+		class SoundBank
+		{
+		public:
+			/** @brief Maximum number of banks resident at the same time
+			 */
+			static constexpr auto MAX_BANKS = 8;
+
+		private:
+			/** @brief Bank in sound RAM
+			 */
+			struct Resident
+			{
+				/** @brief Manifest the bank was loaded from (nullptr if the entry is free)
+				 */
+				const BankManifest* manifest;
+
+				/** @brief Number of handles holding the bank
+				 */
+				int16_t references;
+
+				/** @brief Use counter value when the bank was last acquired or released
+				 */
+				uint32_t lastUse;
+
+				/** @brief Sample ids, indexed by the bank's Sample enum
+				 */
+				int16_t sounds[BankManifest::MAX_SAMPLES];
+			};
+
+			static inline Resident residents[MAX_BANKS] = {};
+			static inline uint32_t useCounter = 0;
+
+			int16_t resident = -1;
+
+			/** @brief Find resident bank
+			 * @param manifest Manifest of the bank
+			 * @return Index in residents (-1 if the bank is not resident)
+			 */
+			static int16_t Find(const BankManifest& manifest)
+			{
+				for (int16_t index = 0; index < MAX_BANKS; index++)
+				{
+					if (SoundBank::residents[index].manifest == &manifest) return index;
+				}
+
+				return -1;
+			}
+
+			/** @brief Find free entry for a bank
+			 * @return Index in residents (-1 if every entry holds a bank)
+			 */
+			static int16_t FindFree()
+			{
+				for (int16_t index = 0; index < MAX_BANKS; index++)
+				{
+					if (SoundBank::residents[index].manifest == nullptr) return index;
+				}
+
+				return -1;
+			}
+
+			/** @brief Free samples of a resident bank
+			 * @param index Index in residents
+			 */
+			static void Evict(int16_t index)
+			{
+				Resident& bank = SoundBank::residents[index];
+
+				for (int16_t sample = 0; sample < bank.manifest->count; sample++)
+				{
+					Pcm::Free(bank.sounds[sample]);
+				}
+
+				bank.manifest = nullptr;
+			}
+
+			/** @brief Evict unused bank that was used least recently
+			 * @return false if every resident bank is held
+			 */
+			static bool EvictOldest()
+			{
+				int16_t oldest = -1;
+
+				for (int16_t index = 0; index < MAX_BANKS; index++)
+				{
+					const Resident& bank = SoundBank::residents[index];
+
+					if (bank.manifest != nullptr && bank.references == 0 &&
+						(oldest < 0 || bank.lastUse < SoundBank::residents[oldest].lastUse))
+					{
+						oldest = index;
+					}
+				}
+
+				if (oldest < 0) return false;
+
+				SoundBank::Evict(oldest);
+				return true;
+			}
+
+			/** @brief Sound RAM a bank still needs, samples whose data is already loaded are shared
+			 * @param manifest Manifest of the bank
+			 * @return Size in bytes
+			 */
+			static int32_t GetMissingSize(const BankManifest& manifest)
+			{
+				int32_t size = 0;
+
+				for (int16_t sample = 0; sample < manifest.count; sample++)
+				{
+					SndEntry entry{};
+					entry.originalSize = manifest.samples[sample].originalSize;
+					entry.bitDepth = manifest.samples[sample].bitDepth;
+					entry.contentHash = manifest.samples[sample].contentHash;
+
+					if (FindSharedSample(entry) < 0) size += AlignSize(entry.originalSize);
+				}
+
+				return size;
+			}
+
+		public:
+			/** @brief Construct empty handle
+			 */
+			SoundBank() = default;
+
+			/** @brief Construct another handle to the same bank
+			 * @param other Handle to share
+			 */
+			SoundBank(const SoundBank& other) : resident(other.resident)
+			{
+				if (this->resident >= 0) SoundBank::residents[this->resident].references++;
+			}
+
+			/** @brief Share bank of another handle, letting go of the current one
+			 * @param other Handle to share
+			 */
+			SoundBank& operator=(const SoundBank& other)
+			{
+				if (this != &other && this->resident != other.resident)
+				{
+					this->Release();
+					this->resident = other.resident;
+					if (this->resident >= 0) SoundBank::residents[this->resident].references++;
+				}
+
+				return *this;
+			}
+
+			/** @brief Let go of the bank, it stays resident until its space is needed
+			 */
+			~SoundBank()
+			{
+				this->Release();
+			}
+
+			/** @brief Take hold of a bank, loading it only if it is not resident
+			 * @param manifest Manifest from the bank's generated header (must stay valid while the bank is resident)
+			 * @return Number of samples in the bank (-1 file not found, -2 out of control slots, -3 out of sound RAM, -4 file does not match the manifest, -5 out of bank entries)
+			 */
+			int32_t Load(const BankManifest& manifest)
+			{
+				int16_t index = SoundBank::Find(manifest);
+
+				if (index >= 0)
+				{
+					if (index != this->resident)
+					{
+						this->Release();
+						this->resident = index;
+						SoundBank::residents[index].references++;
+					}
+
+					SoundBank::residents[index].lastUse = ++SoundBank::useCounter;
+					return manifest.count;
+				}
+
+				this->Release();
+
+				// Make room for the bank before asking for it, unused banks go first
+				while (GetFreeSlots() < manifest.count || SoundRam::GetFreeSpace() < SoundBank::GetMissingSize(manifest))
+				{
+					if (!SoundBank::EvictOldest()) break;
+				}
+
+				index = SoundBank::FindFree();
+
+				while (index < 0 && SoundBank::EvictOldest())
+				{
+					index = SoundBank::FindFree();
+				}
+
+				if (index < 0) return -5;
+
+				Resident& bank = SoundBank::residents[index];
+				int32_t result = Pcm::LoadBank(manifest, bank.sounds);
+
+				// Free space can still be split into gaps too small for the samples
+				while ((result == -2 || result == -3) && SoundBank::EvictOldest())
+				{
+					result = Pcm::LoadBank(manifest, bank.sounds);
+				}
+
+				if (result == -3 && SoundRam::Compact() > 0)
+				{
+					result = Pcm::LoadBank(manifest, bank.sounds);
+				}
+
+				if (result < 0) return result;
+
+				bank.manifest = &manifest;
+				bank.references = 1;
+				bank.lastUse = ++SoundBank::useCounter;
+				this->resident = index;
+				return result;
+			}
+
+			/** @brief Let go of the bank, it stays resident until its space is needed
+			 */
+			void Release()
+			{
+				if (this->resident < 0) return;
+
+				Resident& bank = SoundBank::residents[this->resident];
+				bank.references--;
+				bank.lastUse = ++SoundBank::useCounter;
+				this->resident = -1;
+			}
+
+			/** @brief Check whether handle holds a bank
+			 */
+			bool IsLoaded() const
+			{
+				return this->resident >= 0;
+			}
+
+			/** @brief Get sample id
+			 * @param sample Index from the bank's Sample enum
+			 * @return Sample id for Pcm::Play() (-1 if no bank is held or the index is out of range)
+			 */
+			int16_t operator[](int16_t sample) const
+			{
+				if (this->resident < 0) return -1;
+
+				const Resident& bank = SoundBank::residents[this->resident];
+				return sample >= 0 && sample < bank.manifest->count ? bank.sounds[sample] : -1;
+			}
+
+			/** @brief Get number of samples in the bank (0 if no bank is held)
+			 */
+			int16_t GetCount() const
+			{
+				return this->resident >= 0 ? SoundBank::residents[this->resident].manifest->count : 0;
+			}
+
+			/** @brief Get manifest of the held bank (nullptr if no bank is held)
+			 */
+			const BankManifest* GetManifest() const
+			{
+				return this->resident >= 0 ? SoundBank::residents[this->resident].manifest : nullptr;
+			}
+
+			/** @brief Check whether a bank is in sound RAM, held or not
+			 * @param manifest Manifest of the bank
+			 */
+			static bool IsResident(const BankManifest& manifest)
+			{
+				return SoundBank::Find(manifest) >= 0;
+			}
+
+			/** @brief Get number of handles holding a bank
+			 * @param manifest Manifest of the bank
+			 * @return Number of handles (-1 if the bank is not resident)
+			 */
+			static int16_t GetReferences(const BankManifest& manifest)
+			{
+				int16_t index = SoundBank::Find(manifest);
+				return index >= 0 ? SoundBank::residents[index].references : -1;
+			}
+
+			/** @brief Evict every bank no handle holds, ie before loading something that is not a bank
+			 * @return Number of banks evicted
+			 */
+			static int16_t EvictUnused()
+			{
+				int16_t evicted = 0;
+
+				while (SoundBank::EvictOldest())
+				{
+					evicted++;
+				}
+
+				return evicted;
+			}
+		};
+
+		/** @brief CD Streamed playback of sound effects & music
+		 *
+		 * Raw PCM is read from CD into a ring of PCM::NUM_BUF segments in sound RAM, while the driver plays
+		 * the ring as a forward loop. The vblank hook follows the play position the SCSP reports, and UpdateAll()
+		 * refills the segments it left from the main loop, so sound RAM use is fixed by the sample rate and does
+		 * not depend on the length of the track.
+		 *
+		 * @note The stream keeps its file open, it takes one of the SRL_MAX_CD_BACKGROUND_JOBS GFS handles (see MAX_OPEN_FILES).
+		 */
+		struct PcmStream
+		{
+			/** @brief Maximum number of streams serviced at the same time
+			 */
+			static constexpr auto MAX_STREAMS = 2;
+
+		private:
+			/** @brief Streams currently serviced by UpdateAll() and the vblank hook
+			 */
+			static inline PcmStream* activeStreams[MAX_STREAMS] = {};
+
+			/** @brief Largest ring in samples, playSize of the control slot is 16 bits wide
+			 */
+			static constexpr int32_t MAX_RING_SAMPLES = 0xFFFF;
+
+			GfsHandle handle = nullptr;
+			int16_t sound = -1;
+			BitDepth bitDepth = BitDepth::PCM8;
+			int16_t bytesPerBlank = 0;
+			int32_t segmentSize = 0;
+			int32_t transferSectors = 0;
+			int32_t firstSector = 0;
+			int32_t fileSectors = 0;
+			int32_t lastSectorBytes = 0;
+			int32_t fileSector = 0;
+			int32_t loopSector = 0;
+			int32_t fillSectors = 0;
+			int32_t readSectors = 0;
+			int32_t prefillSector = 0;
+			int32_t endSegments = 0;
+			uint8_t volume = 7;
+			bool reading = false;
+			bool looping = false;
+			bool endOfData = false;
+
+			/** @brief Segments completed since the ring was prefilled, written by UpdateAll() only
+			 */
+			volatile int32_t filledSegments = 0;
+
+			/** @brief Segments the driver left since the ring was prefilled, written by the vblank hook only
+			 */
+			volatile int32_t playedSegments = 0;
+
+			/** @brief Segment the driver plays, as last read from the SCSP
+			 */
+			volatile int32_t playSegment = 0;
+
+			/** @brief Bytes played of playSegment, as last read from the SCSP
+			 */
+			volatile int32_t consumedBytes = 0;
+
+			volatile int32_t underruns = 0;
+			volatile bool playing = false;
+			volatile bool restartPending = false;
+
+			/** @brief Get sound RAM address of the ring
+			 */
+			uint32_t RingAddress() const
+			{
+				return ((uint32_t)ctrlShadow[this->sound].hiAddrBits << 16) | ctrlShadow[this->sound].loAddrBits;
+			}
+
+			/** @brief Zero part of the ring
+			 * @param offset Offset in the ring (4 byte aligned)
+			 * @param size Number of bytes to clear
+			 */
+			void ClearRing(int32_t offset, int32_t size)
+			{
+				for (int32_t i = offset & ~3; i < offset + size; i += 4)
+				{
+					*(uint32_t*)(this->RingAddress() + SNDRAM + i) = 0x00000000;
+				}
+			}
+
+			/** @brief Get segment the next read goes to
+			 */
+			int32_t FillSegment() const
+			{
+				return this->filledSegments % PCM::NUM_BUF;
+			}
+
+			/** @brief Mark current fill segment as done and move to the next one
+			 */
+			void CompleteSegment()
+			{
+				this->fillSectors = 0;
+				this->filledSegments = this->filledSegments + 1;
+			}
+
+			/** @brief Issue the next CD read into the ring, or fill the segment with silence once the file is exhausted
+			 * @param blocking Wait for the read to finish
+			 */
+			void IssueRead(bool blocking)
+			{
+				int32_t sectorsLeft = this->fileSectors - this->fileSector;
+
+				if (sectorsLeft <= 0 || this->endOfData)
+				{
+					if (this->looping && !this->endOfData)
+					{
+						this->fileSector = this->loopSector;
+						GFS_Seek(this->handle, this->firstSector + this->fileSector, GFS_SEEK_SET);
+						sectorsLeft = this->fileSectors - this->fileSector;
+					}
+					else
+					{
+						// Nothing more to read, the ring plays silence until the stream is stopped
+						this->ClearRing(
+							(this->FillSegment() * this->segmentSize) + (this->fillSectors * SECTOR_SIZE),
+							(this->transferSectors - this->fillSectors) * SECTOR_SIZE);
+						this->endSegments = this->endOfData ? this->endSegments : this->filledSegments + 1;
+						this->endOfData = true;
+						this->CompleteSegment();
+						return;
+					}
+				}
+
+				this->readSectors = this->transferSectors - this->fillSectors;
+				this->readSectors = this->readSectors > sectorsLeft ? sectorsLeft : this->readSectors;
+
+				void* destination = (void*)(this->RingAddress() + SNDRAM + (this->FillSegment() * this->segmentSize) + (this->fillSectors * SECTOR_SIZE));
+
+				if (blocking)
+				{
+					GFS_Fread(this->handle, this->readSectors, destination, this->readSectors * SECTOR_SIZE);
+					this->FinishRead();
+				}
+				else
+				{
+					GFS_NwFread(this->handle, this->readSectors, destination, this->readSectors * SECTOR_SIZE);
+					this->reading = true;
+				}
+			}
+
+			/** @brief Account for completed read
+			 */
+			void FinishRead()
+			{
+				this->reading = false;
+				this->fileSector += this->readSectors;
+				this->fillSectors += this->readSectors;
+
+				if (this->fileSector >= this->fileSectors && this->lastSectorBytes != SECTOR_SIZE)
+				{
+					// Last sector of the file is not full, silence the garbage behind the data
+					this->ClearRing(
+						(this->FillSegment() * this->segmentSize) + (this->fillSectors * SECTOR_SIZE) - (SECTOR_SIZE - this->lastSectorBytes),
+						SECTOR_SIZE - this->lastSectorBytes);
+				}
+
+				if (this->fillSectors >= this->transferSectors)
+				{
+					this->CompleteSegment();
+				}
+			}
+
+			/** @brief Fill every free segment of the ring before playback starts
+			 */
+			void Prefill()
+			{
+				this->prefillSector = this->fileSector;
+				this->fillSectors = 0;
+				this->filledSegments = 0;
+				this->playedSegments = 0;
+				this->playSegment = 0;
+				this->consumedBytes = 0;
+				this->endOfData = false;
+
+				while (this->filledSegments < PCM::NUM_BUF)
+				{
+					this->IssueRead(true);
+				}
+			}
+
+			/** @brief Start pending playback and follow the play position
+			 * @note Called from the vblank hook, it only reads the SCSP and updates counters, all GFS calls are in Update()
+			 */
+			void Track()
+			{
+				if (this->restartPending)
+				{
+					// Driver starts the ring from its first segment
+					this->restartPending = false;
+					this->playing = true;
+					this->playedSegments = this->playedSegments + ((PCM::NUM_BUF - (this->playedSegments % PCM::NUM_BUF)) % PCM::NUM_BUF);
+					this->playSegment = 0;
+					this->consumedBytes = 0;
+					ctrlShadow[this->sound].volume = this->volume;
+					ctrlShadow[this->sound].sh2Permit = 1;
+					MarkDirty(this->sound);
+					return;
+				}
+
+				if (!this->playing) return;
+
+				int16_t position = MonitorSlot(this->sound);
+				if (position < 0) return;
+
+				// Start of the 4096 sample unit, so a segment counts as left only once the driver is surely past it
+				int32_t playedBytes = position * MONITOR_SAMPLES * (this->bitDepth == BitDepth::PCM16 ? 2 : 1);
+				int32_t segment = playedBytes / this->segmentSize;
+				segment = segment < PCM::NUM_BUF ? segment : PCM::NUM_BUF - 1;
+				this->consumedBytes = playedBytes - (segment * this->segmentSize);
+
+				if (segment != this->playSegment)
+				{
+					// Driver only moves forward through the ring
+					this->playedSegments = this->playedSegments + (((segment - this->playSegment) + PCM::NUM_BUF) % PCM::NUM_BUF);
+					this->playSegment = segment;
+
+					if (this->filledSegments - this->playedSegments <= 0)
+					{
+						// Segment the driver entered was not refilled in time
+						this->underruns = this->underruns + 1;
+					}
+				}
+			}
+
+			/** @brief Keep the ring filled and stop once the driver left the last segment of a file that does not loop
+			 */
+			void Update()
+			{
+				if (this->playing && this->endOfData && this->playedSegments >= this->endSegments)
+				{
+					this->Stop();
+					return;
+				}
+
+				if (this->reading)
+				{
+					GFS_NwExecOne(this->handle);
+
+					if (GFS_NwIsComplete(this->handle))
+					{
+						this->FinishRead();
+					}
+				}
+
+				if (!this->reading && this->filledSegments < this->playedSegments)
+				{
+					// Restart moved the driver past the segments still to be filled, their data is skipped
+					this->fillSectors = 0;
+					this->filledSegments = this->playedSegments;
+				}
+
+				if (!this->reading && this->filledSegments - this->playedSegments < PCM::NUM_BUF)
+				{
+					this->IssueRead(false);
+				}
+			}
+
+			/** @brief Follow play position of all active streams
+			 * @note Called from the vblank hook
+			 */
+			static void TrackAll()
+			{
+				for (PcmStream* stream : PcmStream::activeStreams)
+				{
+					if (stream != nullptr)
+					{
+						stream->Track();
+					}
+				}
+			}
+
+			friend class Sound;
+
+		public:
+			/** @brief Refill all active streams, call once per frame from the main loop
+			 * @note GFS is not reentrant, so CD reads of streams are only made here, never from the vblank hook
+			 */
+			static void UpdateAll()
+			{
+				for (PcmStream* stream : PcmStream::activeStreams)
+				{
+					if (stream != nullptr)
+					{
+						stream->Update();
+					}
+				}
+			}
+
+			/** @brief Calculate ring segment sizes for the stream
+			 * @param bitrate Sample rate of the stream
+			 * @param bit_depth Bit depth of the stream
+			 */
+			void Init(int32_t bitrate, BitDepth bit_depth)
+			{
+				this->bitDepth = bit_depth;
+				this->bytesPerBlank = Sound::CalculateBytesPerBlank(bitrate, bit_depth == BitDepth::PCM8, PCM::SYS_REGION);
+				int32_t bytesPerSample = bit_depth == BitDepth::PCM16 ? 2 : 1;
+
+				// "bytesPerBlank" being the bytes per blank of the music track, rounded up to whole sectors so each refill is a single CD read
+				int32_t bufferSizeBytes = this->bytesPerBlank * Sound::PCM::BUFFERED_BLANKS;
+				this->transferSectors = ((bufferSizeBytes / Sound::PCM::NUM_BUF) + SECTOR_SIZE - 1) / SECTOR_SIZE;
+
+				// playSize is 16 bits wide and the play position only has 16 MONITOR_SAMPLES units, so at high rates
+				// the ring holds fewer than BUFFERED_BLANKS frames rather than wrap either of them
+				int32_t maximumSectors = ((MAX_RING_SAMPLES * bytesPerSample) / PCM::NUM_BUF) / SECTOR_SIZE;
+				this->transferSectors = this->transferSectors < maximumSectors ? this->transferSectors : maximumSectors;
+				this->segmentSize = this->transferSectors * SECTOR_SIZE;
+
+				// Play position is only known to MONITOR_SAMPLES, a shorter segment would be refilled while it still plays
+				int32_t minimumSize = MONITOR_SAMPLES * bytesPerSample;
+
+				if (this->segmentSize < minimumSize)
+				{
+					this->transferSectors = (minimumSize + SECTOR_SIZE - 1) / SECTOR_SIZE;
+					this->segmentSize = this->transferSectors * SECTOR_SIZE;
+				}
+			}
+
+			/** @brief Open raw PCM file for streaming and fill the ring
+			 * @param fileName File name (entry of the open sound archive or file on CD)
+			 * @param bitDepth Bit depth of the stream
+			 * @param sampleRate Sample rate of the stream
+			 * @return Sound identifier of the ring (< 0 on fail)
+			 */
+			int16_t Open(const char* fileName, const BitDepth bitDepth, const int32_t sampleRate = 15360)
+			{
+				if (this->handle != nullptr) return -1;
+				if (GetFreeSlots() <= 0) return -2;
+
+				int32_t slot = 0;
+				while (slot < MAX_STREAMS && PcmStream::activeStreams[slot] != nullptr) slot++;
+				if (slot >= MAX_STREAMS) return -2;
+
+				this->Init(sampleRate, bitDepth);
+
+				int32_t lastSize;
+				this->handle = OpenCdFile(fileName, this->firstSector, this->fileSectors, lastSize);
+				if (this->handle == nullptr) return -4;
+
+				// Ring is refilled in place, so it is locked against SoundRam::Compact()
+				uint32_t address = AllocateSoundRam(this->segmentSize * PCM::NUM_BUF, true);
+
+				if (address == 0)
+				{
+					GFS_Close(this->handle);
+					this->handle = nullptr;
+					return -1;
+				}
+
+				this->lastSectorBytes = lastSize;
+				this->fileSector = 0;
+				this->loopSector = 0;
+				this->underruns = 0;
+				this->reading = false;
+				this->playing = false;
+				this->restartPending = false;
+
+				this->sound = RegisterPcm(address, this->segmentSize * PCM::NUM_BUF, bitDepth, sampleRate);
+				voices[this->sound].maxInstances = 1;
+				voices[this->sound].mode = PlayMode::ForwardLoop;
+				ctrlShadow[this->sound].loopType = PlayMode::ForwardLoop;
+				MarkDirty(this->sound);
+
+				this->Prefill();
+
+				PcmStream::activeStreams[slot] = this;
+				return this->sound;
+			}
+
+			/** @brief Stop playback, close the file and free the ring
+			 */
+			void Close()
+			{
+				if (this->handle == nullptr) return;
+
+				for (PcmStream*& stream : PcmStream::activeStreams)
+				{
+					if (stream == this) stream = nullptr;
+				}
+
+				this->Stop();
+
+				if (this->reading)
+				{
+					GFS_NwStop(this->handle);
+					this->reading = false;
+				}
+
+				GFS_Close(this->handle);
+				this->handle = nullptr;
+
+				ReleaseSound(this->sound);
+				this->sound = -1;
+			}
+
+			/** @brief Start playback
+			 * @param volume Starting volume (0-7)
+			 */
+			void Play(uint8_t volume = 7)
+			{
+				if (this->handle == nullptr) return;
+				this->volume = volume;
+				this->restartPending = true;
+			}
+
+			/** @brief Stop playback, ring is kept so playback can resume from the same data
+			 */
+			void Stop()
+			{
+				if (this->sound < 0) return;
+				this->restartPending = false;
+				this->playing = false;
+				QueueCommand(this->sound, COMMAND_HALT);
+			}
+
+			/** @brief Move playback to another position in the file
+			 * @param byteOffset Offset from start of the file (rounded down to a whole sector)
+			 */
+			void Seek(int32_t byteOffset)
+			{
+				if (this->handle == nullptr) return;
+
+				bool wasPlaying = this->playing || this->restartPending;
+				this->Stop();
+
+				if (this->reading)
+				{
+					GFS_NwStop(this->handle);
+					this->reading = false;
+				}
+
+				this->fileSector = byteOffset / SECTOR_SIZE;
+				this->fileSector = this->fileSector >= this->fileSectors ? this->fileSectors - 1 : this->fileSector;
+				GFS_Seek(this->handle, this->firstSector + this->fileSector, GFS_SEEK_SET);
+				this->Prefill();
+
+				this->restartPending = wasPlaying;
+			}
+
+			/** @brief Set whether stream starts over when it reaches end of the file
+			 * @param loop Enable looping
+			 * @param loopOffset Offset in bytes where playback continues (rounded down to a whole sector)
+			 */
+			void Loop(bool loop, int32_t loopOffset = 0)
+			{
+				this->looping = loop;
+				this->loopSector = loopOffset / SECTOR_SIZE;
+
+				if (loop && this->endOfData && this->handle != nullptr)
+				{
+					if (!this->IsPlaying())
+					{
+						// Whole file fit into the ring, prefill again so it loops instead of ending in silence
+						this->Seek(this->prefillSector * SECTOR_SIZE);
+					}
+					else
+					{
+						this->endOfData = false;
+					}
+				}
+			}
+
+			/** @brief Set stream volume
+			 * @param volume New volume (0-7)
+			 * @param pan Stereo pan to set (right being 0, left being 16)
+			 */
+			void SetVolume(const uint8_t volume, const uint8_t pan = 7)
+			{
+				this->volume = volume;
+				Pcm::SetVolume(this->sound, volume, pan);
+			}
+
+			/** @brief Check whether stream is playing
+			 */
+			bool IsPlaying() const
+			{
+				return this->playing || this->restartPending;
+			}
+
+			/** @brief Number of times playback reached a segment that was not refilled in time
+			 */
+			int32_t GetUnderruns() const
+			{
+				return this->underruns;
+			}
+
+			/** @brief Sound RAM taken by the ring in bytes
+			 */
+			int32_t GetBufferSize() const
+			{
+				return this->segmentSize * PCM::NUM_BUF;
+			}
+
+			/** @brief How much of the ring holds data that was not played yet
+			 * @return Fill level in percent
+			 */
+			int32_t GetFillLevel() const
+			{
+				if (this->handle == nullptr) return 0;
+
+				int32_t buffered = ((this->filledSegments - this->playedSegments) * this->segmentSize) - this->consumedBytes;
+				buffered = buffered < 0 ? 0 : buffered;
+				return (buffered * 100) / (this->segmentSize * PCM::NUM_BUF);
+			}
+
+			/** @brief Get stream serviced by UpdateAll()
+			 * @param index Stream index (0 to MAX_STREAMS - 1)
+			 * @return Stream (nullptr if there is none at the index)
+			 */
+			static const PcmStream* GetActive(int32_t index)
+			{
+				return index >= 0 && index < MAX_STREAMS ? PcmStream::activeStreams[index] : nullptr;
+			}
+		};
+
+		/** @brief CD Streamed playback of ADX music
+		 *
+		 * Only a double buffer of whole ADX blocks is kept in sound RAM. The driver raises adxBufferPass[n] once it has
+		 * played through half n of the buffer, Update() then refills that half from CD from the main loop and clears the flag.
+		 * When the header carries loop info, the stream continues from the loop start without a gap.
+		 *
+		 * @note The driver supports a single ADX stream. The stream keeps its file open while it is loaded, it takes one
+		 * of the SRL_MAX_CD_BACKGROUND_JOBS GFS handles (see MAX_OPEN_FILES).
+		 */
+		struct AdxStream
+		{
+		private:
+			static constexpr auto BLOCK_SIZE = 18;
+			static constexpr auto BLOCK_SAMPLES = 32;
+
+			static inline SectorReader reader;
+			static inline int16_t sound = -1;
+			static inline int32_t halfSize = 0;
+			static inline int32_t dataStart = 0;
+			static inline int32_t loopStart = 0;
+			static inline int32_t loopEnd = 0;
+			static inline volatile int32_t fillHalf = -1;
+			static inline int32_t fillOffset = 0;
+			static inline volatile int32_t underruns = 0;
+			static inline uint8_t volume = 7;
+			static inline bool looping = false;
+			static inline bool primed = false;
+			static inline volatile bool playing = false;
+			static inline bool endOfData = false;
+			static inline volatile bool underrunCounted = false;
+
+			/** @brief Sound RAM address of the buffer
+			 */
+			static uint32_t BufferAddress()
+			{
+				return ((uint32_t)ctrlShadow[AdxStream::sound].hiAddrBits << 16) | ctrlShadow[AdxStream::sound].loAddrBits;
+			}
+
+			/** @brief Copy stream data into the half being refilled
+			 * @param blocking Wait for CD
+			 * @return true when the half is full
+			 */
+			static bool Fill(bool blocking)
+			{
+				uint32_t destination = AdxStream::BufferAddress() + SNDRAM + (AdxStream::fillHalf * AdxStream::halfSize);
+
+				while (AdxStream::fillOffset < AdxStream::halfSize)
+				{
+					if (AdxStream::reader.Tell() >= AdxStream::loopEnd)
+					{
+						if (AdxStream::looping)
+						{
+							// Feed loop start right behind loop end, driver has to decode the looped part once more
+							AdxStream::reader.Seek(AdxStream::loopStart);
+							m68kCommands.adxStreamLength = m68kCommands.adxStreamLength + ((AdxStream::loopEnd - AdxStream::loopStart) / BLOCK_SIZE);
+							continue;
+						}
+
+						// Zeroed blocks decode to silence
+						for (int32_t i = AdxStream::fillOffset; i < AdxStream::halfSize; i++)
+						{
+							*(uint8_t*)(destination + i) = 0;
+						}
+
+						AdxStream::fillOffset = AdxStream::halfSize;
+						AdxStream::endOfData = true;
+						break;
+					}
+
+					int32_t available = AdxStream::reader.Poll(blocking);
+					if (available <= 0) return false;
+
+					int32_t left = AdxStream::halfSize - AdxStream::fillOffset;
+					available = available > left ? left : available;
+					left = AdxStream::loopEnd - AdxStream::reader.Tell();
+					available = available > left ? left : available;
+
+					StartDma(AdxStream::reader.Data(), (void*)(destination + AdxStream::fillOffset), available);
+					slDMAWait();
+
+					AdxStream::reader.Skip(available);
+					AdxStream::fillOffset += available;
+				}
+
+				return true;
+			}
+
+			/** @brief Fill whole buffer from the start of the stream
+			 */
+			static void Prime()
+			{
+				AdxStream::reader.Seek(AdxStream::dataStart);
+				AdxStream::endOfData = false;
+				m68kCommands.adxStreamLength = (AdxStream::loopEnd - AdxStream::dataStart) / BLOCK_SIZE;
+
+				for (int32_t half = 0; half < PCM::NUM_BUF; half++)
+				{
+					AdxStream::fillHalf = half;
+					AdxStream::fillOffset = 0;
+					AdxStream::Fill(true);
+					m68kCommands.adxBufferPass[half] = 0;
+					systemShadow.adxBufferPass[half] = 0;
+				}
+
+				AdxStream::fillHalf = -1;
+				AdxStream::primed = true;
+			}
+
+			/** @brief Fade playing stream, or change it right away without a length or a free envelope
+			 * @param volume Volume at the end (0-7)
+			 * @param frames Length in frames
+			 * @param stop Whether to stop the stream at the end
+			 * @return false if the stream is not playing, or the change had to be applied right away although a length was given
+			 */
+			static bool Fade(uint8_t volume, uint16_t frames, bool stop)
+			{
+				if (AdxStream::sound < 0 || !AdxStream::playing) return false;
+				if (frames > 0 && StartEnvelope(AdxStream::sound, ENVELOPE_ADX, voices[AdxStream::sound].volume, volume, frames, stop)) return true;
+
+				CancelEnvelope(AdxStream::sound, ENVELOPE_ADX);
+
+				if (stop)
+				{
+					AdxStream::Stop();
+				}
+				else
+				{
+					AdxStream::volume = volume;
+					voices[AdxStream::sound].volume = volume;
+					QueueCommand(AdxStream::sound, COMMAND_VOLUME, volume);
+				}
+
+				return frames == 0;
+			}
+
+			/** @brief Latch halves released by the driver and count underruns
+			 * @note Called from the vblank hook, it only reads driver flags, the CD reads are made by Update()
+			 */
+			static void Track()
+			{
+				if (!AdxStream::playing) return;
+
+				systemShadow.adxBufferPass[0] = m68kCommands.adxBufferPass[0];
+				systemShadow.adxBufferPass[1] = m68kCommands.adxBufferPass[1];
+
+				int32_t half = AdxStream::fillHalf;
+
+				if (half >= 0 && !AdxStream::underrunCounted && systemShadow.adxBufferPass[half ^ 1] != 0)
+				{
+					// Driver already wants the other half while this one is still loading
+					AdxStream::underruns = AdxStream::underruns + 1;
+					AdxStream::underrunCounted = true;
+				}
+			}
+
+			friend class Sound;
+
+		public:
+			/** @brief Refill halves released by the driver, call once per frame from the main loop
+			 * @note GFS is not reentrant, so the stream is only read from CD here, never from the vblank hook
+			 */
+			static void Update()
+			{
+				if (!AdxStream::playing) return;
+
+				if (AdxStream::fillHalf < 0)
+				{
+					for (int32_t half = 0; half < PCM::NUM_BUF; half++)
+					{
+						if (systemShadow.adxBufferPass[half] != 0)
+						{
+							if (AdxStream::endOfData)
+							{
+								// Driver is past the last data we gave it
+								AdxStream::playing = false;
+								AdxStream::primed = false;
+								return;
+							}
+
+							AdxStream::fillOffset = 0;
+							AdxStream::underrunCounted = false;
+							AdxStream::fillHalf = half;
+							break;
+						}
+					}
+
+					if (AdxStream::fillHalf < 0) return;
+				}
+
+				if (AdxStream::Fill(false))
+				{
+					m68kCommands.adxBufferPass[AdxStream::fillHalf] = 0;
+					systemShadow.adxBufferPass[AdxStream::fillHalf] = 0;
+					AdxStream::fillHalf = -1;
+				}
+			}
+
+			/** @brief Open ADX file for streaming and fill the buffer
+			 * @param fileName File name
+			 * @param loop Continue from the header loop start (or the start of the data) when the end is reached
+			 * @return Sound identifier of the stream (< 0 on fail)
+			 */
+			static int16_t Open(const char* fileName, bool loop = true)
+			{
+				if (AdxStream::sound >= 0) AdxStream::Close();
+				if (GetFreeSlots() <= 0) return -2;
+				if (!AdxStream::reader.Open(fileName)) return -5;
+
+				AdxHeader header{};
+				AdxRange range{};
+
+				if (!ReadAdxHeader(AdxStream::reader, header, range))
+				{
+					AdxStream::reader.Close();
+					return -4;
+				}
+
+				AdxStream::dataStart = range.dataStart;
+				AdxStream::loopStart = range.loopStart;
+				AdxStream::loopEnd = range.loopEnd;
+
+				// Each half holds PCM::BUFFERED_BLANKS / PCM::NUM_BUF frames worth of whole blocks
+				int32_t samplesPerBlank = CalculateBytesPerBlank((int32_t)header.sampleRate, true, PCM::SYS_REGION);
+				int32_t blocksPerHalf = ((samplesPerBlank * (PCM::BUFFERED_BLANKS / PCM::NUM_BUF)) + BLOCK_SAMPLES - 1) / BLOCK_SAMPLES;
+				AdxStream::halfSize = blocksPerHalf * BLOCK_SIZE;
+
+				int32_t bufferSize = AdxStream::halfSize * PCM::NUM_BUF;
+				bufferSize += ((uint32_t)bufferSize & 3) ? 2 : 0;
+
+				// Buffer is refilled in place, so it is locked against SoundRam::Compact()
+				uint32_t address = AllocateSoundRam(bufferSize, true);
+
+				if (address == 0)
+				{
+					AdxStream::reader.Close();
+					return -1;
+				}
+
+				AdxStream::sound = RegisterAdx(header, address, blocksPerHalf * PCM::NUM_BUF);
+
+				if (AdxStream::sound < 0)
+				{
+					ReleaseSoundRam(address);
+					AdxStream::reader.Close();
+					return AdxStream::sound;
+				}
+
+				ctrlShadow[AdxStream::sound].loopType = ADX::STREAM;
+				MarkDirty(AdxStream::sound);
+
+				AdxStream::looping = loop;
+				AdxStream::playing = false;
+				AdxStream::underruns = 0;
+				AdxStream::Prime();
+				return AdxStream::sound;
+			}
+
+			/** @brief Stop playback, close the file and free the buffer
+			 */
+			static void Close()
+			{
+				if (AdxStream::sound < 0) return;
+
+				AdxStream::Stop();
+				AdxStream::reader.Close();
+				ReleaseSound(AdxStream::sound);
+				AdxStream::sound = -1;
+			}
+
+			/** @brief Start playback from the beginning of the stream
+			 * @param volume Starting volume (0-7)
+			 */
+			static void Play(uint8_t volume = 7)
+			{
+				if (AdxStream::sound < 0) return;
+				if (!AdxStream::primed) AdxStream::Prime();
+
+				AdxStream::volume = volume;
+				AdxStream::playing = true;
+				AdxStream::primed = false;
+				voices[AdxStream::sound].volume = volume;
+				QueueCommand(AdxStream::sound, COMMAND_VOLUME | COMMAND_START, volume);
+			}
+
+			/** @brief Start playback from the beginning of the stream, silent at first and fading in
+			 * @param frames Length of the fade in frames
+			 * @param volume Volume at the end of the fade (0-7)
+			 */
+			static void FadeIn(const uint16_t frames, const uint8_t volume = 7)
+			{
+				AdxStream::Play(frames > 0 ? 0 : volume);
+				if (frames > 0) AdxStream::Fade(volume, frames, false);
+			}
+
+			/** @brief Change stream volume gradually, one step per vblank
+			 * @param volume Volume at the end (0-7)
+			 * @param frames Length of the fade in frames (0 changes the volume right away)
+			 * @return false if the stream is not playing, or no envelope was free and the volume was set right away
+			 */
+			static bool FadeTo(const uint8_t volume, const uint16_t frames)
+			{
+				return AdxStream::Fade(volume, frames, false);
+			}
+
+			/** @brief Fade stream out and stop it
+			 * @param frames Length of the fade in frames (0 stops right away)
+			 * @return false if the stream is not playing, or no envelope was free and the stream was stopped right away
+			 */
+			static bool FadeOut(const uint16_t frames)
+			{
+				return AdxStream::Fade(0, frames, true);
+			}
+
+			/** @brief Stop stream after a number of frames
+			 * @param frames Frames to keep playing (0 stops right away)
+			 * @return false if the stream is not playing, or no envelope was free and the stream was stopped right away
+			 */
+			static bool StopAfter(const uint16_t frames)
+			{
+				if (AdxStream::sound < 0) return false;
+				return AdxStream::Fade(voices[AdxStream::sound].volume, frames, true);
+			}
+
+			/** @brief Stop playback
+			 */
+			static void Stop()
+			{
+				if (AdxStream::sound < 0) return;
+				CancelEnvelope(AdxStream::sound, ENVELOPE_ADX);
+				AdxStream::playing = false;
+				AdxStream::fillHalf = -1;
+				QueueCommand(AdxStream::sound, COMMAND_HALT);
+			}
+
+			/** @brief Set stream volume
+			 * @param volume New volume (0-7)
+			 * @param pan Stereo pan to set (right being 0, left being 16)
+			 */
+			static void SetVolume(const uint8_t volume, const uint8_t pan = 7)
+			{
+				AdxStream::volume = volume;
+				if (AdxStream::sound >= 0) CancelEnvelope(AdxStream::sound, ENVELOPE_ADX);
+				Pcm::SetVolume(AdxStream::sound, volume, pan);
+			}
+
+			/** @brief Check whether stream is playing
+			 */
+			static bool IsPlaying()
+			{
+				return AdxStream::playing;
+			}
+
+			/** @brief Number of times the driver released a half while the previous one was still loading
+			 */
+			static int32_t GetUnderruns()
+			{
+				return AdxStream::underruns;
+			}
+
+			/** @brief Sound RAM taken by the buffer in bytes
+			 */
+			static int32_t GetBufferSize()
+			{
+				return AdxStream::halfSize * PCM::NUM_BUF;
+			}
+
+			/** @brief How much of the buffer holds data the driver did not release yet
+			 * @return Fill level in percent
+			 */
+			static int32_t GetFillLevel()
+			{
+				if (AdxStream::sound < 0 || AdxStream::halfSize <= 0) return 0;
+
+				int32_t buffered = 0;
+
+				for (int32_t half = 0; half < PCM::NUM_BUF; half++)
+				{
+					if (half == AdxStream::fillHalf)
+					{
+						buffered += AdxStream::fillOffset;
+					}
+					else if (systemShadow.adxBufferPass[half] == 0)
+					{
+						buffered += AdxStream::halfSize;
+					}
+				}
+
+				return (buffered * 100) / (AdxStream::halfSize * PCM::NUM_BUF);
+			}
+		};
+
+		/** @brief CD Streamed playback of ADX music decoded by the slave SH-2
+		 *
+		 * ADX blocks are read from CD on the master, decoded into 16 bit PCM by the slave SH-2 and sent into a ring in
+		 * sound RAM by DMA, which the driver plays as a plain forward loop. This takes the 68K decoder out of the path,
+		 * so several streams can play at once, at any sample rate the SCSP takes. Each UpdateAll() hands one job to the slave,
+		 * holding a chunk of CHUNK_BLOCKS blocks for every stream with room in its ring, and the next call collects it.
+		 * The vblank hook only follows the play position the SCSP reports.
+		 *
+		 * @note Needs the slave SH-2 free for slSlaveFunc(). Every stream keeps its file open, it takes one of the
+		 * SRL_MAX_CD_BACKGROUND_JOBS GFS handles (see MAX_OPEN_FILES).
+		 */
+		struct SlaveAdxStream
+		{
+			/** @brief Maximum number of streams serviced at the same time
+			 */
+			static constexpr auto MAX_STREAMS = 4;
+
+			/** @brief ADX blocks decoded per stream and job (32 samples each)
+			 */
+			static constexpr auto CHUNK_BLOCKS = 32;
+
+			/** @brief Number of chunks in the ring of each stream
+			 */
+			static constexpr auto RING_CHUNKS = 16;
+
+			/** @brief Decode speed of the master and the slave SH-2, see RunBenchmark()
+			 */
+			struct Benchmark
+			{
+				/** @brief Blocks decoded by each CPU
+				 */
+				int32_t blocks;
+
+				/** @brief Timer ticks the master took
+				 */
+				uint32_t masterTicks;
+
+				/** @brief Timer ticks from handing the first job to the slave until the last one was done
+				 */
+				uint32_t slaveTicks;
+
+				/** @brief Samples per second the master decodes with nothing else to do
+				 */
+				int32_t masterRate;
+
+				/** @brief Samples per second the slave decodes with nothing else to do
+				 */
+				int32_t slaveRate;
+
+				/** @brief Highest sample rate of the single stream the 68K driver decodes
+				 */
+				int32_t driverRate;
+			};
+
+		private:
+			static constexpr auto BLOCK_SIZE = 18;
+			static constexpr auto BLOCK_SAMPLES = 32;
+			static constexpr auto CHUNK_INPUT = CHUNK_BLOCKS * BLOCK_SIZE;
+			static constexpr auto CHUNK_SAMPLES = CHUNK_BLOCKS * BLOCK_SAMPLES;
+			static constexpr auto CHUNK_BYTES = CHUNK_SAMPLES * 2;
+			static constexpr auto RING_SIZE = CHUNK_BYTES * RING_CHUNKS;
+
+			/** @brief Prediction state of a stream, carried from one chunk to the next
+			 */
+			struct Decoder
+			{
+				int16_t coefficient1;
+				int16_t coefficient2;
+				int32_t history1;
+				int32_t history2;
+			};
+
+			/** @brief Chunk the slave decodes
+			 */
+			struct Task
+			{
+				const uint8_t* input;
+				int32_t blocks;
+				Decoder* decoder;
+				int16_t* output;
+			};
+
+			/** @brief Work handed to the slave, it sets done once every task is decoded
+			 */
+			struct Job
+			{
+				Task tasks[MAX_STREAMS];
+				int32_t count;
+				volatile bool done;
+			};
+
+			/** @brief Streams currently serviced by UpdateAll() and the vblank hook
+			 */
+			static inline SlaveAdxStream* activeStreams[MAX_STREAMS] = {};
+
+			/** @brief Streams owning the tasks of the job in flight
+			 */
+			static inline SlaveAdxStream* jobStreams[MAX_STREAMS] = {};
+
+			/** @brief Decoded chunk of each stream, sent on to sound RAM once the job is done
+			 */
+			alignas(4) static inline int16_t decoded[MAX_STREAMS][CHUNK_SAMPLES];
+
+			static inline Job job = {};
+			static inline bool jobPending = false;
+			static inline bool benchmarking = false;
+			static inline int32_t lateFrames = 0;
+
+			SectorReader reader;
+			AdxRange range = {};
+			Decoder decoder = {};
+			int16_t sound = -1;
+			int16_t index = -1;
+			int32_t writeChunk = 0;
+			int32_t inputBytes = 0;
+			uint8_t volume = 7;
+			bool looping = false;
+			bool inputEnd = false;
+			bool endOfData = false;
+			bool decoding = false;
+			bool primed = false;
+			alignas(4) uint8_t input[CHUNK_INPUT];
+
+			/** @brief Bytes sent into the ring since it was primed, written by UpdateAll() only (wraps, compare differences)
+			 */
+			volatile uint32_t writtenBytes = 0;
+
+			/** @brief Bytes the driver played since it was started, written by the vblank hook only (wraps, compare differences)
+			 */
+			volatile uint32_t playedBytes = 0;
+
+			/** @brief Frame playback was started in, the SCSP reports the new position from two frames on
+			 */
+			volatile uint32_t startFrame = 0;
+
+			/** @brief Value of writtenBytes behind the last decoded chunk
+			 */
+			uint32_t endBytes = 0;
+
+			volatile int32_t underruns = 0;
+			volatile bool playing = false;
+
+			/** @brief Calculate prediction coefficients of ADX
+			 * @param sampleRate Sample rate
+			 * @param cutoff High pass cutoff frequency from the header
+			 * @return Decoder with the coefficients set and empty history
+			 * @note Same values the encoder uses, adxCoeficientTable holds them for the fixed rates of the driver.
+			 * Fixed point with 28 fraction bits, as the SH-2 has no FPU.
+			 */
+			static constexpr Decoder CalculateCoefficients(int32_t sampleRate, int32_t cutoff)
+			{
+				constexpr int64_t one = (int64_t)1 << 28;
+				constexpr int64_t twoPi = 1686629713;
+				constexpr int64_t sqrt2 = 379625062;
+
+				cutoff = cutoff > (sampleRate >> 1) ? (sampleRate >> 1) : cutoff;
+				int64_t x = (twoPi * cutoff) / sampleRate;
+
+				// cos(x) from its Taylor series, x is at most pi
+				int64_t cosine = one;
+				int64_t term = one;
+
+				for (int64_t k = 1; k <= 7; k++)
+				{
+					term = -((((term * x) >> 28) * x) >> 28) / ((2 * k - 1) * (2 * k));
+					cosine += term;
+				}
+
+				// c = (a - sqrt((a + b) * (a - b))) / b
+				int64_t a = sqrt2 - cosine;
+				int64_t b = sqrt2 - one;
+				int64_t product = ((a + b) * (a - b)) >> 28;
+				int64_t root = (int64_t)CalculateSqrt((uint32_t)product) << 14;
+				root = root > 0 ? (root + ((product << 28) / root)) >> 1 : 0;
+				int64_t c = ((a - root) << 28) / b;
+
+				// coefficient1 = floor(c * 8192), coefficient2 = floor(-c * c * 4096)
+				return Decoder{
+					(int16_t)(c >> 15),
+					(int16_t)-(((c * c) + ((int64_t)1 << 44) - 1) >> 44),
+					0,
+					0 };
+			}
+
+			/** @brief Decode ADX blocks into 16 bit PCM
+			 * @param input First block
+			 * @param blocks Number of blocks
+			 * @param output Decoded samples (blocks * 32 of them)
+			 * @param state Prediction state, updated for the next call
+			 */
+			static void DecodeBlocks(const uint8_t* input, int32_t blocks, int16_t* output, Decoder& state)
+			{
+				int32_t coefficient1 = state.coefficient1;
+				int32_t coefficient2 = state.coefficient2;
+				int32_t history1 = state.history1;
+				int32_t history2 = state.history2;
+
+				for (int32_t block = 0; block < blocks; block++)
+				{
+					int32_t scale = (input[0] << 8) | input[1];
+
+					for (int32_t i = 2; i < BLOCK_SIZE; i++)
+					{
+						// High nibble is the earlier sample, both are signed
+						int32_t nibbles[2] = { (int8_t)input[i] >> 4, (int8_t)(input[i] << 4) >> 4 };
+
+						for (int32_t nibble : nibbles)
+						{
+							int32_t sample = (nibble * scale) + (((coefficient1 * history1) + (coefficient2 * history2)) >> 12);
+							sample = sample > 32767 ? 32767 : (sample < -32768 ? -32768 : sample);
+							history2 = history1;
+							history1 = sample;
+							*output++ = (int16_t)sample;
+						}
+					}
+
+					input += BLOCK_SIZE;
+				}
+
+				state.history1 = history1;
+				state.history2 = history2;
+			}
+
+			/** @brief Decode every task of a job, runs on the slave SH-2
+			 * @param data Job
+			 * @note The slave cache may hold stale lines of data the master wrote, so everything is read through the
+			 * cache-through alias. Writes go through to work RAM on their own.
+			 */
+			static void DecodeJob(void* data)
+			{
+				Job* work = (Job*)data;
+				const Job* source = CacheThrough(work);
+
+				for (int32_t task = 0; task < source->count; task++)
+				{
+					Task current = source->tasks[task];
+					Decoder state = *CacheThrough(current.decoder);
+
+					SlaveAdxStream::DecodeBlocks(CacheThrough(current.input), current.blocks, current.output, state);
+					*current.decoder = state;
+
+					// Rest of the chunk behind the last block is silence
+					for (int32_t i = current.blocks * BLOCK_SAMPLES; i < CHUNK_SAMPLES; i++)
+					{
+						current.output[i] = 0;
+					}
+				}
+
+				work->done = true;
+			}
+
+			/** @brief Check whether the slave finished the job in flight
+			 */
+			static bool IsJobDone()
+			{
+				return CacheThrough(&SlaveAdxStream::job)->done;
+			}
+
+			/** @brief Sound RAM address of the ring
+			 */
+			uint32_t RingAddress() const
+			{
+				return ((uint32_t)ctrlShadow[this->sound].hiAddrBits << 16) | ctrlShadow[this->sound].loAddrBits;
+			}
+
+			/** @brief Copy stream data into the input buffer until it holds a whole chunk
+			 * @param blocking Wait for CD
+			 */
+			void Gather(bool blocking)
+			{
+				while (this->inputBytes < CHUNK_INPUT && !this->inputEnd)
+				{
+					if (this->reader.Tell() >= this->range.loopEnd)
+					{
+						if (this->looping)
+						{
+							// History carries on over the loop, same as the encoder saw it
+							this->reader.Seek(this->range.loopStart);
+							continue;
+						}
+
+						this->inputEnd = true;
+						break;
+					}
+
+					int32_t available = this->reader.Poll(blocking);
+					if (available <= 0) return;
+
+					int32_t left = CHUNK_INPUT - this->inputBytes;
+					available = available > left ? left : available;
+					left = this->range.loopEnd - this->reader.Tell();
+					available = available > left ? left : available;
+
+					const uint8_t* data = this->reader.Data();
+
+					for (int32_t i = 0; i < available; i++)
+					{
+						this->input[this->inputBytes + i] = data[i];
+					}
+
+					this->reader.Skip(available);
+					this->inputBytes += available;
+				}
+			}
+
+			/** @brief Check whether the next chunk can be decoded
+			 */
+			bool IsReady() const
+			{
+				return !this->decoding && !this->endOfData && (this->inputBytes >= CHUNK_INPUT || this->inputEnd) &&
+					this->GetBufferedBytes() + CHUNK_BYTES <= RING_SIZE;
+			}
+
+			/** @brief Bytes in the ring the driver did not play yet
+			 * @note Played position is a lower bound, so this never counts a chunk still playing as free
+			 */
+			int32_t GetBufferedBytes() const
+			{
+				int32_t buffered = (int32_t)(this->writtenBytes - this->playedBytes);
+				return buffered < 0 ? 0 : buffered;
+			}
+
+			/** @brief Describe the next chunk for the decoder
+			 */
+			Task MakeTask()
+			{
+				return Task{ this->input, this->inputBytes / BLOCK_SIZE, &this->decoder, SlaveAdxStream::decoded[this->index] };
+			}
+
+			/** @brief Send decoded chunk into the ring
+			 */
+			void Deliver()
+			{
+				StartDma(SlaveAdxStream::decoded[this->index], (void*)(this->RingAddress() + SNDRAM + (this->writeChunk * CHUNK_BYTES)), CHUNK_BYTES);
+				slDMAWait();
+
+				this->writeChunk = (this->writeChunk + 1) % RING_CHUNKS;
+				this->writtenBytes = this->writtenBytes + CHUNK_BYTES;
+				this->endBytes = this->writtenBytes;
+				this->endOfData = this->inputEnd;
+				this->inputBytes = 0;
+				this->decoding = false;
+			}
+
+			/** @brief Wait for the slave to finish a chunk of this stream, it is dropped
+			 */
+			void DropChunk()
+			{
+				if (!this->decoding) return;
+				while (!SlaveAdxStream::IsJobDone()) {}
+				this->decoding = false;
+
+				for (SlaveAdxStream*& stream : SlaveAdxStream::jobStreams)
+				{
+					if (stream == this) stream = nullptr;
+				}
+			}
+
+			/** @brief Fill the whole ring from the start of the stream, decoding on the master
+			 */
+			void Prime()
+			{
+				this->DropChunk();
+				this->reader.Seek(this->range.dataStart);
+				this->decoder.history1 = 0;
+				this->decoder.history2 = 0;
+				this->writeChunk = 0;
+				this->writtenBytes = 0;
+				this->playedBytes = 0;
+				this->inputBytes = 0;
+				this->inputEnd = false;
+				this->endOfData = false;
+
+				while (!this->endOfData && (int32_t)this->writtenBytes < RING_SIZE)
+				{
+					this->Gather(true);
+
+					Task task = this->MakeTask();
+					SlaveAdxStream::DecodeBlocks(task.input, task.blocks, task.output, this->decoder);
+
+					for (int32_t i = task.blocks * BLOCK_SAMPLES; i < CHUNK_SAMPLES; i++)
+					{
+						task.output[i] = 0;
+					}
+
+					this->Deliver();
+				}
+
+				this->primed = true;
+			}
+
+			/** @brief Follow the play position the SCSP reports
+			 * @note Called from the vblank hook, it only reads the SCSP and updates counters, all GFS calls are in Update()
+			 */
+			void Track()
+			{
+				if (!this->playing || frameCounter - this->startFrame < 2) return;
+
+				int16_t position = MonitorSlot(this->sound);
+				if (position < 0) return;
+
+				// Start of the 4096 sample unit, driver only moves forward through the ring
+				int32_t ringOffset = position * MONITOR_SAMPLES * 2;
+				int32_t advance = ((ringOffset - (int32_t)(this->playedBytes % RING_SIZE)) + RING_SIZE) % RING_SIZE;
+				this->playedBytes = this->playedBytes + advance;
+
+				if (advance > 0 && (int32_t)(this->writtenBytes - this->playedBytes) < 0 && !this->endOfData)
+				{
+					// Driver went past the last chunk decoded in time
+					this->underruns = this->underruns + 1;
+				}
+			}
+
+			/** @brief Stop once the driver played all data, and keep the input buffer filled
+			 */
+			void Update()
+			{
+				if (!this->playing) return;
+
+				if (this->endOfData)
+				{
+					if ((int32_t)(this->playedBytes - this->endBytes) >= 0)
+					{
+						this->Stop();
+						return;
+					}
+
+					// Silence behind the end, the driver would play old chunks until it is stopped
+					while (this->GetBufferedBytes() + CHUNK_BYTES <= RING_SIZE)
+					{
+						for (int32_t i = 0; i < CHUNK_BYTES; i += 4)
+						{
+							*(uint32_t*)(this->RingAddress() + SNDRAM + (this->writeChunk * CHUNK_BYTES) + i) = 0x00000000;
+						}
+
+						this->writeChunk = (this->writeChunk + 1) % RING_CHUNKS;
+						this->writtenBytes = this->writtenBytes + CHUNK_BYTES;
+					}
+
+					return;
+				}
+
+				int32_t ahead = (int32_t)(this->writtenBytes - this->playedBytes);
+
+				if (ahead < 0 && !this->decoding)
+				{
+					// Skip the chunks the driver already went past, next one goes right behind the play position
+					uint32_t played = this->playedBytes;
+					uint32_t chunks = (played + CHUNK_BYTES - 1) / CHUNK_BYTES;
+					this->writeChunk = (int32_t)(chunks % RING_CHUNKS);
+					this->writtenBytes = chunks * CHUNK_BYTES;
+				}
+
+				if (!this->decoding)
+				{
+					this->Gather(false);
+				}
+			}
+
+			/** @brief Follow play position of all active streams
+			 * @note Called from the vblank hook
+			 */
+			static void TrackAll()
+			{
+				for (SlaveAdxStream* stream : SlaveAdxStream::activeStreams)
+				{
+					if (stream != nullptr)
+					{
+						stream->Track();
+					}
+				}
+			}
+
+			friend class Sound;
+			friend struct HostAccess;
+
+		public:
+			/** @brief Collect decoded chunks, refill input buffers and hand the next job to the slave, call once per frame
+			 * from the main loop
+			 * @note GFS is not reentrant, so the streams are only read from CD here, never from the vblank hook
+			 */
+			static void UpdateAll()
+			{
+				if (SlaveAdxStream::jobPending)
+				{
+					if (!SlaveAdxStream::IsJobDone())
+					{
+						SlaveAdxStream::lateFrames++;
+					}
+					else
+					{
+						for (int32_t task = 0; task < SlaveAdxStream::job.count; task++)
+						{
+							SlaveAdxStream* stream = SlaveAdxStream::jobStreams[task];
+							if (stream != nullptr && stream->decoding) stream->Deliver();
+						}
+
+						SlaveAdxStream::jobPending = false;
+					}
+				}
+
+				for (SlaveAdxStream* stream : SlaveAdxStream::activeStreams)
+				{
+					if (stream != nullptr)
+					{
+						stream->Update();
+					}
+				}
+
+				if (SlaveAdxStream::jobPending || SlaveAdxStream::benchmarking) return;
+
+				int32_t count = 0;
+
+				for (SlaveAdxStream* stream : SlaveAdxStream::activeStreams)
+				{
+					if (stream != nullptr && stream->playing && stream->IsReady())
+					{
+						SlaveAdxStream::job.tasks[count] = stream->MakeTask();
+						SlaveAdxStream::jobStreams[count++] = stream;
+						stream->decoding = true;
+					}
+				}
+
+				if (count == 0) return;
+
+				SlaveAdxStream::job.count = count;
+				SlaveAdxStream::job.done = false;
+				SlaveAdxStream::jobPending = true;
+				slSlaveFunc(SlaveAdxStream::DecodeJob, (void*)&SlaveAdxStream::job);
+			}
+
+			/** @brief Open ADX file for streaming and fill the ring
+			 * @param fileName File name
+			 * @param loop Continue from the header loop start (or the start of the data) when the end is reached
+			 * @return Sound identifier of the ring (< 0 on fail)
+			 */
+			int16_t Open(const char* fileName, bool loop = true)
+			{
+				static_assert(CalculateCoefficients(7680, 500).coefficient1 == ADX::COEF_768_1 && CalculateCoefficients(7680, 500).coefficient2 == ADX::COEF_768_2);
+				static_assert(CalculateCoefficients(23040, 500).coefficient1 == ADX::COEF_2304_1 && CalculateCoefficients(23040, 500).coefficient2 == ADX::COEF_2304_2);
+
+				if (this->sound >= 0) return -1;
+				if (GetFreeSlots() <= 0) return -2;
+
+				int16_t slot = 0;
+				while (slot < MAX_STREAMS && SlaveAdxStream::activeStreams[slot] != nullptr) slot++;
+				if (slot >= MAX_STREAMS) return -2;
+
+				if (!this->reader.Open(fileName)) return -5;
+
+				AdxHeader header{};
+
+				if (!ReadAdxHeader(this->reader, header, this->range))
+				{
+					this->reader.Close();
+					return -4;
+				}
+
+				// Ring is refilled in place, so it is locked against SoundRam::Compact()
+				uint32_t address = AllocateSoundRam(RING_SIZE, true);
+
+				if (address == 0)
+				{
+					this->reader.Close();
+					return -1;
+				}
+
+				this->sound = RegisterPcm(address, RING_SIZE, BitDepth::PCM16, (int32_t)header.sampleRate);
+				voices[this->sound].maxInstances = 1;
+				voices[this->sound].mode = PlayMode::ForwardLoop;
+				ctrlShadow[this->sound].loopType = PlayMode::ForwardLoop;
+				MarkDirty(this->sound);
+
+				this->index = slot;
+				this->decoder = SlaveAdxStream::CalculateCoefficients((int32_t)header.sampleRate, header.highPassCutOff);
+				this->looping = loop;
+				this->playing = false;
+				this->underruns = 0;
+				this->Prime();
+
+				SlaveAdxStream::activeStreams[slot] = this;
+				return this->sound;
+			}
+
+			/** @brief Stop playback, close the file and free the ring
+			 */
+			void Close()
+			{
+				if (this->sound < 0) return;
+
+				SlaveAdxStream::activeStreams[this->index] = nullptr;
+				this->Stop();
+				this->DropChunk();
+				this->reader.Close();
+
+				ReleaseSound(this->sound);
+				this->sound = -1;
+				this->index = -1;
+			}
+
+			/** @brief Start playback from the beginning of the stream
+			 * @param volume Starting volume (0-7)
+			 */
+			void Play(uint8_t volume = 7)
+			{
+				if (this->sound < 0) return;
+				if (!this->primed) this->Prime();
+
+				this->volume = volume;
+				this->startFrame = frameCounter;
+				this->playedBytes = 0;
+				this->playing = true;
+				this->primed = false;
+				voices[this->sound].volume = volume;
+				QueueCommand(this->sound, COMMAND_VOLUME | COMMAND_START, volume);
+			}
+
+			/** @brief Stop playback
+			 */
+			void Stop()
+			{
+				if (this->sound < 0) return;
+				this->playing = false;
+				QueueCommand(this->sound, COMMAND_HALT);
+			}
+
+			/** @brief Set stream volume
+			 * @param volume New volume (0-7)
+			 * @param pan Stereo pan to set (right being 0, left being 16)
+			 */
+			void SetVolume(const uint8_t volume, const uint8_t pan = 7)
+			{
+				this->volume = volume;
+				Pcm::SetVolume(this->sound, volume, pan);
+			}
+
+			/** @brief Check whether stream is playing
+			 */
+			bool IsPlaying() const
+			{
+				return this->playing;
+			}
+
+			/** @brief Number of times playback caught up with the decoded data
+			 */
+			int32_t GetUnderruns() const
+			{
+				return this->underruns;
+			}
+
+			/** @brief Sound RAM taken by the ring in bytes
+			 */
+			int32_t GetBufferSize() const
+			{
+				return RING_SIZE;
+			}
+
+			/** @brief How much of the ring holds data that was not played yet
+			 * @return Fill level in percent
+			 */
+			int32_t GetFillLevel() const
+			{
+				if (this->sound < 0) return 0;
+				return (this->GetBufferedBytes() * 100) / RING_SIZE;
+			}
+
+			/** @brief Number of UpdateAll() calls the slave was still busy with the last job, while it should have been collected
+			 */
+			static int32_t GetLateFrames()
+			{
+				return SlaveAdxStream::lateFrames;
+			}
+
+			/** @brief Get stream serviced by UpdateAll()
+			 * @param index Stream index (0 to MAX_STREAMS - 1)
+			 * @return Stream (nullptr if there is none at the index)
+			 */
+			static const SlaveAdxStream* GetActive(int32_t index)
+			{
+				return index >= 0 && index < MAX_STREAMS ? SlaveAdxStream::activeStreams[index] : nullptr;
+			}
+
+			/** @brief Time decoding of the same generated blocks on the master and on the slave SH-2
+			 * @param chunks Number of chunks of CHUNK_BLOCKS blocks each CPU decodes
+			 * @return Ticks and samples per second of both, next to the fastest stream the 68K driver decodes
+			 * @note Blocks the caller until done. Streams keep playing, but get no new chunks while it runs.
+			 */
+			static Benchmark RunBenchmark(int32_t chunks = 16)
+			{
+				static Job benchmarkJob;
+				alignas(4) static uint8_t blocks[CHUNK_INPUT];
+				alignas(4) static int16_t samples[CHUNK_SAMPLES];
+
+				SlaveAdxStream::benchmarking = true;
+				while (SlaveAdxStream::jobPending && !SlaveAdxStream::IsJobDone()) {}
+
+				// Blocks of noise, so nothing is cheaper than in real music
+				uint32_t seed = 0x2545F491;
+
+				for (int32_t i = 0; i < CHUNK_INPUT; i++)
+				{
+					seed = (seed * 1103515245) + 12345;
+					blocks[i] = (i % BLOCK_SIZE) == 0 ? 0 : (uint8_t)(seed >> 16);
+				}
+
+				Decoder state = SlaveAdxStream::CalculateCoefficients(44100, 500);
+				TimerStamp start = ReadTimer();
+
+				for (int32_t chunk = 0; chunk < chunks; chunk++)
+				{
+					SlaveAdxStream::DecodeBlocks(blocks, CHUNK_BLOCKS, samples, state);
+				}
+
+				Benchmark result{};
+				result.masterTicks = TimerElapsed(start);
+
+				benchmarkJob.tasks[0] = Task{ blocks, CHUNK_BLOCKS, &state, samples };
+				benchmarkJob.count = 1;
+				start = ReadTimer();
+
+				for (int32_t chunk = 0; chunk < chunks; chunk++)
+				{
+					benchmarkJob.done = false;
+					slSlaveFunc(SlaveAdxStream::DecodeJob, (void*)&benchmarkJob);
+					while (!CacheThrough(&benchmarkJob)->done) {}
+				}
+
+				result.slaveTicks = TimerElapsed(start);
+				SlaveAdxStream::benchmarking = false;
+
+				result.blocks = chunks * CHUNK_BLOCKS;
+				uint64_t samplesTimesRate = (uint64_t)result.blocks * BLOCK_SAMPLES * GetTimerRate();
+				result.masterRate = result.masterTicks > 0 ? (int32_t)(samplesTimesRate / result.masterTicks) : 0;
+				result.slaveRate = result.slaveTicks > 0 ? (int32_t)(samplesTimesRate / result.slaveTicks) : 0;
+
+				// Largest bytesPerBlank RegisterAdx() takes, in 16 bit samples per second
+				result.driverRate = (768 / 2) * (PCM::SYS_REGION ? 50 : 60);
+				return result;
+			}
+		};
+
+		/** @brief Most files the module keeps open at once, set SRL_MAX_CD_BACKGROUND_JOBS to at least this
+		 *
+		 * Every GFS handle counts against SRL_MAX_CD_BACKGROUND_JOBS: a blocking load (or the driver load), the Loader,
+		 * AdxStream, and each open PcmStream and SlaveAdxStream. Opening one more file fails like a missing file.
+		 * Games that never open some of these may set the limit lower by the streams they leave out.
+		 */
+		static constexpr auto MAX_OPEN_FILES = 1 + 1 + 1 + PcmStream::MAX_STREAMS + SlaveAdxStream::MAX_STREAMS;
+
+		/** @brief Playback of CD audio
+		 */
+		struct CD
+		{
+			/** @brief Set CD playback volume
+			 *  @param volume Driver volume (7 is max)
+			 */
+			static void SetVolume(const uint8_t volume)
+			{
+				CD::SetPan(volume, volume);
+			}
+
+			/** @brief Set CD playback stereo pan
+			 *  @param left Left channel volume (7 is max)
+			 *  @param right Right channel volume (7 is max)
+			 */
+			static void SetPan(const uint8_t left, const uint8_t right)
+			{
+				// Applied at next vblank
+				CancelEnvelope(0, ENVELOPE_CD);
+				CancelEnvelope(1, ENVELOPE_CD);
+				cdVolumeCommand[0] = 0x80 | (left & 0x7);
+				cdVolumeCommand[1] = 0x80 | (right & 0x7);
+				queuedCommands = queuedCommands + 1;
+			}
+
+			/** @brief Change CD playback volume of both channels gradually, one step per vblank
+			 *  @param volume Driver volume at the end (7 is max)
+			 *  @param frames Length of the fade in frames (0 changes the volume right away)
+			 *  @return false if no envelope was free and the volume was set right away
+			 */
+			static bool FadeTo(const uint8_t volume, const uint16_t frames)
+			{
+				if (frames > 0 &&
+					StartEnvelope(0, ENVELOPE_CD, GetCdVolume(0), volume & 0x7, frames, false) &&
+					StartEnvelope(1, ENVELOPE_CD, GetCdVolume(1), volume & 0x7, frames, false))
+				{
+					return true;
+				}
+
+				CD::SetVolume(volume);
+				return frames == 0;
+			}
+
+			/** @brief Fade CD playback out
+			 *  @details The drive keeps playing muted, call Stop() once the fade is done. CD block commands are not sent
+			 *  from the vblank, where they could interrupt a file read in progress.
+			 *  @param frames Length of the fade in frames
+			 *  @return false if no envelope was free and the volume was set right away
+			 */
+			static bool FadeOut(const uint16_t frames)
+			{
+				return CD::FadeTo(0, frames);
+			}
+
+			/** @brief Check whether a CD volume fade is still running
+			 */
+			static bool IsFading()
+			{
+				for (int16_t index = 0; index < MAX_ENVELOPES; index++)
+				{
+					if (envelopes[index].flags & ENVELOPE_CD) return true;
+				}
+
+				return false;
+			}
+
+			/** @brief Position of the drive's pickup
+			 */
+			struct Position
+			{
+				/** @brief Track number (0 if unknown)
+				 */
+				uint8_t track;
+
+				/** @brief Index inside the track
+				 */
+				uint8_t index;
+
+				/** @brief Frame address (75 frames per second from the start of the disc)
+				 */
+				int32_t fad;
+			};
+
+		private:
+			/** @brief Range of tracks given to Play() or Queue()
+			 */
+			struct Range
+			{
+				int32_t fromTrack;
+				int32_t toTrack;
+				bool loop;
+			};
+
+			/** @brief Play mode bit keeping the pickup where it is (CDC_PM_PIC_NOCHG), only the range changes
+			 */
+			static constexpr uint8_t PLAY_KEEP_PICKUP = 0x80;
+
+			/** @brief Play mode repeat count playing a range forever
+			 */
+			static constexpr uint8_t PLAY_REPEAT = 0xf;
+
+			/** @brief Status code bits of the drive status byte
 			 */
-			static void Initialize(const ADXMode mode)
+			static constexpr uint8_t STATUS_CODE_MASK = 0x0f;
+
+			static inline Range current = {};
+			static inline Range queued = {};
+			static inline int32_t pausedFad = 0;
+			static inline bool active = false;
+			static inline bool paused = false;
+			static inline bool hasQueued = false;
+			static inline bool chained = false;
+			static inline bool started = false;
+
+			/** @brief Send play command
+			 *  @param startType CDC_PTYPE_TNO to start at startValue's track, CDC_PTYPE_FAD at a frame address, CDC_PTYPE_NOCHG to keep playing
+			 *  @param startValue Track or frame address
+			 *  @param toTrack Ending track
+			 *  @param mode Play mode (repeat count and PLAY_KEEP_PICKUP)
+			 */
+			static void SendPlay(int32_t startType, int32_t startValue, int32_t toTrack, uint8_t mode)
 			{
-				// Load driver
-				LoadDriver(mode);
-				SRL::Core::OnVblank += SdrvVblankRq;
-                // Set default volumes
-                SetMasterVolume(15);
-				CD::SetVolume(15);
+				CdcPly ply;
+
+                // Start track
+                CDC_PLY_STYPE(&ply) = startType;
+                if (startType == CDC_PTYPE_FAD)
+                {
+                    CDC_PLY_SFAD(&ply) = startValue;
+                }
+                else
+                {
+                    CDC_PLY_STNO(&ply) = startValue;
+                    CDC_PLY_SIDX(&ply) = 1;
+                }
+
+                // End track
+                CDC_PLY_ETYPE(&ply) = CDC_PTYPE_TNO;
+                CDC_PLY_ETNO(&ply) = toTrack;
+                CDC_PLY_EIDX(&ply) = 1;
+
+                CDC_PLY_PMODE(&ply) = CDC_PM_DFL | mode;
+
+                CDC_CdPlay(&ply);
+                CD::started = false;
 			}
 
-			/** @brief Set master volume
-			 * @param volume New volume (0-15)
+			/** @brief Make range the current one and start it from its first track
+			 *  @param range Range to play
 			 */
-			static void SetMasterVolume(uint16_t volume)
+			static void Start(const Range& range)
 			{
-                volume = volume >= 0xF ? 0xF : volume;
-                masterVolume = 0x200 | (volume & 0xF);
-                driverMasterVolume = volume;
+				CD::current = range;
+				CD::active = true;
+				CD::paused = false;
+				SendPlay(CDC_PTYPE_TNO, range.fromTrack, range.toTrack, range.loop ? PLAY_REPEAT : 0);
 			}
-		};
 
-		struct Pcm
-		{
-			/** @brief Load PCM sound effect
-			 * @param file File name
-			 * @param bitDepth Bit depth of the sound effect
-			 * @param sampleRate Sample rate of the sound effect
-			 * @return Sound effect identifier (< 0 on fail)
+			/** @brief Read drive status without sending a command
+			 *  @param status Status of the drive
+			 *  @return Status code (CDC_ST_PLAY, CDC_ST_PAUSE...)
 			 */
-			static int16_t LoadPcm(const char* fileName, const BitDepth bitDepth, const int32_t sampleRate)
+			static uint8_t ReadStatus(CdcStat& status)
 			{
-                if ((int32_t)scspWorkAddr > 0x7F800) return -1;
-                if (numberOfPCMs >= PCM::CTRL_MAX) return -2;
-
-                SRL::Cd::File file(fileName);
+				CDC_GetPeriStat(&status);
+				return CDC_STAT_STATUS(&status) & STATUS_CODE_MASK;
+			}
 
-                if (file.Open())
-                {
-                    int32_t fileSize = file.Size.Bytes;
-                    
-                    if (fileSize > (128 * 1024) && bitDepth == BitDepth::PCM16)
-                    {
-                        return -3;
-                    }
-                    else if (fileSize > (64 * 1024) && bitDepth == BitDepth::PCM8)
-                    {
-                        return -3;
-                    }
+		public:
+			/** @brief Play range of tracks, anything queued is dropped
+			 *  @param fromTrack Starting track
+			 *  @param toTrack Ending track
+			 *  @param loop Whether to play the range of track again after it ends
+			 */
+			static void Play(const int32_t fromTrack, const int32_t toTrack, const bool loop = false)
+			{
+				CD::hasQueued = false;
+				CD::Start(Range{ fromTrack, toTrack, loop });
+			}
 
-                    fileSize += ((uint32_t)fileSize & 1) ? 1 : 0;
-                    fileSize += ((uint32_t)fileSize & 3) ? 2 : 0;
+			/** @brief Play a single track
+			 *  @param loop Whether to play the range of track again after it ends
+			 */
+			static void PlaySingle(int32_t track, bool loop = false)
+			{
+				Play(track, track, loop);
+			}
 
-                    file.Read(fileSize, (void*)((uint32_t)scspWorkAddr + SNDRAM));
-                                        
-                    return RegisterPcm(fileSize, bitDepth, sampleRate);
-                }
-                else {
-                    return -4;
-                }
-			}
-			
-            /** @brief Load packed PCM sound effects
-			 * @param fileName File name (.snd)
-			 * @param sounds Array to hold sample ids
-			 * @param maxSamples Number of samples in the .snd file
-			 * @return Number of samples loaded (< 0 on fail)
-			 */            static int LoadSound(const char* fileName, int16_t* sounds, int maxSamples)
-            {
-                SRL::Cd::File file(fileName);
-                if (!file.Open()) return -1;
-
-                int32_t count = -1;
-
-                while (count < maxSamples-1)
-                {                
-                    PcmHeader header;
-                    file.Read(sizeof(PcmHeader), &header);
-
-                    uint8_t* decompressed = nullptr;
-                    char* compressed = nullptr;
-                    
-                    count++;
-                    
-                    if (header.compressedSize == 0)
-                    {
-                        // RAW PCM
-                        file.Read(header.originalSize, (void*)((uint32_t)scspWorkAddr + SNDRAM));
-                    }
-                    else
-                    {
-                        // COMPRESSED PCM
-                        compressed = new char[header.compressedSize];
-                        decompressed = new uint8_t[header.originalSize];                        
-
-                        file.Read(header.compressedSize, compressed);
-                        Lzss::Decompress((uint8_t*)compressed, (uint8_t*)decompressed, header.originalSize);
-                        
-                        slDMACopy(decompressed, (void*)((uint32_t)scspWorkAddr + SNDRAM), header.originalSize);
-                        slDMAWait();
-
-                        delete[] compressed;
-                        delete[] decompressed;
-                    }
-
-                    sounds[count] = RegisterPcm(
-                        header.originalSize,
-                        (BitDepth)header.bitDepth,
-                        header.sampleRate
-                    );
-                }
-
-                return count;
-            }
-
-			/** @brief Load 8 bit PCM sound effect
-			 * @param file File name
-			 * @param sampleRate Sample rate of the sound effect
-			 * @return Sound effect identifier (< 0 on fail)
-			 */
-			static int16_t Load8(const char* fileName, const int32_t sampleRate = 15360)
-			{
-			    return LoadPcm(fileName, BitDepth::PCM8, sampleRate);
-			}
-			
-			/** @brief Load 16 bit PCM sound effect
-			 * @param file File name
-			 * @param sampleRate Sample rate of the sound effect
-			 * @return Sound effect identifier (< 0 on fail)
-			 */
-			static int16_t Load16(const char* fileName, const int32_t sampleRate = 15360)
-			{
-			    return LoadPcm(fileName, BitDepth::PCM16, sampleRate);
-			}
-			
-			/** @brief Load ADX sound effect
-			 * @param fileName File name
-			 * @return Sound effect identifier (< 0 on fail)
+			/** @brief Stop CD music playback
 			 */
-			static int16_t LoadAdx(const char* fileName)
+			static void Stop()
 			{
-                if ((int32_t)scspWorkAddr > 0x7F800) return -1;
-                if (numberOfPCMs >= PCM::CTRL_MAX) return -2;
+				CD::active = false;
+				CD::paused = false;
+				CD::hasQueued = false;
 
-                SRL::Cd::File file(fileName);
+				CdcPos poswk;
+				poswk.ptype = CDC_PTYPE_DFL;
+				CDC_CdSeek(&poswk);
+			}
 
-                if (file.Open())
-                {
-                    AdxHeader adxHeader{};
+			/** @brief Pause playback where it is, the pickup stays in place so Resume() starts without a seek
+			 *  @return Frame address playback stopped at (0 if nothing was playing)
+			 */
+			static int32_t Pause()
+			{
+				if (!CD::active || CD::paused) return CD::paused ? CD::pausedFad : 0;
 
-                    if (file.Read(sizeof(AdxHeader), (void*)&adxHeader) &&
-                    (adxHeader.oneHalf == 32768 && adxHeader.blockSize == 18 && adxHeader.bitDepth == 4))
-                    {
-                        uint32_t workAddress = (uint32_t)(scspWorkAddr) + 16;  // we are not copying the header so this offset is different
-                        m68kCommands.pcmCtrl[numberOfPCMs].hiAddrBits = (uint16_t)((uint32_t)workAddress >> 16);
-                        m68kCommands.pcmCtrl[numberOfPCMs].loAddrBits = (uint16_t)((uint32_t)workAddress & 0xFFFF);
-                        m68kCommands.pcmCtrl[numberOfPCMs].pitchWord = ConvertBitrateToPitchWord(adxHeader.sampleRate);
-                        m68kCommands.pcmCtrl[numberOfPCMs].playSize = (adxHeader.sampleCount / 32);
-                        int16_t bytesPerBlank = CalculateBytesPerBlank((int32_t)adxHeader.sampleRate, false, PCM::SYS_REGION);
-
-                        if (bytesPerBlank != 768 && bytesPerBlank != 512 && bytesPerBlank != 384 && bytesPerBlank != 256 && bytesPerBlank != 192 && bytesPerBlank != 128)
-                        {
-                            return -3;
-                        }
-                        else {
-                            m68kCommands.pcmCtrl[numberOfPCMs].bytesPerBlank = bytesPerBlank;
-                            uint16_t bigDictionarySize = (bytesPerBlank >= 256) ? CalculateLCM(bytesPerBlank, bytesPerBlank + 64) << 1 : 5376;
-                            m68kCommands.pcmCtrl[numberOfPCMs].decompressionSize = (bigDictionarySize > (adxHeader.sampleCount << 1)) ? adxHeader.sampleCount << 1 : bigDictionarySize;
-                            m68kCommands.pcmCtrl[numberOfPCMs].bitDepth = PCM::TYPE_ADX;
-                            m68kCommands.pcmCtrl[numberOfPCMs].loopType = PlayMode::Semi;
-                            m68kCommands.pcmCtrl[numberOfPCMs].volume = 7;
-
-                            uint32_t bytesToLoad = (adxHeader.sampleCount / 32) * 18;
-                            bytesToLoad += ((uint32_t)bytesToLoad & 1) ? 1 : 0;
-                            bytesToLoad += ((uint32_t)bytesToLoad & 3) ? 2 : 0;
-
-                            file.Read(bytesToLoad, (void*)((uint32_t)scspWorkAddr + SNDRAM));
-
-                            numberOfPCMs++;
-                            scspWorkAddr = (uint32_t*)((uint32_t)scspWorkAddr + bytesToLoad);
-
-                            return (numberOfPCMs - 1);
-                        }
-                    }
-                    else {
-                        return -4;
-                    }
-                }
-                else
-                {
-                    return -5;
-                }
+				CdcStat status;
+				CD::ReadStatus(status);
+				CD::pausedFad = CDC_STAT_FAD(&status);
+				CD::paused = true;
+
+				CdcPos poswk;
+				poswk.ptype = CDC_PTYPE_NOCHG;
+				CDC_CdSeek(&poswk);
+				return CD::pausedFad;
 			}
 
-			/** @brief Set volume of currently playing sound
-			 * @param sound Sound to modify
-			 * @param volume New volume (0-7)
-			 * @param pan Stereo pan to set (right being 0, left being 16)
+			/** @brief Continue playback of the current range from a frame address
+			 *  @details A looping range plays from there to its end once and then starts over from its first track.
+			 *  @param fad Frame address to continue from (0 for where Pause() stopped)
+			 *  @return false if there is no range to continue
 			 */
-			static void SetVolume(const int16_t sound, const uint8_t volume, const uint8_t pan = 7)
+			static bool Resume(const int32_t fad = 0)
 			{
-				if (sound < 0) return;
-				m68kCommands.pcmCtrl[sound].volume = volume;
-				m68kCommands.pcmCtrl[sound].pan = pan;
+				if (!CD::active) return false;
+
+				int32_t from = fad != 0 ? fad : CD::pausedFad;
+				CD::paused = false;
+
+				if (from == 0)
+				{
+					CD::Start(CD::current);
+					return true;
+				}
+
+				// Repeats would start over at the resume point, so the loop is queued behind this pass instead
+				if (CD::current.loop && !CD::hasQueued)
+				{
+					CD::queued = CD::current;
+					CD::hasQueued = true;
+					CD::chained = false;
+				}
+
+				SendPlay(CDC_PTYPE_FAD, from, CD::current.toTrack, 0);
+				return true;
 			}
 
-			/** @brief Stop playing sound
-			 * @param sound Sound to stop
+			/** @brief Play a range of tracks when the current one ends, instead of the current range repeating
+			 *  @details A range starting right after the current one is appended to the play command at once, so the
+			 *  drive runs into it without stopping or seeking. Other ranges start on the first Update() after the current
+			 *  range ends, with one seek. Without anything playing the range starts right away.
+			 *  @param fromTrack Starting track
+			 *  @param toTrack Ending track
+			 *  @param loop Whether to play the range of track again after it ends
 			 */
-			static void Stop(const int16_t sound)
+			static void Queue(const int32_t fromTrack, const int32_t toTrack, const bool loop = false)
 			{
-				if (sound < 0) return;
-				if (m68kCommands.pcmCtrl[sound].loopType <= 0)
+				if (!CD::active)
 				{
-					m68kCommands.pcmCtrl[sound].volume = 0;
+					CD::Play(fromTrack, toTrack, loop);
+					return;
 				}
-				else
+
+				CD::queued = Range{ fromTrack, toTrack, loop };
+				CD::hasQueued = true;
+				CD::chained = false;
+
+				if (!CD::paused && fromTrack == CD::current.toTrack + 1)
 				{
-					m68kCommands.pcmCtrl[sound].sh2Permit = 0;
+					// Keep playing from where the pickup is and move the end of the range
+					SendPlay(CDC_PTYPE_NOCHG, 0, toTrack, PLAY_KEEP_PICKUP);
+					CD::chained = true;
 				}
 			}
 
-			/** @brief Will remove all sounds after the specified sound
-			 * @param lastToKeep Index of the last sound to be kept loaded
+			/** @brief Play a single track when the current range ends
+			 *  @param track Track to play
+			 *  @param loop Whether to play the track again after it ends
 			 */
-			static void Unload(const int16_t lastTokeep)
+			static void QueueSingle(const int32_t track, const bool loop = false)
+			{
+				CD::Queue(track, track, loop);
+			}
+
+			/** @brief Check whether a queued range is still waiting for the current one to end
+			 */
+			static bool HasQueued()
+			{
+				return CD::hasQueued;
+			}
+
+			/** @brief Start queued ranges, call once per frame while CD audio plays
+			 *  @note Only reads the drive's periodic status, the play command is sent when a range actually changes
+			 */
+			static void Update()
 			{
-				if (lastTokeep < 0)
+				if (!CD::active || CD::paused) return;
+
+				CdcStat status;
+				uint8_t code = CD::ReadStatus(status);
+
+				// A range that just got its play command still reports the old pause until the drive starts
+				if (code == CDC_ST_PLAY)
 				{
-					scspWorkAddr = scspWorkStart;
-					numberOfPCMs = 0;
-					return;
+					CD::started = true;
 				}
 
-				numberOfPCMs = lastTokeep + 1;
-				scspWorkAddr =
-					(uint32_t*)((uint32_t)(m68kCommands.pcmCtrl[lastTokeep].hiAddrBits << 16) |
-						(int32_t)(m68kCommands.pcmCtrl[lastTokeep].loAddrBits));
+				if (!CD::hasQueued) return;
 
-				if (m68kCommands.pcmCtrl[lastTokeep].bitDepth == 2)
+				if (CD::chained)
 				{
-					scspWorkAddr = (uint32_t*)((uint32_t)scspWorkAddr + (m68kCommands.pcmCtrl[lastTokeep].playSize * 18));
+					int32_t track = CDC_STAT_TNO(&status);
+					if (code != CDC_ST_PLAY || track < CD::queued.fromTrack || track > CD::queued.toTrack) return;
+
+					// Drive ran into the queued range, set its start for repeats without moving the pickup
+					CD::hasQueued = false;
+					CD::current = CD::queued;
+					if (CD::current.loop) SendPlay(CDC_PTYPE_TNO, CD::current.fromTrack, CD::current.toTrack, PLAY_REPEAT | PLAY_KEEP_PICKUP);
 				}
-				else if (m68kCommands.pcmCtrl[lastTokeep].bitDepth == 1)
+				else if (CD::started && (code == CDC_ST_PAUSE || code == CDC_ST_STANDBY))
 				{
-					scspWorkAddr = (uint32_t*)((uint32_t)scspWorkAddr + m68kCommands.pcmCtrl[lastTokeep].playSize);
+					CD::hasQueued = false;
+					CD::Start(CD::queued);
 				}
-				else if (m68kCommands.pcmCtrl[lastTokeep].bitDepth == 0)
+			}
+
+			/** @brief Get state of playback
+			 */
+			static CdStatus GetStatus()
+			{
+				CdcStat status;
+				uint8_t code = CD::ReadStatus(status);
+
+				switch (code)
 				{
-					scspWorkAddr = (uint32_t*)((uint32_t)scspWorkAddr + (m68kCommands.pcmCtrl[lastTokeep].playSize << 1));
+				case CDC_ST_PLAY:
+					return CdStatus::Playing;
+
+				case CDC_ST_PAUSE:
+				case CDC_ST_STANDBY:
+					return CD::paused ? CdStatus::Paused : CdStatus::Stopped;
+
+				case CDC_ST_BUSY:
+				case CDC_ST_SEEK:
+				case CDC_ST_SCAN:
+					return CdStatus::Seeking;
+
+				case CDC_ST_OPEN:
+				case CDC_ST_NODISC:
+					return CdStatus::NoDisc;
+
+				default:
+					return CdStatus::Error;
 				}
 			}
 
-			/** @brief Play sound
-			 * @param sound Sound to play
-			 * @param mode Loop/Playback mode mode
-			 * @param volume Starting volume
+			/** @brief Get current position of the pickup
 			 */
-            static void Play(int16_t sound,
-            PlayMode mode = PlayMode::Protected,
-            uint8_t volume = 7) // 15?
-            {
-				if (sound < 0) return;
-				m68kCommands.pcmCtrl[sound].sh2Permit = 1;
-				m68kCommands.pcmCtrl[sound].volume = volume;
-				m68kCommands.pcmCtrl[sound].loopType = mode;
+			static Position GetPosition()
+			{
+				CdcStat status;
+				CD::ReadStatus(status);
+				return Position{ (uint8_t)CDC_STAT_TNO(&status), (uint8_t)CDC_STAT_IDX(&status), CDC_STAT_FAD(&status) };
+			}
+
+			/** @brief Get track being played
+			 *  @return Track number (0 if nothing is playing)
+			 */
+			static int32_t GetTrack()
+			{
+				return CD::active && !CD::paused ? CD::GetPosition().track : 0;
 			}
-		};
-		
-		/** @brief CD Streamed playback of sound effects & music (future)
-		 */
-		struct PcmStream
-		{
-            // pcm_stream_init
-            void Init(int32_t bitrate, BitDepth bit_depth) { // pal mode?
-                // need to calculate buffer_size_bytes and transfer_sectors
-                short byteRate = Sound::CalculateBytesPerBlank(bitrate, (bool)bit_depth, false);
-                
-                int32_t buffer_size_bytes = byteRate * Sound::PCM::BUFFERED_BLANKS; // "byteRate" being the bytes per blank of the music track
-                
-                int32_t segment_size = buffer_size_bytes / Sound::PCM::NUM_BUF;
-                int32_t transfer_sectors = segment_size / 2048;
-            }
 		};
 
-		/** @brief Playback of CD audio
+		/**
+		 * @brief Numbers for sizing banks and finding slow loads
+		 *
+		 * Memory, slot and command counts read state the library keeps anyway. Loads are timed with the SH-2 free running
+		 * timer around CD reads, LZSS decoding and sound RAM uploads, and the last MAX_LOADS of them are kept.
+		 * Print() shows a summary through SRL::Debug::Print().
 		 */
-		struct CD
+		struct Stats
 		{
-			/** @brief Set CD playback volume
-			 *  @param volume Driver volume (7 is max)
+			/** @brief Number of finished loads kept
 			 */
-			static void SetVolume(const uint8_t volume)
+			static constexpr auto MAX_LOADS = LOAD_HISTORY;
+
+			/** @brief Number of characters in the sound RAM map drawn by Print()
+			 */
+			static constexpr auto MAP_WIDTH = 32;
+
+			/** @brief Get allocated block of sound RAM, blocks are sorted by address (see SoundRam::GetBlockCount())
+			 * @param index Block index
+			 * @return Block (size 0 if there is no such block)
+			 */
+			static SoundRamBlock GetBlock(int16_t index)
 			{
-				uint8_t newvol = m68kCommands.cddaLeftChannelVolPan & 0x1F;
-				newvol |= ((volume & 0x7) << 5);
-				m68kCommands.cddaLeftChannelVolPan = newvol;
+				if (index < 0 || index >= soundRamBlockCount) return SoundRamBlock{ 0, 0, -1, false };
+				return soundRamBlocks[index];
+			}
 
-				newvol = m68kCommands.cddaRightChannelVolPan & 0x1F;
-				newvol |= ((volume & 0x7) << 5);
-				m68kCommands.cddaRightChannelVolPan = newvol;
+			/** @brief Get number of control slots in use, including extra instances of playing samples
+			 */
+			static int16_t GetUsedSlots()
+			{
+				return numberOfPCMs - releasedSlotCount;
 			}
 
-			/** @brief Set CD playback stereo pan
-			 *  @param left Left channel volume (7 is max)
-			 *  @param right Right channel volume (7 is max)
+			/** @brief Get number of control slots the driver has
 			 */
-			static void SetPan(const uint8_t left, const uint8_t right)
+			static int16_t GetMaxSlots()
 			{
-				uint8_t newvol = m68kCommands.cddaLeftChannelVolPan & 0x1F;
-				newvol |= ((left & 0x7) << 5);
-				m68kCommands.cddaLeftChannelVolPan = newvol;
+				return PCM::CTRL_MAX;
+			}
 
-				newvol = m68kCommands.cddaRightChannelVolPan & 0x1F;
-				newvol |= ((right & 0x7) << 5);
-				m68kCommands.cddaRightChannelVolPan = newvol;
+			/** @brief Get most Play/SetVolume/Stop commands merged into one vblank since ResetPeaks()
+			 */
+			static uint16_t GetPeakCommandCount()
+			{
+				return peakFrameCommands;
 			}
 
-			/** @brief Play range of tracks
-			 *  @param fromTrack Starting track
-			 *  @param toTrack Ending track
-			 *  @param loop Whether to play the range of track again after it ends
+			/** @brief Get most control slots written by one vblank since ResetPeaks()
 			 */
-			static void Play(const int32_t fromTrack, const int32_t toTrack, const bool loop = false)
+			static uint16_t GetPeakCommandWrites()
 			{
-				CdcPly ply;
+				return peakFrameSlotWrites;
+			}
 
-                // Start track
-                CDC_PLY_STYPE(&ply) = CDC_PTYPE_TNO;
-                CDC_PLY_STNO(&ply) = fromTrack;
-                CDC_PLY_SIDX(&ply) = 1;
+			/** @brief Start measuring command peaks over
+			 */
+			static void ResetPeaks()
+			{
+				peakFrameCommands = 0;
+				peakFrameSlotWrites = 0;
+			}
 
-                // End track
-                CDC_PLY_ETYPE(&ply) = CDC_PTYPE_TNO;
-                CDC_PLY_ETNO(&ply) = toTrack;
-                CDC_PLY_EIDX(&ply) = 1;
+			/** @brief Get number of loads finished since start (blocking and async, failed ones too)
+			 */
+			static uint32_t GetLoadCount()
+			{
+				return loadCount;
+			}
 
-                // Set loop mode
-                CDC_PLY_PMODE(&ply) = CDC_PM_DFL | (loop ? 0xf : 0); // 0xf = infinite repetitions
+			/** @brief Get profile of a finished load
+			 * @param age 0 for the last load, 1 for the one before, up to MAX_LOADS - 1
+			 * @return Load profile (all zero if there is no such load)
+			 */
+			static LoadProfile GetLoad(int32_t age)
+			{
+				if (age < 0 || age >= MAX_LOADS || (uint32_t)age >= loadCount) return LoadProfile{};
+				return loadHistory[(loadCount - 1 - age) % LOAD_HISTORY];
+			}
 
-                CDC_CdPlay(&ply);
+			/** @brief Get profile of the last driver boot
+			 */
+			static BootProfile GetBoot()
+			{
+				return driverBoot;
 			}
 
-			/** @brief Play a single track
-			 *  @param loop Whether to play the range of track again after it ends
+			/** @brief Convert timer ticks of a load profile
+			 * @param ticks Timer ticks
+			 * @return Microseconds (assumes the nominal NTSC clock of 320 pixel wide modes, 6% high in 352 wide ones)
 			 */
-			static void PlaySingle(int32_t track, bool loop = false)
+			static uint32_t ToMicroseconds(uint32_t ticks)
 			{
-				Play(track, track, loop);
+				return (uint32_t)(((uint64_t)ticks * 1000000) / GetTimerRate());
 			}
 
-			/** @brief Stop CD music playback
+			/** @brief Show sound RAM, slots, commands, last load and streams on screen, call every frame while wanted
+			 * @param column Left column
+			 * @param row Top row, 6 rows are used
 			 */
-			static void Stop()
+			static void Print(uint16_t column = 1, uint16_t row = 20)
 			{
-				CdcPos poswk;
-				poswk.ptype = CDC_PTYPE_DFL;
-				CDC_CdSeek(&poswk);
+				SRL::Debug::Print(column, row, "RAM used %dK free %dK big %dK   ",
+					SoundRam::GetUsedSpace() >> 10,
+					SoundRam::GetFreeSpace() >> 10,
+					SoundRam::GetLargestFreeBlock() >> 10);
+
+				// One character per 1/32 of sound RAM: '#' samples, 'S' streams, '+' loading, '.' free
+				char map[MAP_WIDTH + 1];
+				uint32_t cell = (BankManifest::MAX_SOUND_RAM + MAP_WIDTH - 1) / MAP_WIDTH;
+
+				for (int32_t i = 0; i < MAP_WIDTH; i++)
+				{
+					map[i] = '.';
+				}
+
+				for (int16_t block = 0; block < soundRamBlockCount; block++)
+				{
+					const SoundRamBlock& current = soundRamBlocks[block];
+					char mark = current.locked ? 'S' : (current.sound < 0 ? '+' : '#');
+					uint32_t first = (current.address - SCSP_WORK_START) / cell;
+					uint32_t last = (current.address + current.size - 1 - SCSP_WORK_START) / cell;
+
+					for (uint32_t i = first; i <= last && i < MAP_WIDTH; i++)
+					{
+						map[i] = mark;
+					}
+				}
+
+				map[MAP_WIDTH] = '\0';
+				SRL::Debug::Print(column, row + 1, "%s", map);
+
+				SRL::Debug::Print(column, row + 2, "Slots %d/%d Cmd %d/%d peak %d/%d   ",
+					Stats::GetUsedSlots(), PCM::CTRL_MAX,
+					lastFrameCommands, lastFrameSlotWrites,
+					peakFrameCommands, peakFrameSlotWrites);
+
+				LoadProfile last = Stats::GetLoad(0);
+
+				if (last.fileName != nullptr)
+				{
+					SRL::Debug::Print(column, row + 3, "%s %d %dB %dms %df   ",
+						last.fileName, last.result, last.bytesRead,
+						Stats::ToMicroseconds(last.totalTicks) / 1000, last.frames);
+					SRL::Debug::Print(column, row + 4, "cd %d dec %d dma %d us   ",
+						Stats::ToMicroseconds(last.readTicks),
+						Stats::ToMicroseconds(last.decodeTicks),
+						Stats::ToMicroseconds(last.dmaTicks));
+				}
+
+				const PcmStream* first = PcmStream::GetActive(0);
+				const PcmStream* second = PcmStream::GetActive(1);
+				SRL::Debug::Print(column, row + 5, "Fill adx %d pcm %d %d   ",
+					AdxStream::GetFillLevel(),
+					first != nullptr ? first->GetFillLevel() : 0,
+					second != nullptr ? second->GetFillLevel() : 0);
 			}
 		};
 	};
@@ -752,7 +7769,47 @@ namespace SRL::Ponesound
     /** 
      * @brief PCM API alias
      */
-    using Stream = Sound::PcmStream;
+    using Stream = Sound::PcmStream;
+    /**
+     * @brief ADX stream API alias
+     */
+    using AdxStream = Sound::AdxStream;
+    /**
+     * @brief Slave SH-2 decoded ADX stream API alias
+     */
+    using SlaveAdxStream = Sound::SlaveAdxStream;
+    /**
+     * @brief Asynchronous loader API alias
+     */
+    using Loader = Sound::Loader;
+    /**
+     * @brief Sound RAM allocator API alias
+     */
+    using SoundRam = Sound::SoundRam;
+    /**
+     * @brief Voice allocation API alias
+     */
+    using Voice = Sound::Voice;
+    /**
+     * @brief Positional audio API alias
+     */
+    using Spatial = Sound::Spatial;
+    /**
+     * @brief Generated sound bank manifest alias
+     */
+    using BankManifest = Sound::BankManifest;
+    /**
+     * @brief Refcounted sound bank handle alias
+     */
+    using SoundBank = Sound::SoundBank;
+    /**
+     * @brief Runtime statistics API alias
+     */
+    using Stats = Sound::Stats;
+    /**
+     * @brief Sound archive API alias
+     */
+    using Pack = Sound::Pack;
 
     /**
      * @brief CD API alias
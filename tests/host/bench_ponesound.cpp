@@ -0,0 +1,94 @@
+/*
+ * Microbenchmarks of ponesound.hpp on the host. Host time says nothing about the SH-2, it shows which paths do more work
+ * after a change. Argument is the number of iterations (default 1000).
+ */
+
+#include "host_access.hpp"
+
+#include <banks/CAT_SND.hpp>
+
+#include <chrono>
+
+using namespace SRL::Ponesound;
+
+namespace
+{
+    /** @brief Run a function a number of times and print the time per call
+     */
+    template <typename Function>
+    void Measure(const char* name, int32_t iterations, Function function)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        for (int32_t i = 0; i < iterations; i++)
+        {
+            function();
+        }
+
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-28s %12.1f ns/op\n", name, elapsed / iterations);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int32_t iterations = argc > 1 ? std::atoi(argv[1]) : 1000;
+    iterations = iterations > 0 ? iterations : 1;
+
+    if (!HostAccess::Boot())
+    {
+        std::fprintf(stderr, "driver did not boot\n");
+        return 1;
+    }
+
+    int16_t sounds[HostAccess::CTRL_MAX];
+
+    Measure("LoadSound CAT.SND", iterations, [&]() {
+        Sound::Pcm::LoadSound("CAT.SND", sounds, HostAccess::CTRL_MAX);
+        Sound::Pcm::Unload(-1);
+    });
+
+    Measure("LoadBank CAT.SND", iterations, [&]() {
+        Sound::Pcm::LoadBank(Banks::CAT_SND::Manifest, sounds);
+        Sound::Pcm::Unload(-1);
+    });
+
+    Measure("LoadBankAsync CAT.SND", iterations, [&]() {
+        int16_t request = Sound::Pcm::LoadBankAsync(Banks::CAT_SND::Manifest, sounds);
+
+        while (Sound::Loader::GetStatus(request) == LoadStatus::Pending)
+        {
+            Sound::Loader::Update();
+        }
+
+        Sound::Loader::Release(request);
+        Sound::Pcm::Unload(-1);
+    });
+
+    Measure("RegisterPcm + Unload", iterations * 10, [&]() {
+        uint32_t address = HostAccess::AllocateSoundRam(4096);
+        HostAccess::RegisterPcm(address, 4096, BitDepth::PCM8, 15360);
+        Sound::Pcm::Unload(-1);
+    });
+
+    Sound::Pcm::LoadBank(Banks::CAT_SND::Manifest, sounds);
+    int16_t sound = 0;
+
+    Measure("Play", iterations * 10, [&]() {
+        Sound::Pcm::Play(sounds[sound]);
+        sound = (sound + 1) % Banks::CAT_SND::Count;
+    });
+
+    Measure("Vblank, 9 voices", iterations * 10, [&]() {
+        Sound::Pcm::Play(sounds[sound]);
+        sound = (sound + 1) % Banks::CAT_SND::Count;
+        Host::Vblank();
+    });
+
+    Measure("Vblank, idle", iterations * 10, [&]() {
+        Host::Vblank();
+    });
+
+    Sound::Pcm::Unload(-1);
+    return Host::openHandles == 0 ? 0 : 1;
+}
@@ -0,0 +1,235 @@
+/*
+ * Fuzzer of the file parsers of ponesound.hpp: .snd (blocking and through Loader), sound archives, ADX samples and
+ * the ADX stream header. Every input is loaded as each kind of file, then everything is unloaded again and the
+ * allocator and GFS handles have to be back where they started.
+ *
+ * Without PONESOUND_LIBFUZZER this builds a standalone driver that mutates the sample's CAT.SND and NBGM.ADX:
+ *   fuzz_ponesound [iterations] [seed]   mutate the seed files
+ *   fuzz_ponesound file...               run files once, ie a crash found by libFuzzer
+ */
+
+#include "host_access.hpp"
+
+using namespace SRL::Ponesound;
+
+namespace
+{
+    /** @brief Check state after everything was unloaded, stop on the first broken input
+     */
+    void Expect(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "fuzz: %s\n", what);
+            std::abort();
+        }
+    }
+
+    void ExpectEmpty()
+    {
+        Expect(HostAccess::SlotCount() == 0, "control slots left after unload");
+        Expect(HostAccess::BlockCount() == 0, "sound RAM left after unload");
+        Expect(Host::openHandles == 0, "GFS handle left open");
+    }
+
+    /** @brief Check that loaded samples play from inside the blocks they own
+     */
+    void ExpectValidSlots()
+    {
+        for (int16_t slot = 0; slot < HostAccess::SlotCount(); slot++)
+        {
+            uint32_t address = HostAccess::SampleAddress(slot);
+            if (address == 0) continue;
+
+            Expect(address >= HostAccess::WORK_START && address < HostAccess::WORK_END, "sample outside of the work area");
+        }
+    }
+
+    void Unload()
+    {
+        Sound::Pcm::Unload(-1);
+        Host::Vblank();
+        ExpectEmpty();
+    }
+
+    /** @brief Load one input as every kind of file
+     */
+    void FuzzOne(const uint8_t* data, size_t size)
+    {
+        static bool booted = HostAccess::Boot();
+        Expect(booted, "driver did not boot");
+
+        std::vector<uint8_t> file(data, data + size);
+        Host::AddFile("FUZZ.SND", file);
+        Host::AddFile("FUZZ.ADX", file);
+        Host::AddFile("FUZZ.PAK", file);
+
+        int16_t sounds[HostAccess::CTRL_MAX];
+        Sound::Pcm::LoadSound("FUZZ.SND", sounds, HostAccess::CTRL_MAX);
+        ExpectValidSlots();
+        Unload();
+
+        const char* names[] = { "MEOW1.PCM", "MEOW9.PCM" };
+        Sound::Pcm::LoadSoundByName("FUZZ.SND", sounds, names, 2);
+        ExpectValidSlots();
+        Unload();
+
+        int16_t request = Sound::Pcm::LoadSoundAsync("FUZZ.SND", sounds, HostAccess::CTRL_MAX);
+
+        for (int32_t frame = 0; frame < 100000 && Sound::Loader::GetStatus(request) == LoadStatus::Pending; frame++)
+        {
+            Sound::Loader::Update(4096);
+            Host::Vblank();
+        }
+
+        Expect(Sound::Loader::GetStatus(request) != LoadStatus::Pending, "async load did not finish");
+        Sound::Loader::Release(request);
+        ExpectValidSlots();
+        Unload();
+
+        Sound::Pcm::LoadAdx("FUZZ.ADX");
+        ExpectValidSlots();
+        Unload();
+
+        if (Sound::AdxStream::Open("FUZZ.ADX", true) >= 0)
+        {
+            for (int32_t frame = 0; frame < 4; frame++)
+            {
+                Sound::AdxStream::Update();
+                Host::Vblank();
+            }
+
+            Sound::AdxStream::Close();
+        }
+
+        Unload();
+
+        if (Sound::Pack::Open("FUZZ.PAK") > 0)
+        {
+            // Whatever the directory points at is loaded through the archive
+            Sound::Pcm::LoadSound("CAT.SND", sounds, HostAccess::CTRL_MAX);
+            Unload();
+            Sound::Pcm::LoadAdx("NBGM.ADX");
+            Unload();
+        }
+
+        Sound::Pack::Close();
+    }
+}
+
+#if defined(PONESOUND_LIBFUZZER)
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    FuzzOne(data, size);
+    return 0;
+}
+
+#else
+
+namespace
+{
+    /** @brief xorshift32
+     */
+    uint32_t Next(uint32_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    /** @brief Apply a few random edits, biased towards the headers where the parsers make their decisions
+     */
+    std::vector<uint8_t> Mutate(const std::vector<uint8_t>& seed, uint32_t& state)
+    {
+        static constexpr uint32_t interesting[] = { 0, 1, 0x7F, 0x80, 0xFF, 0x7FFF, 0x8000, 0xFFFF, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF };
+        std::vector<uint8_t> data = seed;
+        int32_t edits = 1 + (Next(state) % 4);
+
+        for (int32_t edit = 0; edit < edits && !data.empty(); edit++)
+        {
+            size_t range = (Next(state) & 1) ? std::min<size_t>(data.size(), 512) : data.size();
+            size_t at = Next(state) % range;
+
+            switch (Next(state) % 6)
+            {
+            case 0:
+                data[at] ^= (uint8_t)(1 << (Next(state) % 8));
+                break;
+
+            case 1:
+                data[at] = (uint8_t)Next(state);
+                break;
+
+            case 2:
+            {
+                uint32_t value = interesting[Next(state) % (sizeof(interesting) / sizeof(interesting[0]))];
+
+                for (size_t byte = 0; byte < 4 && at + byte < data.size(); byte++)
+                {
+                    data[at + byte] = (uint8_t)(value >> ((Next(state) & 1) ? (byte * 8) : ((3 - byte) * 8)));
+                }
+
+                break;
+            }
+
+            case 3:
+                data.resize(at);
+                break;
+
+            case 4:
+                data.insert(data.begin() + at, data.begin(), data.begin() + std::min<size_t>(data.size() - at, 64));
+                break;
+
+            default:
+                data.erase(data.begin() + at, data.begin() + std::min<size_t>(data.size(), at + 1 + (Next(state) % 64)));
+                break;
+            }
+        }
+
+        return data;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && (argv[1][0] < '0' || argv[1][0] > '9'))
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::vector<uint8_t> data = Host::ReadFile(argv[i]);
+            FuzzOne(data.data(), data.size());
+            std::printf("%s ok\n", argv[i]);
+        }
+
+        return 0;
+    }
+
+    int32_t iterations = argc > 1 ? std::atoi(argv[1]) : 10000;
+    uint32_t state = argc > 2 ? (uint32_t)std::strtoul(argv[2], nullptr, 0) : 0x50AE5EED;
+    state = state != 0 ? state : 1;
+
+    // ADX seed keeps the header and the first blocks, enough for every header path
+    std::vector<uint8_t> adx = ReadCdFile("NBGM.ADX");
+    adx.resize(std::min<size_t>(adx.size(), 16 * 1024));
+    const std::vector<uint8_t> seeds[] = { ReadCdFile("CAT.SND"), adx, ReadCdFile("GMOVR8.PCM") };
+
+    for (const std::vector<uint8_t>& seed : seeds)
+    {
+        Expect(!seed.empty(), "seed file missing");
+        FuzzOne(seed.data(), seed.size());
+    }
+
+    for (int32_t i = 0; i < iterations; i++)
+    {
+        const std::vector<uint8_t>& seed = seeds[Next(state) % 3];
+        std::vector<uint8_t> data = Mutate(seed, state);
+        FuzzOne(data.data(), data.size());
+    }
+
+    std::printf("%d inputs ok\n", iterations);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,175 @@
+#pragma once
+
+/*
+ * Shared part of the host tests, benchmarks and fuzzer: a fake sound driver and access to the internals of Sound.
+ *
+ * The 68K does not run here. Starting the sound CPU publishes a control table in the driver's part of sound RAM, which
+ * is all LoadDriver() waits for, so everything up to the control table writes runs as on the Saturn.
+ */
+
+#include <ponesound.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace SRL::Ponesound
+{
+    /** @brief Internals of Sound the host build checks (friend of Sound)
+     */
+    struct HostAccess
+    {
+        using CTRL = Sound::PCM::CTRL;
+        using SoundRamBlock = Sound::SoundRamBlock;
+
+        /** @brief Offset of the fake driver's control table in sound RAM, inside the area the real driver occupies
+         */
+        static constexpr uint32_t DRIVER_TABLE = 0x8000;
+
+        static constexpr int16_t CTRL_MAX = Sound::PCM::CTRL_MAX;
+        static constexpr uint32_t WORK_START = Sound::SCSP_WORK_START;
+        static constexpr uint32_t WORK_END = Sound::SCSP_WORK_END;
+
+        /** @brief Control table the fake driver publishes
+         */
+        static CTRL* DriverTable()
+        {
+            return reinterpret_cast<CTRL*>(Host::SoundRam() + DRIVER_TABLE);
+        }
+
+        /** @brief Load driver from the module data and start it, with every host file of the sample mounted
+         * @return Driver::Initialize() result
+         */
+        static bool Boot(ADXMode mode = ADXMode::ADX768)
+        {
+            Sound::Pack::Close();
+            Host::Reset();
+            Host::Mount(PONESOUND_DRIVER_DATA);
+            Host::Mount(PONESOUND_SAMPLE_DATA);
+            Host::onSoundCpuStart = []() { Sound::m68kCommands.pcmCtrl = DriverTable(); };
+            return Sound::Driver::Initialize(mode);
+        }
+
+        static int16_t RegisterPcm(uint32_t address, int32_t fileSize, BitDepth bitDepth, int32_t sampleRate)
+        {
+            return Sound::RegisterPcm(address, fileSize, bitDepth, sampleRate);
+        }
+
+        static uint32_t AllocateSoundRam(int32_t size, bool locked = false)
+        {
+            return Sound::AllocateSoundRam(size, locked);
+        }
+
+        static void ReleaseSoundRam(uint32_t address)
+        {
+            Sound::ReleaseSoundRam(address);
+        }
+
+        static constexpr int16_t CalculateLCM(int16_t a, int16_t b)
+        {
+            return Sound::CalculateLCM(a, b);
+        }
+
+        static constexpr int16_t CalculateGCD(int16_t a, int16_t b)
+        {
+            return Sound::CalculateGCD(a, b);
+        }
+
+        static constexpr int16_t CalculateBytesPerBlank(int32_t sampleRate, bool is8Bit, bool isPAL)
+        {
+            return Sound::CalculateBytesPerBlank(sampleRate, is8Bit, isPAL);
+        }
+
+        static constexpr int16_t ConvertBitrateToPitchWord(int32_t sampleRate)
+        {
+            return Sound::ConvertBitrateToPitchWord(sampleRate);
+        }
+
+        /** @brief Flag the driver raises once it played through a half of the ADX stream buffer
+         */
+        static volatile int8_t& AdxBufferPass(int32_t half)
+        {
+            return Sound::m68kCommands.adxBufferPass[half];
+        }
+
+        /** @brief Decode mono ADX file from the start of its data, the way SlaveAdxStream does
+         * @param file Whole ADX file
+         * @param blocks Number of blocks to decode
+         * @return 16 bit samples
+         */
+        static std::vector<int16_t> DecodeAdx(const std::vector<uint8_t>& file, int32_t blocks)
+        {
+            using Slave = Sound::SlaveAdxStream;
+
+            size_t dataStart = ((size_t)file[2] << 8 | file[3]) + 4;
+            int32_t sampleRate = (int32_t)((uint32_t)file[8] << 24 | (uint32_t)file[9] << 16 | (uint32_t)file[10] << 8 | file[11]);
+            int32_t cutoff = file[16] << 8 | file[17];
+
+            std::vector<int16_t> samples((size_t)blocks * Slave::BLOCK_SAMPLES);
+            Slave::Decoder state = Slave::CalculateCoefficients(sampleRate, cutoff);
+            Slave::DecodeBlocks(file.data() + dataStart, blocks, samples.data(), state);
+            return samples;
+        }
+
+        static const CTRL& Shadow(int16_t slot)
+        {
+            return Sound::ctrlShadow[slot];
+        }
+
+        static bool IsDirty(int16_t slot)
+        {
+            return Sound::ctrlDirty[slot] != 0;
+        }
+
+        static int16_t SlotCount()
+        {
+            return Sound::numberOfPCMs;
+        }
+
+        static const SoundRamBlock& Block(int16_t index)
+        {
+            return Sound::soundRamBlocks[index];
+        }
+
+        static int16_t BlockCount()
+        {
+            return Sound::soundRamBlockCount;
+        }
+
+        static uint32_t SampleAddress(int16_t slot)
+        {
+            return Sound::GetSampleAddress(slot);
+        }
+
+        /** @brief Sample data of a slot in the fake sound RAM
+         */
+        static const uint8_t* SampleData(int16_t slot)
+        {
+            return Host::SoundRam() + SampleAddress(slot);
+        }
+
+        /** @brief Sample size of a slot in bytes
+         */
+        static int32_t SampleBytes(int16_t slot)
+        {
+            const CTRL& ctrl = Shadow(slot);
+            return ctrl.bitDepth == Sound::PCM::TYPE_16BIT ? ctrl.playSize * 2 : ctrl.playSize;
+        }
+    };
+}
+
+/** @brief Read source file of a sample
+ */
+inline std::vector<uint8_t> ReadSfx(const char* name)
+{
+    return Host::ReadFile(std::string(PONESOUND_SFX_DATA) + "/" + name);
+}
+
+/** @brief Read file of the sample CD
+ */
+inline std::vector<uint8_t> ReadCdFile(const char* name)
+{
+    return Host::ReadFile(std::string(PONESOUND_SAMPLE_DATA) + "/" + name);
+}
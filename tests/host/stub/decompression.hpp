@@ -0,0 +1,7 @@
+#pragma once
+
+/*
+ * Stub of the decompression module for host builds, ponesound.hpp only imports its namespace.
+ */
+
+#include <srl.hpp>
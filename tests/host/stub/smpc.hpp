@@ -0,0 +1,18 @@
+#pragma once
+
+/*
+ * Stub of the SMPC module for host builds, see srl.hpp.
+ */
+
+#include <srl.hpp>
+
+namespace SRL::SMPC
+{
+    /** @brief Hold the sound CPU in reset
+     */
+    void DisableSoundCPU();
+
+    /** @brief Let the sound CPU run, calls Host::onSoundCpuStart
+     */
+    void EnableSoundCPU();
+}
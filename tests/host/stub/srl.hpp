@@ -0,0 +1,248 @@
+#pragma once
+
+/*
+ * Stub of the parts of SRL, SGL and the CD block library ponesound.hpp uses, for building it on a Linux host.
+ *
+ * Sound RAM is a fake block of memory mapped at the address the Saturn has it at, so the library keeps using its
+ * absolute addresses. DMA is a plain copy, GFS reads come from host files or from buffers the test adds, and the slave
+ * SH-2 runs its function right away. The Host namespace at the bottom drives it.
+ */
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+using Sint8 = signed char;
+using Uint8 = unsigned char;
+using Sint16 = int16_t;
+using Uint16 = uint16_t;
+using Sint32 = int32_t;
+using Uint32 = uint32_t;
+
+// SGL DMA
+
+/** @brief Source fixed, destination increments, long word transfers (slDMAXCopy mode)
+ */
+constexpr Uint16 Sfix_Dinc_Long = 0x0142;
+
+void slDMACopy(void* source, void* destination, Uint32 size);
+void slDMAXCopy(void* source, void* destination, Uint32 count, Uint16 mode);
+void slDMAWait();
+void slSlaveFunc(void (*function)(void*), void* argument);
+
+// GFS
+
+struct HostGfsFile;
+using GfsHandle = HostGfsFile*;
+
+constexpr Sint32 GFS_SEEK_SET = 0;
+
+Sint32 GFS_NameToId(Sint8* name);
+GfsHandle GFS_Open(Sint32 fileId);
+void GFS_Close(GfsHandle handle);
+Sint32 GFS_Seek(GfsHandle handle, Sint32 offset, Sint32 origin);
+void GFS_GetFileSize(GfsHandle handle, Sint32* sectorSize, Sint32* sectors, Sint32* lastSize);
+Sint32 GFS_Fread(GfsHandle handle, Sint32 sectors, void* buffer, Sint32 size);
+Sint32 GFS_NwFread(GfsHandle handle, Sint32 sectors, void* buffer, Sint32 size);
+Sint32 GFS_NwCdRead(GfsHandle handle, Sint32 sectors);
+Sint32 GFS_NwExecOne(GfsHandle handle);
+Sint32 GFS_NwIsComplete(GfsHandle handle);
+Sint32 GFS_NwStop(GfsHandle handle);
+
+// CD block
+
+struct CdcPly
+{
+    Uint8 startType;
+    Sint32 startValue;
+    Uint8 startIndex;
+    Uint8 endType;
+    Sint32 endValue;
+    Uint8 endIndex;
+    Uint8 mode;
+};
+
+struct CdcPos
+{
+    Uint8 ptype;
+};
+
+struct CdcStat
+{
+    Uint8 status;
+    Uint8 track;
+    Uint8 index;
+    Sint32 fad;
+};
+
+constexpr Uint8 CDC_PTYPE_DFL = 0x00;
+constexpr Uint8 CDC_PTYPE_FAD = 0x01;
+constexpr Uint8 CDC_PTYPE_TNO = 0x02;
+constexpr Uint8 CDC_PTYPE_NOCHG = 0xFF;
+constexpr Uint8 CDC_PM_DFL = 0x00;
+constexpr Uint8 CDC_PM_PIC_NOCHG = 0x80;
+
+constexpr Uint8 CDC_ST_BUSY = 0x00;
+constexpr Uint8 CDC_ST_PAUSE = 0x01;
+constexpr Uint8 CDC_ST_STANDBY = 0x02;
+constexpr Uint8 CDC_ST_PLAY = 0x03;
+constexpr Uint8 CDC_ST_SEEK = 0x04;
+constexpr Uint8 CDC_ST_SCAN = 0x05;
+constexpr Uint8 CDC_ST_OPEN = 0x06;
+constexpr Uint8 CDC_ST_NODISC = 0x07;
+
+#define CDC_PLY_STYPE(ply) ((ply)->startType)
+#define CDC_PLY_SFAD(ply) ((ply)->startValue)
+#define CDC_PLY_STNO(ply) ((ply)->startValue)
+#define CDC_PLY_SIDX(ply) ((ply)->startIndex)
+#define CDC_PLY_ETYPE(ply) ((ply)->endType)
+#define CDC_PLY_ETNO(ply) ((ply)->endValue)
+#define CDC_PLY_EIDX(ply) ((ply)->endIndex)
+#define CDC_PLY_PMODE(ply) ((ply)->mode)
+
+#define CDC_STAT_STATUS(stat) ((stat)->status)
+#define CDC_STAT_FAD(stat) ((stat)->fad)
+#define CDC_STAT_TNO(stat) ((stat)->track)
+#define CDC_STAT_IDX(stat) ((stat)->index)
+
+Sint32 CDC_CdPlay(CdcPly* ply);
+Sint32 CDC_CdSeek(CdcPos* position);
+Sint32 CDC_GetPeriStat(CdcStat* status);
+
+namespace SRL
+{
+    namespace Math::Types
+    {
+        /** @brief 16.16 fixed point number
+         */
+        class Fxp
+        {
+            int32_t value = 0;
+
+        public:
+            constexpr Fxp() = default;
+            constexpr Fxp(int32_t whole) : value(whole << 16) {}
+
+            static constexpr Fxp BuildRaw(int32_t raw)
+            {
+                Fxp result;
+                result.value = raw;
+                return result;
+            }
+
+            constexpr int32_t RawValue() const
+            {
+                return this->value;
+            }
+        };
+
+        /** @brief Point in 3D space
+         */
+        struct Vector3D
+        {
+            Fxp X;
+            Fxp Y;
+            Fxp Z;
+        };
+    }
+
+    namespace Decompression
+    {
+    }
+
+    namespace Core
+    {
+        /** @brief Handlers called on every vertical blank
+         */
+        struct VblankEvent
+        {
+            std::vector<void (*)()> handlers;
+
+            /** @brief Add handler, a handler that is already there is not added again
+             */
+            VblankEvent& operator+=(void (*handler)());
+        };
+
+        extern VblankEvent OnVblank;
+    }
+
+    namespace Debug
+    {
+        void Print(uint16_t column, uint16_t row, const char* format, ...);
+    }
+}
+
+/** @brief Control of the fake hardware
+ */
+namespace Host
+{
+    /** @brief Start of the fake sound RAM (0x25A00000)
+     */
+    uint8_t* SoundRam();
+
+    /** @brief Forget all files and open handles, clear sound RAM and the counters
+     */
+    void Reset();
+
+    /** @brief Add every file of a host directory, under its upper case name
+     */
+    void Mount(const std::string& directory);
+
+    /** @brief Add file held in memory, replacing one of the same name
+     */
+    void AddFile(const std::string& name, const std::vector<uint8_t>& data);
+
+    /** @brief Read whole host file
+     */
+    std::vector<uint8_t> ReadFile(const std::string& path);
+
+    /** @brief Run vblank handlers once
+     */
+    void Vblank();
+
+    /** @brief Number of GFS_NwExecOne() calls a non-blocking read takes to complete
+     */
+    extern int readLatency;
+
+    /** @brief Most GFS handles open at the same time (0 for no limit), like SRL_MAX_CD_BACKGROUND_JOBS
+     */
+    extern int maxOpenHandles;
+
+    /** @brief Number of GFS handles open now
+     */
+    extern int openHandles;
+
+    /** @brief Most GFS handles that were open at the same time
+     */
+    extern int peakOpenHandles;
+
+    /** @brief Number of GFS calls made from inside a vblank handler
+     */
+    extern int gfsCallsInVblank;
+
+    /** @brief Set while vblank handlers run
+     */
+    extern bool inVblank;
+
+    /** @brief Called when the sound CPU is started, the fake driver publishes its control table here
+     */
+    extern std::function<void()> onSoundCpuStart;
+
+    /** @brief Called after the vblank handlers ran, the fake driver plays a frame here
+     */
+    extern std::function<void()> onDriverFrame;
+
+    /** @brief Called before slDMACopy() moves data
+     */
+    extern std::function<void(const void*, void*, uint32_t)> onDmaCopy;
+
+    /** @brief Drive status returned by CDC_GetPeriStat()
+     */
+    extern CdcStat cdStatus;
+}
+
+/** @brief No vblank interrupt on the host, so waits of ponesound.hpp for the vblank hook run it themselves
+ */
+#define PONESOUND_WAIT_FRAME() Host::Vblank()
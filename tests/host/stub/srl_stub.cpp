@@ -0,0 +1,403 @@
+#include <srl.hpp>
+#include <smpc.hpp>
+
+#include <sys/mman.h>
+#include <dirent.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+    constexpr uintptr_t SOUND_RAM_ADDRESS = 0x25A00000;
+    constexpr size_t SOUND_RAM_MAPPING = 0x101000;
+    constexpr uintptr_t ON_CHIP_ADDRESS = 0xFFFFF000;
+    constexpr size_t ON_CHIP_MAPPING = 0x1000;
+    constexpr int32_t SECTOR_SIZE = 2048;
+
+    /** @brief Map memory at a fixed address, the library reaches hardware through absolute addresses
+     */
+    void MapFixed(uintptr_t address, size_t size)
+    {
+        void* mapped = mmap((void*)address, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+        if (mapped != (void*)address)
+        {
+            std::fprintf(stderr, "srl stub: cannot map 0x%lx\n", (unsigned long)address);
+            std::abort();
+        }
+    }
+
+    /** @brief Sound RAM, the SCSP registers behind it and the SH-2 free running timer exist before any static is touched
+     */
+    __attribute__((constructor)) void MapHardware()
+    {
+        MapFixed(SOUND_RAM_ADDRESS, SOUND_RAM_MAPPING);
+        MapFixed(ON_CHIP_ADDRESS, ON_CHIP_MAPPING);
+    }
+
+    struct HostFile
+    {
+        std::string name;
+        std::vector<uint8_t> data;
+    };
+
+    std::vector<HostFile> files;
+
+    /** @brief Count GFS call, the library must not make them from the vblank
+     */
+    void CheckContext()
+    {
+        if (Host::inVblank)
+        {
+            Host::gfsCallsInVblank++;
+        }
+    }
+
+    std::string UpperCase(std::string name)
+    {
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return (char)std::toupper(c); });
+        return name;
+    }
+}
+
+/** @brief Open GFS file
+ */
+struct HostGfsFile
+{
+    int32_t fileId;
+    int32_t sector;
+    uint8_t* target;
+    int32_t sectors;
+    int32_t size;
+    int32_t latency;
+    bool pending;
+
+    /** @brief Copy sectors at the current position, the last sector of the file only has the bytes that are in the file
+     */
+    void Transfer(void* buffer, int32_t count, int32_t limit)
+    {
+        const std::vector<uint8_t>& data = files[this->fileId].data;
+        int64_t start = (int64_t)this->sector * SECTOR_SIZE;
+        int64_t bytes = std::min<int64_t>((int64_t)count * SECTOR_SIZE, limit);
+        bytes = std::min<int64_t>(bytes, (int64_t)data.size() - start);
+
+        if (bytes > 0)
+        {
+            std::memcpy(buffer, data.data() + start, (size_t)bytes);
+        }
+
+        this->sector += count;
+    }
+};
+
+namespace
+{
+    std::vector<std::unique_ptr<HostGfsFile>> handles;
+}
+
+void slDMACopy(void* source, void* destination, Uint32 size)
+{
+    if (Host::onDmaCopy) Host::onDmaCopy(source, destination, size);
+    std::memmove(destination, source, size);
+}
+
+void slDMAXCopy(void* source, void* destination, Uint32 count, Uint16 mode)
+{
+    uint32_t* target = (uint32_t*)destination;
+    const uint32_t* from = (const uint32_t*)source;
+
+    for (Uint32 i = 0; i < count; i++)
+    {
+        target[i] = mode == Sfix_Dinc_Long ? from[0] : from[i];
+    }
+}
+
+void slDMAWait()
+{
+}
+
+void slSlaveFunc(void (*function)(void*), void* argument)
+{
+    function(argument);
+}
+
+Sint32 GFS_NameToId(Sint8* name)
+{
+    CheckContext();
+    std::string wanted = UpperCase((const char*)name);
+
+    for (size_t id = 0; id < files.size(); id++)
+    {
+        if (files[id].name == wanted) return (Sint32)id;
+    }
+
+    return -1;
+}
+
+GfsHandle GFS_Open(Sint32 fileId)
+{
+    CheckContext();
+    if (fileId < 0 || fileId >= (Sint32)files.size()) return nullptr;
+    if (Host::maxOpenHandles > 0 && Host::openHandles >= Host::maxOpenHandles) return nullptr;
+
+    handles.push_back(std::make_unique<HostGfsFile>(HostGfsFile{ fileId, 0, nullptr, 0, 0, 0, false }));
+    Host::openHandles++;
+    Host::peakOpenHandles = std::max(Host::peakOpenHandles, Host::openHandles);
+    return handles.back().get();
+}
+
+void GFS_Close(GfsHandle handle)
+{
+    CheckContext();
+
+    for (auto it = handles.begin(); it != handles.end(); ++it)
+    {
+        if (it->get() == handle)
+        {
+            handles.erase(it);
+            Host::openHandles--;
+            return;
+        }
+    }
+
+    std::fprintf(stderr, "srl stub: GFS_Close of a handle that is not open\n");
+    std::abort();
+}
+
+Sint32 GFS_Seek(GfsHandle handle, Sint32 offset, Sint32 origin)
+{
+    CheckContext();
+    handle->sector = origin == GFS_SEEK_SET ? offset : handle->sector + offset;
+    return handle->sector;
+}
+
+void GFS_GetFileSize(GfsHandle handle, Sint32* sectorSize, Sint32* sectors, Sint32* lastSize)
+{
+    CheckContext();
+    int32_t bytes = (int32_t)files[handle->fileId].data.size();
+    int32_t count = (bytes + SECTOR_SIZE - 1) / SECTOR_SIZE;
+
+    if (sectorSize != nullptr) *sectorSize = SECTOR_SIZE;
+    if (sectors != nullptr) *sectors = count;
+    if (lastSize != nullptr) *lastSize = count > 0 ? bytes - ((count - 1) * SECTOR_SIZE) : 0;
+}
+
+Sint32 GFS_Fread(GfsHandle handle, Sint32 sectors, void* buffer, Sint32 size)
+{
+    CheckContext();
+    handle->Transfer(buffer, sectors, size);
+    return size;
+}
+
+Sint32 GFS_NwFread(GfsHandle handle, Sint32 sectors, void* buffer, Sint32 size)
+{
+    CheckContext();
+    handle->target = (uint8_t*)buffer;
+    handle->sectors = sectors;
+    handle->size = size;
+    handle->latency = Host::readLatency;
+    handle->pending = true;
+    return 0;
+}
+
+Sint32 GFS_NwCdRead(GfsHandle handle, Sint32 sectors)
+{
+    CheckContext();
+    (void)handle;
+    (void)sectors;
+    return 0;
+}
+
+Sint32 GFS_NwExecOne(GfsHandle handle)
+{
+    CheckContext();
+
+    if (handle->pending && --handle->latency <= 0)
+    {
+        handle->Transfer(handle->target, handle->sectors, handle->size);
+        handle->pending = false;
+    }
+
+    return 0;
+}
+
+Sint32 GFS_NwIsComplete(GfsHandle handle)
+{
+    CheckContext();
+    return handle->pending ? 0 : 1;
+}
+
+Sint32 GFS_NwStop(GfsHandle handle)
+{
+    CheckContext();
+    handle->pending = false;
+    return 0;
+}
+
+Sint32 CDC_CdPlay(CdcPly* ply)
+{
+    Host::cdStatus.status = CDC_ST_PLAY;
+    Host::cdStatus.track = (Uint8)(ply->startType == CDC_PTYPE_TNO ? ply->startValue : Host::cdStatus.track);
+    return 0;
+}
+
+Sint32 CDC_CdSeek(CdcPos* position)
+{
+    Host::cdStatus.status = position->ptype == CDC_PTYPE_NOCHG ? CDC_ST_PAUSE : CDC_ST_STANDBY;
+    return 0;
+}
+
+Sint32 CDC_GetPeriStat(CdcStat* status)
+{
+    *status = Host::cdStatus;
+    return 0;
+}
+
+namespace SRL
+{
+    Core::VblankEvent Core::OnVblank;
+
+    Core::VblankEvent& Core::VblankEvent::operator+=(void (*handler)())
+    {
+        if (std::find(this->handlers.begin(), this->handlers.end(), handler) == this->handlers.end())
+        {
+            this->handlers.push_back(handler);
+        }
+
+        return *this;
+    }
+
+    void Debug::Print(uint16_t column, uint16_t row, const char* format, ...)
+    {
+        // Formatted so bad arguments still show up under the sanitizers, the text goes nowhere
+        char text[256];
+        va_list arguments;
+        va_start(arguments, format);
+        std::vsnprintf(text, sizeof(text), format, arguments);
+        va_end(arguments);
+        (void)column;
+        (void)row;
+    }
+
+    void SMPC::DisableSoundCPU()
+    {
+    }
+
+    void SMPC::EnableSoundCPU()
+    {
+        if (Host::onSoundCpuStart) Host::onSoundCpuStart();
+    }
+}
+
+namespace Host
+{
+    int readLatency = 1;
+    int maxOpenHandles = 0;
+    int openHandles = 0;
+    int peakOpenHandles = 0;
+    int gfsCallsInVblank = 0;
+    bool inVblank = false;
+    std::function<void()> onSoundCpuStart;
+    std::function<void()> onDriverFrame;
+    std::function<void(const void*, void*, uint32_t)> onDmaCopy;
+    CdcStat cdStatus = { CDC_ST_STANDBY, 0, 0, 0 };
+
+    uint8_t* SoundRam()
+    {
+        return (uint8_t*)SOUND_RAM_ADDRESS;
+    }
+
+    void Reset()
+    {
+        if (!handles.empty())
+        {
+            std::fprintf(stderr, "srl stub: %d GFS handles left open\n", (int)handles.size());
+            std::abort();
+        }
+
+        files.clear();
+        std::memset(SoundRam(), 0, SOUND_RAM_MAPPING);
+        std::memset((void*)ON_CHIP_ADDRESS, 0, ON_CHIP_MAPPING);
+        readLatency = 1;
+        maxOpenHandles = 0;
+        openHandles = 0;
+        peakOpenHandles = 0;
+        gfsCallsInVblank = 0;
+        inVblank = false;
+        onDriverFrame = nullptr;
+        onDmaCopy = nullptr;
+        cdStatus = CdcStat{ CDC_ST_STANDBY, 0, 0, 0 };
+    }
+
+    std::vector<uint8_t> ReadFile(const std::string& path)
+    {
+        std::vector<uint8_t> data;
+        FILE* file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr) return data;
+
+        uint8_t chunk[4096];
+        size_t read;
+
+        while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+        {
+            data.insert(data.end(), chunk, chunk + read);
+        }
+
+        std::fclose(file);
+        return data;
+    }
+
+    void Mount(const std::string& directory)
+    {
+        DIR* dir = opendir(directory.c_str());
+
+        if (dir == nullptr)
+        {
+            std::fprintf(stderr, "srl stub: cannot open %s\n", directory.c_str());
+            std::abort();
+        }
+
+        while (dirent* entry = readdir(dir))
+        {
+            if (entry->d_name[0] == '.') continue;
+            AddFile(entry->d_name, ReadFile(directory + "/" + entry->d_name));
+        }
+
+        closedir(dir);
+    }
+
+    void AddFile(const std::string& name, const std::vector<uint8_t>& data)
+    {
+        std::string key = UpperCase(name);
+
+        for (HostFile& file : files)
+        {
+            if (file.name == key)
+            {
+                file.data = data;
+                return;
+            }
+        }
+
+        files.push_back(HostFile{ key, data });
+    }
+
+    void Vblank()
+    {
+        inVblank = true;
+
+        for (void (*handler)() : SRL::Core::OnVblank.handlers)
+        {
+            handler();
+        }
+
+        inVblank = false;
+        if (onDriverFrame) onDriverFrame();
+    }
+}
@@ -0,0 +1,1185 @@
+/*
+ * Unit tests of ponesound.hpp on the host. Run without arguments for every test, or with test names to run some.
+ */
+
+#include "host_access.hpp"
+
+#include <banks/ANOTHER_SND.hpp>
+#include <banks/CAT_SND.hpp>
+
+#include <algorithm>
+
+using namespace SRL::Ponesound;
+
+namespace
+{
+    struct TestCase
+    {
+        const char* name;
+        void (*function)();
+    };
+
+    std::vector<TestCase>& Tests()
+    {
+        static std::vector<TestCase> tests;
+        return tests;
+    }
+
+    int failures = 0;
+
+    struct Registrar
+    {
+        Registrar(const char* name, void (*function)())
+        {
+            Tests().push_back(TestCase{ name, function });
+        }
+    };
+}
+
+#define TEST(name) \
+    static void name(); \
+    static Registrar name##Registrar(#name, name); \
+    static void name()
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } \
+    while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do \
+    { \
+        long long actualValue = (long long)(actual); \
+        long long expectedValue = (long long)(expected); \
+        if (actualValue != expectedValue) \
+        { \
+            std::fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, actualValue, expectedValue); \
+            failures++; \
+        } \
+    } \
+    while (0)
+
+namespace
+{
+    /** @brief PCM source files of CAT.SND in file order
+     */
+    constexpr const char* CAT_FILES[] = {
+        "MEOW1.PCM", "MEOW5.PCM", "MEOW2.PCM", "MEOW6.PCM", "MEOW3.PCM", "MEOW7.PCM", "MEOW4.PCM", "MEOW8.PCM", "MEOW9.PCM"
+    };
+
+    constexpr int16_t CAT_COUNT = sizeof(CAT_FILES) / sizeof(CAT_FILES[0]);
+
+    /** @brief Check that slots play exactly the source PCM files of CAT.SND
+     * @param sounds Slot of each entry, in file order
+     */
+    void CheckCatSamples(const int16_t* sounds)
+    {
+        for (int16_t i = 0; i < CAT_COUNT; i++)
+        {
+            std::vector<uint8_t> source = ReadSfx(CAT_FILES[i]);
+            CHECK(!source.empty());
+            CHECK_EQ(HostAccess::SampleBytes(sounds[i]), source.size());
+            CHECK(std::memcmp(HostAccess::SampleData(sounds[i]), source.data(), source.size()) == 0);
+            CHECK_EQ(HostAccess::Shadow(sounds[i]).pitchWord, 0x7192);
+            CHECK_EQ(HostAccess::Shadow(sounds[i]).bytesPerBlank, 256);
+        }
+    }
+
+    /** @brief Bytes CAT.SND takes in sound RAM, each entry rounded up to 4 bytes
+     */
+    int32_t CatSoundRam(int16_t count = CAT_COUNT)
+    {
+        int32_t total = 0;
+
+        for (int16_t i = 0; i < count; i++)
+        {
+            total += (int32_t)((ReadSfx(CAT_FILES[i]).size() + 3) & ~3);
+        }
+
+        return total;
+    }
+
+    /** @brief Check allocator bookkeeping: blocks sorted, inside the work area, not overlapping, owned by loaded slots
+     */
+    void CheckBlocks()
+    {
+        uint32_t end = HostAccess::WORK_START;
+
+        for (int16_t block = 0; block < HostAccess::BlockCount(); block++)
+        {
+            const HostAccess::SoundRamBlock& current = HostAccess::Block(block);
+            CHECK(current.address >= end);
+            CHECK(current.size > 0 && (current.size & 3) == 0);
+            CHECK(current.sound < HostAccess::SlotCount());
+            end = current.address + current.size;
+        }
+
+        CHECK(end <= HostAccess::WORK_END);
+        CHECK_EQ(Sound::SoundRam::GetFreeSpace() + Sound::SoundRam::GetUsedSpace(), Sound::SoundRam::GetSize());
+    }
+}
+
+TEST(CalculateLCMAndGCD)
+{
+    static_assert(HostAccess::CalculateGCD(12, 18) == 6);
+    static_assert(HostAccess::CalculateLCM(4, 6) == 12);
+
+    CHECK_EQ(HostAccess::CalculateGCD(7, 1), 1);
+    CHECK_EQ(HostAccess::CalculateLCM(7, 1), 7);
+    CHECK_EQ(HostAccess::CalculateLCM(256, 256), 256);
+    CHECK_EQ(HostAccess::CalculateLCM(256, 320), 1280);
+    CHECK_EQ(HostAccess::CalculateLCM(384, 448), 2688);
+    CHECK_EQ(HostAccess::CalculateLCM(512, 576), 4608);
+    CHECK_EQ(HostAccess::CalculateLCM(768, 832), 9984);
+
+    // Every dictionary RegisterAdx() builds fits its 16 bit field
+    for (int16_t bytesPerBlank : { 256, 384, 512, 768 })
+    {
+        CHECK((HostAccess::CalculateLCM(bytesPerBlank, bytesPerBlank + 64) << 1) < 0x10000);
+    }
+}
+
+TEST(PitchAndBytesPerBlank)
+{
+    CHECK_EQ(HostAccess::ConvertBitrateToPitchWord(44100), 0);
+    CHECK_EQ(HostAccess::ConvertBitrateToPitchWord(15360), 0x7192);
+    CHECK_EQ(HostAccess::CalculateBytesPerBlank(15360, true, false), 256);
+    CHECK_EQ(HostAccess::CalculateBytesPerBlank(15360, false, false), 512);
+    CHECK_EQ(HostAccess::CalculateBytesPerBlank(15360, true, true), 307);
+    CHECK_EQ(HostAccess::CalculateBytesPerBlank(44100, false, false), 1470);
+}
+
+TEST(DriverBoot)
+{
+    CHECK(HostAccess::Boot());
+    CHECK(Sound::Stats::GetBoot().ready);
+    CHECK_EQ(Sound::Stats::GetBoot().driverBytes, Host::ReadFile(PONESOUND_DRIVER_DATA "/SDRV.BIN").size());
+    CHECK_EQ(HostAccess::SlotCount(), 0);
+    CHECK_EQ(HostAccess::BlockCount(), 0);
+    CHECK_EQ(Host::openHandles, 0);
+}
+
+TEST(RegisterPcm)
+{
+    HostAccess::Boot();
+
+    uint32_t address8 = HostAccess::AllocateSoundRam(3315);
+    int16_t sound8 = HostAccess::RegisterPcm(address8, 3315, BitDepth::PCM8, 15360);
+    uint32_t address16 = HostAccess::AllocateSoundRam(19522);
+    int16_t sound16 = HostAccess::RegisterPcm(address16, 19522, BitDepth::PCM16, 22050);
+
+    CHECK_EQ(address8, HostAccess::WORK_START);
+    CHECK_EQ(address16, HostAccess::WORK_START + 3316);
+    CHECK_EQ(sound8, 0);
+    CHECK_EQ(sound16, 1);
+    CHECK_EQ(HostAccess::SlotCount(), 2);
+
+    const HostAccess::CTRL& ctrl8 = HostAccess::Shadow(sound8);
+    CHECK_EQ(ctrl8.hiAddrBits, address8 >> 16);
+    CHECK_EQ(ctrl8.loAddrBits, address8 & 0xFFFF);
+    CHECK_EQ(ctrl8.pitchWord, 0x7192);
+    CHECK_EQ(ctrl8.bytesPerBlank, 256);
+    CHECK_EQ(ctrl8.playSize, 3315);
+    CHECK_EQ(ctrl8.bitDepth, 1);
+    CHECK_EQ(ctrl8.volume, 7);
+    CHECK_EQ(ctrl8.sh2Permit, 0);
+
+    const HostAccess::CTRL& ctrl16 = HostAccess::Shadow(sound16);
+    CHECK_EQ(HostAccess::SampleAddress(sound16), address16);
+    CHECK_EQ(ctrl16.pitchWord, 0x7800);
+    CHECK_EQ(ctrl16.bytesPerBlank, 735);
+    CHECK_EQ(ctrl16.playSize, 19522 / 2);
+    CHECK_EQ(ctrl16.bitDepth, 0);
+
+    CHECK_EQ(HostAccess::Block(0).sound, sound8);
+    CHECK_EQ(HostAccess::Block(1).sound, sound16);
+
+    // Registration only fills the shadow, the next vblank sends it to the driver
+    CHECK(HostAccess::IsDirty(sound8) && HostAccess::IsDirty(sound16));
+    Host::Vblank();
+    CHECK(!HostAccess::IsDirty(sound8) && !HostAccess::IsDirty(sound16));
+    CHECK(std::memcmp(&HostAccess::DriverTable()[sound8], &ctrl8, sizeof(HostAccess::CTRL)) == 0);
+    CHECK(std::memcmp(&HostAccess::DriverTable()[sound16], &ctrl16, sizeof(HostAccess::CTRL)) == 0);
+    CheckBlocks();
+}
+
+TEST(PushShadowSkipsCleanSlots)
+{
+    HostAccess::Boot();
+
+    int16_t sounds[CAT_COUNT];
+    Sound::Pcm::LoadSound("CAT.SND", sounds, CAT_COUNT);
+    Host::Vblank();
+    Sound::Pcm::Play(1);
+    Host::Vblank();
+    CHECK(HostAccess::DriverTable()[1].sh2Permit != 0);
+
+    // Driver stops slot 1 after it was read back, while slots around it get pushed
+    Sound::Pcm::Play(0);
+    Sound::Pcm::Play(2);
+    Host::onDmaCopy = [](const void*, void* destination, uint32_t) {
+        if (destination >= (void*)HostAccess::DriverTable() && destination < (void*)(HostAccess::DriverTable() + HostAccess::CTRL_MAX))
+        {
+            HostAccess::DriverTable()[1].sh2Permit = 0;
+        }
+    };
+
+    Host::Vblank();
+    Host::onDmaCopy = nullptr;
+    CHECK_EQ(HostAccess::DriverTable()[1].sh2Permit, 0);
+    CHECK(HostAccess::DriverTable()[0].sh2Permit != 0);
+    CHECK(HostAccess::DriverTable()[2].sh2Permit != 0);
+    CHECK_EQ(Sound::GetCommandWrites(), 2);
+
+    Sound::Pcm::Unload(-1);
+}
+
+TEST(VoiceInstances)
+{
+    HostAccess::Boot();
+
+    int16_t sounds[CAT_COUNT];
+    CHECK_EQ(Sound::Pcm::LoadSound("CAT.SND", sounds, CAT_COUNT), CAT_COUNT - 1);
+
+    // First instance plays on the sound's own slot, the others on free slots pointed at the same data
+    int16_t handles[Sound::Voice::DEFAULT_INSTANCES];
+
+    for (int16_t i = 0; i < Sound::Voice::DEFAULT_INSTANCES; i++)
+    {
+        handles[i] = Sound::Pcm::Play(sounds[0], PlayMode::ForwardLoop);
+        CHECK(Sound::Voice::IsActive(handles[i]));
+        Host::Vblank();
+    }
+
+    int16_t ownSlot = handles[0] & 0x7F;
+    CHECK_EQ(ownSlot, sounds[0]);
+    CHECK_EQ(HostAccess::SlotCount(), CAT_COUNT + Sound::Voice::DEFAULT_INSTANCES - 1);
+    CHECK_EQ(Sound::Voice::GetInstanceCount(sounds[0]), Sound::Voice::DEFAULT_INSTANCES);
+
+    for (int16_t i = 1; i < Sound::Voice::DEFAULT_INSTANCES; i++)
+    {
+        int16_t slot = handles[i] & 0x7F;
+        CHECK_EQ(slot, CAT_COUNT + i - 1);
+        CHECK_EQ(HostAccess::SampleAddress(slot), HostAccess::SampleAddress(sounds[0]));
+        CHECK_EQ(HostAccess::Shadow(slot).playSize, HostAccess::Shadow(sounds[0]).playSize);
+        CHECK(HostAccess::DriverTable()[slot].sh2Permit != 0);
+    }
+
+    // At the instance limit the oldest instance of the sound gives up its slot
+    int16_t stolen = Sound::Pcm::Play(sounds[0], PlayMode::ForwardLoop);
+    CHECK_EQ(stolen & 0x7F, ownSlot);
+    CHECK(!Sound::Voice::IsActive(handles[0]));
+    CHECK(Sound::Voice::IsActive(stolen));
+    CHECK_EQ(Sound::Voice::GetInstanceCount(sounds[0]), Sound::Voice::DEFAULT_INSTANCES);
+
+    // A stopped instance is released, its slot goes to the next instance of any sound
+    Sound::Pcm::Stop(handles[1]);
+    CHECK(!Sound::Voice::IsActive(handles[1]));
+    int16_t other = Sound::Pcm::Play(sounds[1]);
+    CHECK_EQ(other & 0x7F, sounds[1]);
+    int16_t clone = Sound::Pcm::Play(sounds[1]);
+    CHECK_EQ(clone & 0x7F, handles[1] & 0x7F);
+    CHECK_EQ(HostAccess::SampleAddress(clone & 0x7F), HostAccess::SampleAddress(sounds[1]));
+
+    Sound::Pcm::Stop(sounds[0]);
+    CHECK_EQ(Sound::Voice::GetInstanceCount(sounds[0]), 0);
+    CHECK_EQ(Sound::Voice::GetInstanceCount(sounds[1]), 2);
+
+    Sound::Pcm::Unload(-1);
+    Host::Vblank();
+}
+
+TEST(VoicePriority)
+{
+    HostAccess::Boot();
+
+    int16_t sounds[CAT_COUNT];
+    CHECK_EQ(Sound::Pcm::LoadSound("CAT.SND", sounds, CAT_COUNT), CAT_COUNT - 1);
+
+    // With one instance allowed, a lower priority cannot take the voice, the same or a higher one can
+    Sound::Pcm::SetMaxInstances(sounds[0], 1);
+    int16_t high = Sound::Pcm::Play(sounds[0], PlayMode::ForwardLoop, 7, 200);
+    CHECK(Sound::Voice::IsActive(high));
+    CHECK(Sound::Pcm::Play(sounds[0], PlayMode::ForwardLoop, 7, 100) < 0);
+    CHECK(Sound::Voice::IsActive(high));
+
+    int16_t same = Sound::Pcm::Play(sounds[0], PlayMode::ForwardLoop, 7, 200);
+    CHECK(same >= 0);
+    CHECK(!Sound::Voice::IsActive(high));
+    CHECK_EQ(Sound::Voice::GetInstanceCount(sounds[0]), 1);
+
+    // At the voice limit the lowest priority voice is stopped, whichever sound it plays
+    Sound::Voice::SetLimit(3);
+    int16_t low = Sound::Pcm::Play(sounds[1], PlayMode::ForwardLoop, 7, 50);
+    int16_t normal = Sound::Pcm::Play(sounds[2], PlayMode::ForwardLoop);
+    CHECK_EQ(Sound::Voice::GetActiveCount(), 3);
+
+    CHECK(Sound::Pcm::Play(sounds[3], PlayMode::ForwardLoop, 7, 10) < 0);
+    CHECK_EQ(HostAccess::SlotCount(), CAT_COUNT);
+
+    int16_t urgent = Sound::Pcm::Play(sounds[3], PlayMode::ForwardLoop, 7, 255);
+    CHECK(Sound::Voice::IsActive(urgent));
+    CHECK(!Sound::Voice::IsActive(low));
+    CHECK(Sound::Voice::IsActive(normal));
+    CHECK(Sound::Voice::IsActive(same));
+    CHECK_EQ(Sound::Voice::GetActiveCount(), 3);
+
+    Sound::Voice::SetLimit(Sound::Voice::HARDWARE_VOICES);
+    Sound::Pcm::Unload(-1);
+    Host::Vblank();
+}
+
+TEST(VoiceStealing)
+{
+    for (StealMode mode : { StealMode::Oldest, StealMode::Quietest })
+    {
+        HostAccess::Boot();
+
+        int16_t sounds[CAT_COUNT];
+        CHECK_EQ(Sound::Pcm::LoadSound("CAT.SND", sounds, CAT_COUNT), CAT_COUNT - 1);
+        Sound::Voice::SetLimit(3);
+        Sound::Voice::SetStealMode(mode);
+
+        // Started a frame apart, the oldest is the loudest and the two quietest are equally quiet
+        int16_t first = Sound::Pcm::Play(sounds[0], PlayMode::ForwardLoop, 7);
+        Host::Vblank();
+        int16_t second = Sound::Pcm::Play(sounds[1], PlayMode::ForwardLoop, 3);
+        Host::Vblank();
+        int16_t third = Sound::Pcm::Play(sounds[2], PlayMode::ForwardLoop, 3);
+        Host::Vblank();
+
+        int16_t next = Sound::Pcm::Play(sounds[3], PlayMode::ForwardLoop);
+        CHECK(Sound::Voice::IsActive(next));
+        CHECK_EQ(Sound::Voice::IsActive(first), mode != StealMode::Oldest);
+        CHECK_EQ(Sound::Voice::IsActive(second), mode != StealMode::Quietest);
+        CHECK(Sound::Voice::IsActive(third));
+
+        Sound::Voice::SetStealMode(StealMode::Oldest);
+        Sound::Voice::SetLimit(Sound::Voice::HARDWARE_VOICES);
+        Sound::Pcm::Unload(-1);
+        Host::Vblank();
+    }
+}
+
+TEST(VoiceHandleGenerationWraps)
+{
+    HostAccess::Boot();
+
+    int16_t sounds[CAT_COUNT];
+    CHECK_EQ(Sound::Pcm::LoadSound("CAT.SND", sounds, CAT_COUNT), CAT_COUNT - 1);
+
+    // Generation runs from 1 to 255 and back to 1, so a handle is never a plain sound index. 510 starts wrap it
+    // twice, wherever it was left by earlier tests.
+    int16_t previous = Sound::Pcm::Play(sounds[0]);
+    Sound::Pcm::Stop(previous);
+    int32_t wraps = 0;
+
+    for (int32_t start = 0; start < 2 * 255; start++)
+    {
+        int16_t handle = Sound::Pcm::Play(sounds[0]);
+        int32_t generation = handle >> 7;
+
+        CHECK(generation >= 1 && generation <= 255);
+        CHECK_EQ(handle & 0x7F, sounds[0]);
+        CHECK(Sound::Voice::IsActive(handle));
+        CHECK(!Sound::Voice::IsActive(previous));
+        wraps += generation < (previous >> 7) ? 1 : 0;
+
+        Sound::Pcm::Stop(handle);
+        CHECK(!Sound::Voice::IsActive(handle));
+        previous = handle;
+    }
+
+    CHECK_EQ(wraps, 2);
+
+    // Generation outlives the sound, so a handle from before a reload does not match the new sound
+    int16_t old = Sound::Pcm::Play(sounds[0], PlayMode::ForwardLoop);
+    Sound::Pcm::Unload(-1);
+    CHECK(!Sound::Voice::IsActive(old));
+    CHECK_EQ(Sound::Pcm::LoadSound("CAT.SND", sounds, CAT_COUNT), CAT_COUNT - 1);
+    int16_t fresh = Sound::Pcm::Play(sounds[0], PlayMode::ForwardLoop);
+    CHECK(fresh != old);
+    CHECK(!Sound::Voice::IsActive(old));
+    CHECK(Sound::Voice::IsActive(fresh));
+
+    Sound::Pcm::Unload(-1);
+    Host::Vblank();
+}
+
+TEST(LoadPcm)
+{
+    HostAccess::Boot();
+
+    int16_t sound = Sound::Pcm::Load16("BUMP16.PCM", 15360);
+    std::vector<uint8_t> source = ReadCdFile("BUMP16.PCM");
+
+    CHECK_EQ(sound, 0);
+    // Size is padded to 4 bytes, the padding plays too
+    CHECK_EQ(HostAccess::SampleBytes(sound), (source.size() + 3) & ~3);
+    CHECK(std::memcmp(HostAccess::SampleData(sound), source.data(), source.size()) == 0);
+    CHECK_EQ(Sound::Pcm::Load8("MISSING.PCM"), -4);
+    CHECK_EQ(HostAccess::SlotCount(), 1);
+    CHECK_EQ(Host::openHandles, 0);
+    CheckBlocks();
+}
+
+TEST(LoadSoundVersion2)
+{
+    HostAccess::Boot();
+
+    int16_t sounds[HostAccess::CTRL_MAX];
+    CHECK_EQ(Sound::Pcm::LoadSound("CAT.SND", sounds, HostAccess::CTRL_MAX), CAT_COUNT - 1);
+    CHECK_EQ(HostAccess::SlotCount(), CAT_COUNT);
+    CHECK_EQ(Sound::SoundRam::GetUsedSpace(), CatSoundRam());
+    CheckCatSamples(sounds);
+    CheckBlocks();
+
+    // Selected entries come in the order asked for
+    Sound::Pcm::Unload(-1);
+    const int16_t indices[] = { 7, 0 };
+    int16_t picked[2];
+    CHECK_EQ(Sound::Pcm::LoadSound("CAT.SND", picked, indices, 2), 2);
+    CHECK_EQ(HostAccess::SampleBytes(picked[0]), ReadSfx(CAT_FILES[7]).size());
+    CHECK_EQ(HostAccess::SampleBytes(picked[1]), ReadSfx(CAT_FILES[0]).size());
+
+    int16_t byName = Sound::Pcm::LoadSoundByName("CAT.SND", "MEOW9.PCM");
+    CHECK(byName >= 0);
+    CHECK_EQ(HostAccess::SampleBytes(byName), ReadSfx("MEOW9.PCM").size());
+    CHECK_EQ(Sound::Pcm::LoadSoundByName("CAT.SND", "NOPE.PCM"), -5);
+    CHECK_EQ(Host::openHandles, 0);
+}
+
+TEST(LoadBankMatchesManifest)
+{
+    HostAccess::Boot();
+
+    int16_t sounds[CAT_COUNT];
+    CHECK_EQ(Sound::Pcm::LoadBank(Banks::CAT_SND::Manifest, sounds), CAT_COUNT);
+    CHECK_EQ(Sound::SoundRam::GetUsedSpace(), Banks::CAT_SND::SoundRamSize);
+    CheckCatSamples(sounds);
+
+    for (int16_t i = 0; i < CAT_COUNT; i++)
+    {
+        CHECK_EQ(HostAccess::Shadow(sounds[i]).playSize, Banks::CAT_SND::Samples[i].playSize);
+    }
+
+    CheckBlocks();
+}
+
+TEST(LoadBankSharesSamples)
+{
+    HostAccess::Boot();
+
+    int16_t cat[CAT_COUNT];
+    CHECK_EQ(Sound::Pcm::LoadBank(Banks::CAT_SND::Manifest, cat), CAT_COUNT);
+    int32_t used = Sound::SoundRam::GetUsedSpace();
+
+    uint32_t uploaded = 0;
+    Host::onDmaCopy = [&uploaded](const void*, void* destination, uint32_t size) {
+        if (destination >= (void*)Host::SoundRam() && destination < (void*)(Host::SoundRam() + HostAccess::WORK_END)) uploaded += size;
+    };
+
+    // ANOTHER.SND only has samples CAT.SND already loaded, it gets slots of its own and no data
+    int16_t another[Banks::ANOTHER_SND::Count];
+    CHECK_EQ(Sound::Pcm::LoadBank(Banks::ANOTHER_SND::Manifest, another), Banks::ANOTHER_SND::Count);
+    Host::onDmaCopy = nullptr;
+
+    CHECK_EQ(HostAccess::SlotCount(), CAT_COUNT + Banks::ANOTHER_SND::Count);
+    CHECK(another[Banks::ANOTHER_SND::MEOW1] != cat[Banks::CAT_SND::MEOW1]);
+    CHECK_EQ(HostAccess::SampleAddress(another[Banks::ANOTHER_SND::MEOW1]), HostAccess::SampleAddress(cat[Banks::CAT_SND::MEOW1]));
+    CHECK_EQ(HostAccess::SampleAddress(another[Banks::ANOTHER_SND::MEOW2]), HostAccess::SampleAddress(cat[Banks::CAT_SND::MEOW2]));
+    CHECK_EQ(Sound::SoundRam::GetUsedSpace(), used);
+    CHECK_EQ(uploaded, 0);
+
+    Sound::LoadProfile profile = Sound::Stats::GetLoad(0);
+    CHECK_EQ(profile.bytesUploaded, 0);
+    CHECK_EQ(profile.bytesShared, ReadSfx("MEOW1.PCM").size() + ReadSfx("MEOW2.PCM").size());
+
+    // Freeing CAT.SND keeps the data ANOTHER.SND still plays
+    for (int16_t i = 0; i < CAT_COUNT; i++)
+    {
+        CHECK(Sound::Pcm::Free(cat[i]));
+    }
+
+    CHECK_EQ(Sound::SoundRam::GetUsedSpace(), CatSoundRam(1) + (int32_t)((ReadSfx("MEOW2.PCM").size() + 3) & ~3));
+    CheckBlocks();
+
+    const char* files[] = { "MEOW1.PCM", "MEOW2.PCM" };
+
+    for (int16_t i = 0; i < Banks::ANOTHER_SND::Count; i++)
+    {
+        std::vector<uint8_t> source = ReadSfx(files[i]);
+        CHECK_EQ(HostAccess::SampleBytes(another[i]), source.size());
+        CHECK(std::memcmp(HostAccess::SampleData(another[i]), source.data(), source.size()) == 0);
+    }
+
+    // The last user takes the data with it
+    CHECK(Sound::Pcm::Free(another[Banks::ANOTHER_SND::MEOW1]));
+    CHECK(Sound::Pcm::Free(another[Banks::ANOTHER_SND::MEOW2]));
+    CHECK_EQ(Sound::SoundRam::GetUsedSpace(), 0);
+    CHECK_EQ(HostAccess::BlockCount(), 0);
+}
+
+TEST(SoundBankStaysResident)
+{
+    HostAccess::Boot();
+
+    Sound::SoundBank first;
+    CHECK_EQ(first.Load(Banks::CAT_SND::Manifest), CAT_COUNT);
+    CHECK_EQ(Sound::SoundBank::GetReferences(Banks::CAT_SND::Manifest), 1);
+
+    int16_t sounds[CAT_COUNT];
+
+    for (int16_t i = 0; i < CAT_COUNT; i++)
+    {
+        sounds[i] = first[i];
+    }
+
+    CheckCatSamples(sounds);
+
+    // A resident bank is not read again, a blank file on the disc would fail otherwise
+    Host::AddFile("CAT.SND", {});
+
+    Sound::SoundBank second;
+    CHECK_EQ(second.Load(Banks::CAT_SND::Manifest), CAT_COUNT);
+    CHECK_EQ(Sound::SoundBank::GetReferences(Banks::CAT_SND::Manifest), 2);
+    CHECK_EQ(HostAccess::SlotCount(), CAT_COUNT);
+
+    for (int16_t i = 0; i < CAT_COUNT; i++)
+    {
+        CHECK_EQ(second[i], sounds[i]);
+    }
+
+    // Releasing every handle keeps the bank until its space is needed
+    first.Release();
+    second.Release();
+    CHECK(!first.IsLoaded());
+    CHECK(Sound::SoundBank::IsResident(Banks::CAT_SND::Manifest));
+    CHECK_EQ(Sound::SoundBank::GetReferences(Banks::CAT_SND::Manifest), 0);
+    CHECK_EQ(HostAccess::SlotCount(), CAT_COUNT);
+
+    CHECK_EQ(first.Load(Banks::CAT_SND::Manifest), CAT_COUNT);
+    CHECK_EQ(first[0], sounds[0]);
+    CheckCatSamples(sounds);
+    first.Release();
+
+    CHECK_EQ(Sound::SoundBank::EvictUnused(), 1);
+    CHECK(!Sound::SoundBank::IsResident(Banks::CAT_SND::Manifest));
+    CHECK_EQ(Sound::SoundBank::GetReferences(Banks::CAT_SND::Manifest), -1);
+    CHECK(first.Load(Banks::CAT_SND::Manifest) < 0);
+    CHECK(!first.IsLoaded());
+    CheckBlocks();
+}
+
+TEST(SoundBankEvictsLeastRecentlyUsed)
+{
+    HostAccess::Boot();
+
+    // Copies of CAT.SND under other names are banks of their own
+    static constexpr BankManifest cat2 = { "CAT2.SND", Banks::CAT_SND::Samples, Banks::CAT_SND::Count, Banks::CAT_SND::SoundRamSize };
+    static constexpr BankManifest cat3 = { "CAT3.SND", Banks::CAT_SND::Samples, Banks::CAT_SND::Count, Banks::CAT_SND::SoundRamSize };
+    Host::AddFile("CAT2.SND", ReadCdFile("CAT.SND"));
+    Host::AddFile("CAT3.SND", ReadCdFile("CAT.SND"));
+
+    // Leave control slots for two banks and a bit, so a third one has to evict
+    while (HostAccess::SlotCount() < HostAccess::CTRL_MAX - (CAT_COUNT * 2) - (CAT_COUNT / 2))
+    {
+        HostAccess::RegisterPcm(HostAccess::AllocateSoundRam(4), 4, BitDepth::PCM8, 15360);
+    }
+
+    {
+        Sound::SoundBank cat;
+        Sound::SoundBank other;
+        CHECK_EQ(cat.Load(Banks::CAT_SND::Manifest), CAT_COUNT);
+        CHECK_EQ(other.Load(cat2), CAT_COUNT);
+        other.Release();
+        cat.Release();
+    }
+
+    // CAT2.SND was released first, so it goes
+    Sound::SoundBank bank;
+    CHECK_EQ(bank.Load(cat3), CAT_COUNT);
+    CHECK(Sound::SoundBank::IsResident(Banks::CAT_SND::Manifest));
+    CHECK(!Sound::SoundBank::IsResident(cat2));
+    bank.Release();
+
+    // Using CAT.SND again makes CAT3.SND the oldest
+    CHECK_EQ(bank.Load(Banks::CAT_SND::Manifest), CAT_COUNT);
+    bank.Release();
+    CHECK_EQ(bank.Load(cat2), CAT_COUNT);
+    CHECK(Sound::SoundBank::IsResident(Banks::CAT_SND::Manifest));
+    CHECK(!Sound::SoundBank::IsResident(cat3));
+
+    int16_t sounds[CAT_COUNT];
+
+    for (int16_t i = 0; i < CAT_COUNT; i++)
+    {
+        sounds[i] = bank[i];
+    }
+
+    CheckCatSamples(sounds);
+
+    // A held bank is never evicted
+    Sound::SoundBank held;
+    CHECK_EQ(held.Load(Banks::CAT_SND::Manifest), CAT_COUNT);
+    CHECK_EQ(Sound::SoundBank().Load(cat3), -2);
+    CHECK(Sound::SoundBank::IsResident(cat2));
+    CHECK(Sound::SoundBank::IsResident(Banks::CAT_SND::Manifest));
+
+    held.Release();
+    bank.Release();
+    CHECK_EQ(Sound::SoundBank::EvictUnused(), 2);
+    CheckBlocks();
+}
+
+TEST(BadSoundFiles)
+{
+    HostAccess::Boot();
+
+    std::vector<uint8_t> file = ReadCdFile("CAT.SND");
+    int16_t sounds[HostAccess::CTRL_MAX];
+
+    CHECK_EQ(Sound::Pcm::LoadSound("MISSING.SND", sounds, HostAccess::CTRL_MAX), -1);
+
+    // Header only, the entries point past the end of the file
+    Host::AddFile("SHORT.SND", std::vector<uint8_t>(file.begin(), file.begin() + 64));
+    CHECK_EQ(Sound::Pcm::LoadSound("SHORT.SND", sounds, HostAccess::CTRL_MAX), -4);
+
+    // Payload cut in the middle of the last entry
+    Host::AddFile("CUT.SND", std::vector<uint8_t>(file.begin(), file.end() - 100));
+    CHECK_EQ(Sound::Pcm::LoadSound("CUT.SND", sounds, HostAccess::CTRL_MAX), -4);
+
+    // Table of contents no longer matches the manifest
+    std::vector<uint8_t> changed = file;
+    changed[20] ^= 0xFF; // name hash of the first entry, right behind the 20 byte header
+    Host::AddFile("CAT.SND", changed);
+    CHECK_EQ(Sound::Pcm::LoadBank(Banks::CAT_SND::Manifest, sounds), -4);
+
+    // Failed loads leave nothing behind
+    CHECK_EQ(HostAccess::SlotCount(), 0);
+    CHECK_EQ(HostAccess::BlockCount(), 0);
+    CHECK_EQ(Host::openHandles, 0);
+}
+
+TEST(UnloadFreeAndCompact)
+{
+    HostAccess::Boot();
+
+    int16_t sounds[HostAccess::CTRL_MAX];
+    Sound::Pcm::LoadSound("CAT.SND", sounds, HostAccess::CTRL_MAX);
+
+    Sound::Pcm::Unload(3);
+    CHECK_EQ(HostAccess::SlotCount(), 4);
+    CHECK_EQ(HostAccess::BlockCount(), 4);
+    CHECK_EQ(Sound::SoundRam::GetUsedSpace(), CatSoundRam(4));
+    CHECK_EQ(Sound::SoundRam::GetFragmentation(), 0);
+    CheckBlocks();
+
+    // Freeing a slot in the middle leaves a gap, its slot is given out again first
+    uint32_t gap = HostAccess::SampleAddress(1);
+    CHECK(Sound::Pcm::Free(1));
+    CHECK(!Sound::Pcm::Free(1));
+    CHECK_EQ(HostAccess::SlotCount(), 4);
+    CHECK_EQ(HostAccess::BlockCount(), 3);
+    CHECK(Sound::SoundRam::GetFragmentation() > 0);
+
+    // Best fit puts a sample of the same size back into the gap
+    uint32_t address = HostAccess::AllocateSoundRam((int32_t)ReadSfx(CAT_FILES[1]).size());
+    CHECK_EQ(address, gap);
+    CHECK_EQ(HostAccess::RegisterPcm(address, 100, BitDepth::PCM8, 15360), 1);
+    CHECK(Sound::Pcm::Free(1));
+
+    // Compact closes the gap and moves the data with the samples, the driver has stopped them before
+    Sound::Pcm::Play(2);
+    Sound::Pcm::Play(3);
+    Host::Vblank();
+    CHECK(HostAccess::DriverTable()[2].sh2Permit != 0);
+
+    int32_t movedWhilePlaying = 0;
+    Host::onDmaCopy = [&movedWhilePlaying](const void*, void*, uint32_t) {
+        if (Host::inVblank) return;
+        movedWhilePlaying += HostAccess::DriverTable()[2].sh2Permit + HostAccess::DriverTable()[3].sh2Permit;
+    };
+
+    CHECK_EQ(Sound::SoundRam::Compact(), 2);
+    Host::onDmaCopy = nullptr;
+    CHECK_EQ(movedWhilePlaying, 0);
+    CHECK_EQ(HostAccess::DriverTable()[2].hiAddrBits, HostAccess::Shadow(2).hiAddrBits);
+    CHECK_EQ(HostAccess::DriverTable()[2].loAddrBits, HostAccess::Shadow(2).loAddrBits);
+    CHECK_EQ(Sound::SoundRam::GetFragmentation(), 0);
+    CHECK_EQ(Sound::SoundRam::GetLargestFreeBlock(), Sound::SoundRam::GetFreeSpace());
+
+    for (int16_t i : { 0, 2, 3 })
+    {
+        std::vector<uint8_t> source = ReadSfx(CAT_FILES[i]);
+        CHECK(std::memcmp(HostAccess::SampleData(i), source.data(), source.size()) == 0);
+    }
+
+    CheckBlocks();
+
+    // Nothing fits past the end of the work area, and nothing is taken by trying
+    CHECK_EQ(HostAccess::AllocateSoundRam(Sound::SoundRam::GetSize()), 0u);
+    Sound::Pcm::Unload(-1);
+    CHECK_EQ(HostAccess::SlotCount(), 0);
+    CHECK_EQ(HostAccess::BlockCount(), 0);
+    CHECK_EQ(Sound::SoundRam::GetUsedSpace(), 0);
+}
+
+TEST(LoadSoundOutOfSoundRam)
+{
+    HostAccess::Boot();
+
+    // One word short of fitting the bank, the load fails before anything is taken
+    int16_t sounds[CAT_COUNT];
+    uint32_t filler = HostAccess::AllocateSoundRam(Sound::SoundRam::GetSize() - CatSoundRam() + 4);
+    CHECK(filler != 0);
+    CHECK_EQ(Sound::Pcm::LoadSound("CAT.SND", sounds, CAT_COUNT), -3);
+    CHECK_EQ(HostAccess::SlotCount(), 0);
+    CHECK_EQ(HostAccess::BlockCount(), 1);
+
+    int16_t request = Sound::Pcm::LoadSoundAsync("CAT.SND", sounds, CAT_COUNT);
+
+    for (int32_t frame = 0; frame < 10000 && Sound::Loader::GetStatus(request) == LoadStatus::Pending; frame++)
+    {
+        Sound::Loader::Update();
+        Host::Vblank();
+    }
+
+    CHECK(Sound::Loader::GetStatus(request) == LoadStatus::Failed);
+    CHECK_EQ(Sound::Loader::GetResult(request), -3);
+    Sound::Loader::Release(request);
+    CHECK_EQ(HostAccess::BlockCount(), 1);
+
+    // Exactly the space left is enough
+    HostAccess::ReleaseSoundRam(filler);
+    filler = HostAccess::AllocateSoundRam(Sound::SoundRam::GetSize() - CatSoundRam());
+    CHECK(filler != 0);
+    CHECK_EQ(Sound::Pcm::LoadSound("CAT.SND", sounds, CAT_COUNT), CAT_COUNT - 1);
+    CHECK_EQ(Sound::SoundRam::GetFreeSpace(), 0);
+    Sound::Pcm::Unload(-1);
+    HostAccess::ReleaseSoundRam(filler);
+    CHECK_EQ(HostAccess::BlockCount(), 0);
+}
+
+TEST(AsyncLoadMatchesBlocking)
+{
+    HostAccess::Boot();
+    Host::readLatency = 3;
+
+    int16_t sounds[CAT_COUNT];
+    int16_t request = Sound::Pcm::LoadBankAsync(Banks::CAT_SND::Manifest, sounds);
+    CHECK(request >= 0);
+
+    int32_t frames = 0;
+
+    while (Sound::Loader::GetStatus(request) == LoadStatus::Pending && frames < 10000)
+    {
+        Sound::Loader::Update(2048);
+        Host::Vblank();
+        frames++;
+    }
+
+    CHECK(Sound::Loader::GetStatus(request) == LoadStatus::Ready);
+    CHECK_EQ(Sound::Loader::GetResult(request), CAT_COUNT - 1);
+    CHECK(frames > 1);
+    Sound::Loader::Release(request);
+
+    CheckCatSamples(sounds);
+    CHECK_EQ(Sound::SoundRam::GetUsedSpace(), Banks::CAT_SND::SoundRamSize);
+    CHECK_EQ(Host::openHandles, 0);
+    CheckBlocks();
+}
+
+TEST(AsyncLoadRegistersCompleteSamples)
+{
+    HostAccess::Boot();
+    Host::readLatency = 3;
+
+    // Entries only get a control slot once all of their data is in sound RAM
+    int16_t sounds[CAT_COUNT];
+    std::fill(sounds, sounds + CAT_COUNT, (int16_t)-1);
+    int16_t request = Sound::Pcm::LoadSoundAsync("CAT.SND", sounds, CAT_COUNT);
+    CHECK(request >= 0);
+
+    for (int32_t frame = 0; frame < 10000 && Sound::Loader::GetStatus(request) == LoadStatus::Pending; frame++)
+    {
+        Sound::Loader::Update(512);
+        Host::Vblank();
+        int16_t registered = 0;
+
+        for (int16_t i = 0; i < CAT_COUNT; i++)
+        {
+            if (sounds[i] < 0) continue;
+
+            std::vector<uint8_t> source = ReadSfx(CAT_FILES[i]);
+            CHECK(std::memcmp(HostAccess::SampleData(sounds[i]), source.data(), source.size()) == 0);
+            registered++;
+        }
+
+        CHECK_EQ(HostAccess::SlotCount(), registered);
+    }
+
+    CHECK(Sound::Loader::GetStatus(request) == LoadStatus::Ready);
+    Sound::Loader::Release(request);
+    CheckCatSamples(sounds);
+    Sound::Pcm::Unload(-1);
+
+    // Blocking sound file loads share the table of contents and decoder with the queue, so they finish it first
+    int16_t pcm8 = Sound::Pcm::LoadPcmAsync("GMOVR8.PCM", BitDepth::PCM8, 15360);
+    int16_t pcm16 = Sound::Pcm::LoadPcmAsync("BUMP16.PCM", BitDepth::PCM16, 15360);
+    Sound::Loader::Update(512);
+    CHECK(Sound::Loader::GetStatus(pcm8) == LoadStatus::Pending);
+    CHECK_EQ(HostAccess::SlotCount(), 0);
+    CHECK_EQ(Sound::Pcm::LoadSound("CAT.SND", sounds, CAT_COUNT), CAT_COUNT - 1);
+    CHECK(Sound::Loader::IsIdle());
+
+    CHECK(Sound::Loader::GetStatus(pcm8) == LoadStatus::Ready);
+    CHECK_EQ(Sound::Loader::GetResult(pcm8), 0);
+    CHECK(Sound::Loader::GetStatus(pcm16) == LoadStatus::Ready);
+    CHECK_EQ(Sound::Loader::GetResult(pcm16), 1);
+    std::vector<uint8_t> source8 = ReadCdFile("GMOVR8.PCM");
+    CHECK(std::memcmp(HostAccess::SampleData(0), source8.data(), source8.size()) == 0);
+    std::vector<uint8_t> source16 = ReadCdFile("BUMP16.PCM");
+    CHECK(std::memcmp(HostAccess::SampleData(1), source16.data(), source16.size()) == 0);
+    CheckCatSamples(sounds);
+    Sound::Loader::Release(pcm8);
+    Sound::Loader::Release(pcm16);
+
+    Sound::Pcm::Unload(-1);
+    CHECK_EQ(HostAccess::BlockCount(), 0);
+    CHECK_EQ(Host::openHandles, 0);
+}
+
+namespace
+{
+    /** @brief Fake driver playing one PCM stream ring, checks every sample it plays against the file
+     *
+     * The position advances by the sample rate over 59.94 frames per second, so bookkeeping that adds whole bytes per
+     * blank instead of reading the SCSP drifts against it. The SCSP monitor register reports the position in 4096
+     * sample units for the slot selected in MSLC, as on the Saturn.
+     */
+    struct StreamDriver
+    {
+        static constexpr uint32_t MONITOR = 0x100408;
+        static constexpr int8_t SCSP_SLOT = 5;
+
+        int16_t sound = -1;
+        int32_t sampleRate = 0;
+        int32_t bytesPerSample = 1;
+        bool looping = false;
+        std::vector<uint8_t> file;
+        bool running = false;
+        double position = 0;
+        int64_t played = 0;
+        int32_t mismatches = 0;
+
+        /** @brief Byte the stream has at an offset, the file padded to whole sectors and repeated when looping
+         */
+        uint8_t Expected(int64_t offset) const
+        {
+            int64_t padded = (int64_t)((file.size() + 2047) & ~(size_t)2047);
+            if (looping) offset %= padded;
+            return offset < (int64_t)file.size() ? file[offset] : 0;
+        }
+
+        void Frame()
+        {
+            HostAccess::CTRL& ctrl = HostAccess::DriverTable()[sound];
+            uint16_t& monitor = *reinterpret_cast<uint16_t*>(Host::SoundRam() + MONITOR);
+            ctrl.icsrTarget = SCSP_SLOT;
+
+            if (ctrl.sh2Permit == 0)
+            {
+                running = false;
+                return;
+            }
+
+            if (!running)
+            {
+                running = true;
+                position = 0;
+            }
+
+            const uint8_t* ring = Host::SoundRam() + (((uint32_t)ctrl.hiAddrBits << 16) | ctrl.loAddrBits);
+            int64_t ringSamples = ctrl.playSize;
+            double next = position + (sampleRate / 59.94);
+
+            for (int64_t sample = (int64_t)position; sample < (int64_t)next; sample++, played++)
+            {
+                for (int32_t byte = 0; byte < bytesPerSample; byte++)
+                {
+                    uint8_t actual = ring[((sample % ringSamples) * bytesPerSample) + byte];
+                    mismatches += actual != Expected((played * bytesPerSample) + byte) ? 1 : 0;
+                }
+            }
+
+            position = next;
+
+            if ((monitor >> 11) == SCSP_SLOT)
+            {
+                uint16_t call = (uint16_t)((((int64_t)position % ringSamples) >> 12) & 0xF);
+                monitor = (uint16_t)((monitor & ~0x0780) | (call << 7));
+            }
+        }
+    };
+}
+
+TEST(PcmStreamFollowsDriver)
+{
+    // At 44.1 kHz the ring would pass 0x10000 samples, the 16 bit play size and the play position both have to fit it
+    for (int32_t sampleRate : { 15360, 44100 })
+    {
+        HostAccess::Boot();
+        Host::readLatency = 3;
+
+        StreamDriver driver;
+        driver.sampleRate = sampleRate;
+        driver.bytesPerSample = 2;
+        driver.looping = true;
+        driver.file = ReadCdFile("BUMP16.PCM");
+        Host::onDriverFrame = [&driver]() { driver.Frame(); };
+
+        Stream stream;
+        driver.sound = stream.Open("BUMP16.PCM", BitDepth::PCM16, driver.sampleRate);
+        CHECK(driver.sound >= 0);
+        CHECK_EQ(HostAccess::Shadow(driver.sound).playSize * driver.bytesPerSample, stream.GetBufferSize());
+        stream.Loop(true);
+        stream.Play();
+
+        // A minute of playback, long enough for a per blank estimate to drift by more than the ring
+        for (int32_t frame = 0; frame < 3600; frame++)
+        {
+            Stream::UpdateAll();
+            Host::Vblank();
+        }
+
+        CHECK(stream.IsPlaying());
+        CHECK(driver.played > 3500 * (sampleRate / 60));
+        CHECK_EQ(driver.mismatches, 0);
+        CHECK_EQ(stream.GetUnderruns(), 0);
+        CHECK(stream.GetFillLevel() > 0);
+        CHECK_EQ(Host::gfsCallsInVblank, 0);
+
+        stream.Close();
+        Host::onDriverFrame = nullptr;
+        Host::Vblank();
+        CHECK_EQ(Host::openHandles, 0);
+        CHECK_EQ(HostAccess::BlockCount(), 0);
+    }
+}
+
+TEST(PcmStreamStopsAtEnd)
+{
+    HostAccess::Boot();
+    Host::readLatency = 3;
+
+    StreamDriver driver;
+    driver.sampleRate = 15360;
+    driver.file = ReadCdFile("GMOVR8.PCM");
+    Host::onDriverFrame = [&driver]() { driver.Frame(); };
+
+    Stream stream;
+    driver.sound = stream.Open("GMOVR8.PCM", BitDepth::PCM8, driver.sampleRate);
+    CHECK(driver.sound >= 0);
+    stream.Play();
+
+    int32_t frames = 0;
+
+    while ((stream.IsPlaying() || frames == 0) && frames < 1000)
+    {
+        Stream::UpdateAll();
+        Host::Vblank();
+        frames++;
+    }
+
+    // Whole file was played, then the silence behind it until the driver left the last segment
+    CHECK(!stream.IsPlaying());
+    CHECK(driver.played >= (int64_t)driver.file.size());
+    CHECK(frames < 1000);
+    CHECK_EQ(driver.mismatches, 0);
+    CHECK_EQ(stream.GetUnderruns(), 0);
+    CHECK_EQ(Host::gfsCallsInVblank, 0);
+
+    stream.Close();
+    Host::onDriverFrame = nullptr;
+    CHECK_EQ(Host::openHandles, 0);
+}
+
+TEST(AdxStreamRefillsFromMainLoop)
+{
+    HostAccess::Boot();
+    Host::readLatency = 3;
+
+    std::vector<uint8_t> file = ReadCdFile("NBGM.ADX");
+    int16_t sound = AdxStream::Open("NBGM.ADX");
+    CHECK(sound >= 0);
+
+    const uint8_t* buffer = HostAccess::SampleData(sound);
+    int32_t halfSize = AdxStream::GetBufferSize() / 2;
+
+    // First half holds the start of the data, everything after follows it in the file
+    auto found = std::search(file.begin(), file.end(), buffer, buffer + 64);
+    CHECK(found != file.end());
+    size_t offset = (size_t)(found - file.begin());
+    CHECK(std::memcmp(buffer + halfSize, file.data() + offset + halfSize, halfSize) == 0);
+    offset += 2 * (size_t)halfSize;
+
+    // Fake driver releases a half every 30 frames, the half has to be refilled before the next one is released
+    int32_t refills = 0;
+    int32_t half = 0;
+    AdxStream::Play(7);
+
+    for (int32_t frame = 1; frame <= 30 * 10; frame++)
+    {
+        AdxStream::Update();
+        Host::Vblank();
+
+        if (frame % 30 == 0)
+        {
+            CHECK_EQ(HostAccess::AdxBufferPass(half ^ 1), 0);
+
+            if (refills > 0)
+            {
+                // Half released last time was refilled with the data that follows in the file
+                CHECK(std::memcmp(buffer + ((half ^ 1) * halfSize), file.data() + offset, halfSize) == 0);
+                offset += halfSize;
+            }
+
+            HostAccess::AdxBufferPass(half) = 1;
+            half ^= 1;
+            refills++;
+        }
+    }
+
+    CHECK(AdxStream::IsPlaying());
+    CHECK_EQ(AdxStream::GetUnderruns(), 0);
+    CHECK_EQ(Host::gfsCallsInVblank, 0);
+
+    AdxStream::Close();
+    Host::Vblank();
+    CHECK_EQ(Host::openHandles, 0);
+    CHECK_EQ(HostAccess::BlockCount(), 0);
+}
+
+TEST(SlaveAdxStreamFollowsDriver)
+{
+    HostAccess::Boot();
+    Host::readLatency = 3;
+
+    std::vector<uint8_t> file = ReadCdFile("NBGM.ADX");
+    std::vector<int16_t> samples = HostAccess::DecodeAdx(file, 8192);
+
+    StreamDriver driver;
+    driver.sampleRate = (int32_t)((uint32_t)file[8] << 24 | (uint32_t)file[9] << 16 | (uint32_t)file[10] << 8 | file[11]);
+    driver.bytesPerSample = 2;
+    driver.file.resize(samples.size() * 2);
+    std::memcpy(driver.file.data(), samples.data(), driver.file.size());
+    Host::onDriverFrame = [&driver]() { driver.Frame(); };
+
+    SlaveAdxStream stream;
+    driver.sound = stream.Open("NBGM.ADX");
+    CHECK(driver.sound >= 0);
+    stream.Play();
+
+    // Ten seconds stay inside the decoded reference, far enough for a per blank estimate to drift
+    for (int32_t frame = 0; frame < 600; frame++)
+    {
+        SlaveAdxStream::UpdateAll();
+        Host::Vblank();
+    }
+
+    CHECK(stream.IsPlaying());
+    CHECK(driver.played > 590 * (driver.sampleRate / 60));
+    CHECK(driver.played < (int64_t)samples.size());
+    CHECK_EQ(driver.mismatches, 0);
+    CHECK_EQ(stream.GetUnderruns(), 0);
+    CHECK(stream.GetFillLevel() > 0);
+    CHECK_EQ(Host::gfsCallsInVblank, 0);
+
+    stream.Close();
+    Host::onDriverFrame = nullptr;
+    Host::Vblank();
+    CHECK_EQ(Host::openHandles, 0);
+    CHECK_EQ(HostAccess::BlockCount(), 0);
+}
+
+TEST(OpenFileBudget)
+{
+    HostAccess::Boot();
+    Host::maxOpenHandles = Sound::MAX_OPEN_FILES;
+
+    // Every stream the module can keep open at once
+    CHECK(AdxStream::Open("NBGM.ADX") >= 0);
+
+    Stream streams[Stream::MAX_STREAMS];
+    CHECK(streams[0].Open("BUMP16.PCM", BitDepth::PCM16) >= 0);
+    CHECK(streams[1].Open("GMOVR8.PCM", BitDepth::PCM8) >= 0);
+
+    SlaveAdxStream slaveStreams[SlaveAdxStream::MAX_STREAMS];
+
+    for (SlaveAdxStream& stream : slaveStreams)
+    {
+        CHECK(stream.Open("NBGM.ADX") >= 0);
+    }
+
+    // Queue loads next to them, then a blocking load once the queue is done
+    int16_t sounds[CAT_COUNT];
+    int16_t request = Sound::Pcm::LoadSoundAsync("CAT.SND", sounds, CAT_COUNT);
+
+    for (int32_t frame = 0; frame < 10000 && Sound::Loader::GetStatus(request) == LoadStatus::Pending; frame++)
+    {
+        Sound::Loader::Update();
+        Host::Vblank();
+    }
+
+    CHECK(Sound::Loader::GetStatus(request) == LoadStatus::Ready);
+    Sound::Loader::Release(request);
+
+    int16_t blockingSounds[CAT_COUNT];
+    CHECK_EQ(Sound::Pcm::LoadSound("CAT.SND", blockingSounds, CAT_COUNT), CAT_COUNT - 1);
+    CHECK(Host::peakOpenHandles <= Sound::MAX_OPEN_FILES);
+
+    for (SlaveAdxStream& stream : slaveStreams)
+    {
+        stream.Close();
+    }
+
+    streams[0].Close();
+    streams[1].Close();
+    AdxStream::Close();
+    Sound::Pcm::Unload(-1);
+    Host::Vblank();
+    CHECK_EQ(Host::openHandles, 0);
+    CHECK_EQ(HostAccess::BlockCount(), 0);
+}
+
+int main(int argc, char** argv)
+{
+    int32_t run = 0;
+
+    for (const TestCase& test : Tests())
+    {
+        bool selected = argc < 2;
+
+        for (int i = 1; i < argc; i++)
+        {
+            selected = selected || std::strcmp(argv[i], test.name) == 0;
+        }
+
+        if (!selected) continue;
+
+        int before = failures;
+        test.function();
+        std::printf("%s %s\n", failures == before ? "ok  " : "FAIL", test.name);
+        run++;
+    }
+
+    std::printf("%d tests, %d failed checks\n", run, failures);
+    return failures == 0 && run > 0 ? 0 : 1;
+}